@@ -0,0 +1,133 @@
+#include "BenchHarness.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+std::string flagValue(const std::string &arg, const std::string &flag) {
+  std::string prefix = "--" + flag + "=";
+  if (arg.compare(0, prefix.size(), prefix) == 0) {
+    return arg.substr(prefix.size());
+  }
+  return "";
+}
+} // namespace
+
+BenchHarness::BenchHarness(int argc, char **argv) : m_executable(argv[0]) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string value;
+    if (!(value = flagValue(arg, "benchmark_filter")).empty()) {
+      m_filter = value;
+    } else if (!(value = flagValue(arg, "benchmark_min_time")).empty()) {
+      m_minTime = std::stod(value);
+    } else if (!(value = flagValue(arg, "benchmark_out")).empty()) {
+      m_outPath = value;
+    } else if (!(value = flagValue(arg, "benchmark_format")).empty()) {
+      m_jsonToStdout = value == "json";
+    } else {
+      std::cerr << "unknown argument: " << arg << std::endl;
+    }
+  }
+  if (!m_jsonToStdout) {
+    std::printf("%-36s %15s %15s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)",
+                "Iterations");
+  }
+}
+
+bool BenchHarness::matches(const std::string &name) const {
+  return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void BenchHarness::add(const std::string &name, std::function<void()> setup,
+                       std::function<void()> run, uint64_t itemsPerIteration) {
+  if (!matches(name)) {
+    return;
+  }
+  setup();
+  // one untimed iteration warms caches and lets containers reach capacity
+  run();
+
+  uint64_t iterations = 0;
+  auto realStart = std::chrono::steady_clock::now();
+  std::clock_t cpuStart = std::clock();
+  double elapsed = 0.0;
+  do {
+    run();
+    iterations++;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            realStart)
+                  .count();
+  } while (elapsed < m_minTime);
+  double cpuElapsed = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+  BenchResult result;
+  result.name = name;
+  result.iterations = iterations;
+  result.realTimeNs = elapsed * 1e9 / iterations;
+  result.cpuTimeNs = cpuElapsed * 1e9 / iterations;
+  result.itemsPerSecond = itemsPerIteration * iterations / elapsed;
+  m_results.push_back(result);
+  if (!m_jsonToStdout) {
+    std::printf("%-36s %15.0f %15.0f %12llu\n", name.c_str(),
+                result.realTimeNs, result.cpuTimeNs,
+                (unsigned long long)iterations);
+    std::fflush(stdout);
+  }
+}
+
+int BenchHarness::finish() {
+  if (m_jsonToStdout) {
+    writeJson(std::cout);
+  }
+  if (!m_outPath.empty()) {
+    std::ofstream out(m_outPath);
+    if (!out) {
+      std::cerr << "failed to open " << m_outPath << std::endl;
+      return 1;
+    }
+    writeJson(out);
+  }
+  return 0;
+}
+
+void BenchHarness::writeJson(std::ostream &out) const {
+  char date[64];
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z",
+                std::localtime(&now));
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+#ifdef NDEBUG
+  const char *buildType = "release";
+#else
+  const char *buildType = "debug";
+#endif
+
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": \"" << date << "\",\n"
+      << "    \"host_name\": \"" << host << "\",\n"
+      << "    \"executable\": \"" << m_executable << "\",\n"
+      << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+      << "    \"library_build_type\": \"" << buildType << "\"\n"
+      << "  },\n  \"benchmarks\": [";
+  for (size_t i = 0; i < m_results.size(); i++) {
+    const BenchResult &r = m_results[i];
+    out << (i == 0 ? "" : ",") << "\n    {\n"
+        << "      \"name\": \"" << r.name << "\",\n"
+        << "      \"run_name\": \"" << r.name << "\",\n"
+        << "      \"run_type\": \"iteration\",\n"
+        << "      \"iterations\": " << r.iterations << ",\n"
+        << "      \"real_time\": " << r.realTimeNs << ",\n"
+        << "      \"cpu_time\": " << r.cpuTimeNs << ",\n"
+        << "      \"time_unit\": \"ns\",\n"
+        << "      \"items_per_second\": " << r.itemsPerSecond << "\n    }";
+  }
+  out << "\n  ]\n}\n";
+}
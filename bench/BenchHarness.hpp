@@ -0,0 +1,45 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Minimal stand-in for Google Benchmark. Flags and JSON output follow its
+// format so its compare.py tooling works on our results:
+//   --benchmark_filter=<substring>
+//   --benchmark_min_time=<seconds>
+//   --benchmark_out=<file.json>
+//   --benchmark_format=<console|json>
+struct BenchResult {
+  std::string name;
+  uint64_t iterations;
+  double realTimeNs;
+  double cpuTimeNs;
+  double itemsPerSecond;
+};
+
+class BenchHarness {
+public:
+  BenchHarness(int argc, char **argv);
+
+  // setup runs once and is not timed, run is timed over repeated iterations,
+  // itemsPerIteration feeds items_per_second
+  void add(const std::string &name, std::function<void()> setup,
+           std::function<void()> run, uint64_t itemsPerIteration);
+  bool matches(const std::string &name) const;
+  int finish();
+
+private:
+  std::string m_executable;
+  std::string m_filter;
+  std::string m_outPath;
+  bool m_jsonToStdout = false;
+  double m_minTime = 0.5;
+  std::vector<BenchResult> m_results;
+
+  void writeJson(std::ostream &out) const;
+};
+
+#endif
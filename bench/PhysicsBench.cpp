@@ -0,0 +1,225 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "physics/DefaultArena.hpp"
+#include "physics/PhysicsWorld.hpp"
+#include "physics/Rollback.hpp"
+
+namespace {
+const unsigned int BODY_COUNTS[] = {1000, 10000, 100000, 1000000};
+// share of the arena volume filled by spheres, kept fixed so contact density
+// is comparable across body counts
+const float VOLUME_FRACTION = 0.05f;
+const float DELTA_TIME = 1.0f / 60.0f;
+const unsigned int BOX_QUERIES = 256;
+// rollback budget: resimulating ROLLBACK_TICKS of a ROLLBACK_BODY_COUNT world
+// must fit in 2 ms
+const unsigned int ROLLBACK_BODY_COUNT = 5000;
+const unsigned int ROLLBACK_TICKS = 8;
+// debris burst spawned and despawned in one frame on top of a settled scene
+const unsigned int SPAWN_BURST = 10000;
+const unsigned int SPAWN_SCENE_BODY_COUNT = 1000;
+
+std::unique_ptr<PhysicsWorld> makeScenario(unsigned int bodyCount) {
+  auto world =
+      std::make_unique<PhysicsWorld>(DEFAULT_ARENA_MIN, DEFAULT_ARENA_MAX);
+  glm::vec3 extent = DEFAULT_ARENA_MAX - DEFAULT_ARENA_MIN;
+  float volume = extent.x * extent.y * extent.z;
+  float radius = std::cbrt(VOLUME_FRACTION * volume /
+                           (bodyCount * 4.0f / 3.0f * 3.14159265f));
+
+  // fixed seed, every run benchmarks the same scene
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::uniform_real_distribution<float> speed(-20.0f, 20.0f);
+  world->reserve(bodyCount);
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    glm::vec3 position = DEFAULT_ARENA_MIN +
+                         extent * glm::vec3(unit(rng), unit(rng), unit(rng));
+    world->addBody(position, glm::vec3(speed(rng), speed(rng), speed(rng)),
+                   radius);
+  }
+  // settle initial overlaps so pair and contact lists are representative
+  world->step(DELTA_TIME);
+  return world;
+}
+
+void addBenchmarks(BenchHarness &harness, unsigned int bodyCount) {
+  const std::string suffix = "/" + std::to_string(bodyCount);
+  // every benchmark starts from the same fresh scene, repeated integration
+  // alone would otherwise pile all bodies up against the walls
+  std::unique_ptr<PhysicsWorld> world;
+  auto setup = [&] { world = makeScenario(bodyCount); };
+
+  harness.add(
+      "integrate" + suffix, setup, [&] { world->integrate(DELTA_TIME); },
+      bodyCount);
+  harness.add(
+      "wall_reflection" + suffix, setup, [&] { world->reflectWalls(); },
+      bodyCount);
+
+  harness.add(
+      "bounds_update" + suffix, setup, [&] { world->updateBounds(); },
+      bodyCount);
+
+  std::vector<Aabb> bounds;
+  harness.add(
+      "broadphase_build" + suffix,
+      [&] {
+        setup();
+        bounds = world->getBodyBounds();
+      },
+      [&] {
+        // fresh grid, includes allocating its storage
+        UniformGrid grid(DEFAULT_ARENA_MIN, DEFAULT_ARENA_MAX);
+        grid.build(bounds, world->getRadius(0));
+      },
+      bodyCount);
+  harness.add(
+      "broadphase_update" + suffix, setup, [&] { world->updateBroadphase(); },
+      bodyCount);
+
+  std::vector<glm::vec3> queryCenters;
+  std::vector<unsigned int> queryResult;
+  harness.add(
+      "broadphase_query" + suffix,
+      [&] {
+        setup();
+        std::mt19937 rng(99);
+        std::uniform_int_distribution<unsigned int> body(0, bodyCount - 1);
+        queryCenters.clear();
+        for (unsigned int i = 0; i < BOX_QUERIES; i++) {
+          queryCenters.push_back(world->getPosition(body(rng)));
+        }
+      },
+      [&] {
+        const glm::vec3 halfSize(world->getBroadphase().getCellSize());
+        for (const glm::vec3 &center : queryCenters) {
+          queryResult.clear();
+          world->getBroadphase().queryBox(center - halfSize, center + halfSize,
+                                          queryResult);
+        }
+      },
+      BOX_QUERIES);
+  harness.add(
+      "broadphase_pairs" + suffix, setup, [&] { world->findPairs(); },
+      bodyCount);
+  harness.add(
+      "narrowphase" + suffix, setup, [&] { world->narrowphase(); },
+      bodyCount);
+  harness.add(
+      "state_hash" + suffix, setup, [&] { world->computeStateHash(); },
+      bodyCount);
+  WorldSnapshot snapshot;
+  WorldSnapshot previousSnapshot;
+  std::vector<unsigned char> delta;
+  harness.add(
+      "snapshot_save" + suffix, setup, [&] { world->saveSnapshot(snapshot); },
+      bodyCount);
+  harness.add(
+      "snapshot_restore" + suffix,
+      [&] {
+        setup();
+        world->saveSnapshot(snapshot);
+      },
+      [&] { world->restoreSnapshot(snapshot); }, bodyCount);
+  // two snapshots one step apart
+  auto deltaSetup = [&] {
+    setup();
+    world->saveSnapshot(previousSnapshot);
+    world->step(DELTA_TIME);
+    world->saveSnapshot(snapshot);
+  };
+  harness.add(
+      "snapshot_delta_encode" + suffix, deltaSetup,
+      [&] { SnapshotDelta::encode(previousSnapshot, snapshot, delta); },
+      bodyCount);
+  WorldSnapshot decoded;
+  harness.add(
+      "snapshot_delta_decode" + suffix,
+      [&] {
+        deltaSetup();
+        SnapshotDelta::encode(previousSnapshot, snapshot, delta);
+      },
+      [&] { SnapshotDelta::decode(previousSnapshot, delta, decoded); },
+      bodyCount);
+  harness.add(
+      "full_step" + suffix, setup, [&] { world->step(DELTA_TIME); },
+      bodyCount);
+}
+
+void addRollbackBenchmark(BenchHarness &harness, unsigned int bodyCount) {
+  std::unique_ptr<PhysicsWorld> world;
+  std::unique_ptr<Rollback> rollback;
+  uint64_t rollbackTick = 0;
+  harness.add(
+      "rollback_resimulate_" + std::to_string(ROLLBACK_TICKS) + "/" +
+          std::to_string(bodyCount),
+      [&] {
+        world = makeScenario(bodyCount);
+        world->setDeterministic(true);
+        world->setFixedTimestep(DELTA_TIME);
+        rollback = std::make_unique<Rollback>(*world);
+        rollbackTick = world->getTick();
+        for (unsigned int i = 0; i < ROLLBACK_TICKS; i++) {
+          rollback->step();
+        }
+      },
+      [&] {
+        // every iteration redoes the same ticks from the same saved state
+        rollback->rollbackTo(rollbackTick);
+        rollback->resimulateTo(rollbackTick + ROLLBACK_TICKS);
+      },
+      (uint64_t)bodyCount * ROLLBACK_TICKS);
+}
+
+void addSpawnBenchmark(BenchHarness &harness, unsigned int burst) {
+  std::unique_ptr<PhysicsWorld> world;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> velocities;
+  std::vector<float> radii;
+  std::vector<BodyHandle> handles;
+  harness.add(
+      "spawn_despawn/" + std::to_string(burst),
+      [&] {
+        world = makeScenario(SPAWN_SCENE_BODY_COUNT);
+        world->reserve(SPAWN_SCENE_BODY_COUNT + burst);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const glm::vec3 extent = DEFAULT_ARENA_MAX - DEFAULT_ARENA_MIN;
+        positions.clear();
+        velocities.clear();
+        for (unsigned int i = 0; i < burst; i++) {
+          positions.push_back(DEFAULT_ARENA_MIN +
+                              extent *
+                                  glm::vec3(unit(rng), unit(rng), unit(rng)));
+          velocities.push_back(glm::vec3(0.0f, 5.0f * unit(rng), 0.0f));
+        }
+        radii.assign(burst, 0.05f);
+        handles.resize(burst);
+      },
+      [&] {
+        // the pool is sized up front, so neither half allocates
+        world->addBodies(positions.data(), velocities.data(), radii.data(),
+                         burst, handles.data());
+        for (BodyHandle handle : handles) {
+          world->removeBody(handle);
+        }
+      },
+      burst);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchHarness harness(argc, argv);
+  for (unsigned int bodyCount : BODY_COUNTS) {
+    addBenchmarks(harness, bodyCount);
+  }
+  addRollbackBenchmark(harness, ROLLBACK_BODY_COUNT);
+  addSpawnBenchmark(harness, SPAWN_BURST);
+  return harness.finish();
+}
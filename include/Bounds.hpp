@@ -0,0 +1,67 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box. A default box is empty (min above max), so
+// expanding it by the first point or box gives exactly that point or box.
+struct Aabb {
+  glm::vec3 min = glm::vec3(FLT_MAX);
+  glm::vec3 max = glm::vec3(-FLT_MAX);
+
+  Aabb() = default;
+  Aabb(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) {}
+
+  bool isEmpty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+  }
+  glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+  // half the size on each axis
+  glm::vec3 getExtent() const { return (max - min) * 0.5f; }
+
+  void expand(const glm::vec3 &point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void expand(const Aabb &other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+  }
+  bool overlaps(const Aabb &other) const {
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y &&
+           min.z <= other.max.z && other.min.z <= max.z;
+  }
+
+  // box around this box after an affine transform, from the transformed
+  // center and the extent projected on each world axis
+  Aabb transformed(const glm::mat4 &transform) const {
+    if (isEmpty()) {
+      return Aabb();
+    }
+    const glm::vec3 center =
+        glm::vec3(transform * glm::vec4(getCenter(), 1.0f));
+    const glm::mat3 absolute(glm::abs(glm::vec3(transform[0])),
+                             glm::abs(glm::vec3(transform[1])),
+                             glm::abs(glm::vec3(transform[2])));
+    const glm::vec3 extent = absolute * getExtent();
+    return Aabb(center - extent, center + extent);
+  }
+
+  // corner i has the max coordinate on the axes whose bit is set in i
+  glm::vec3 getCorner(unsigned int i) const {
+    return glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y,
+                     i & 4 ? max.z : min.z);
+  }
+};
+
+// Bounding sphere, empty while the radius is negative.
+struct BoundingSphere {
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = -1.0f;
+
+  bool isEmpty() const { return radius < 0.0f; }
+};
+
+#endif
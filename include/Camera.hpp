@@ -9,6 +9,8 @@ public:
 
   void updateScreenDimensions(const unsigned int width,
                               const unsigned int height);
+  unsigned int getScreenWidth() const;
+  unsigned int getScreenHeight() const;
 
   glm::mat4 getProjection() const;
   glm::mat4 getViewMatrix() const;
@@ -17,6 +19,9 @@ public:
   glm::vec3 getPosition() const;
   float getSpeed() const;
   float getFov() const;
+  float getNearPlane() const;
+  float getFarPlane() const;
+  float getAspectRatio() const;
   void setFov(float fov);
 
   void setLastMousePos(double xpos, double ypos);
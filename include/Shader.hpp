@@ -5,23 +5,37 @@
 
 #include <string>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <iostream>
 #include <glm/glm.hpp>
 
+#include "render/ProgramCache.hpp"
+
+// #define name to value, ordered so equal sets spell the same key
+using ShaderDefines = std::map<std::string, std::string>;
+
 class Shader {
 public:
   unsigned int ID;
 
-  Shader(const std::string vertexPath, const std::string fragmentPath) {
+  // defines are inserted after the #version line of every stage. The linked
+  // program is kept in ProgramCache, later runs with the same sources and
+  // driver load it instead of compiling.
+  Shader(const std::string vertexPath, const std::string fragmentPath,
+         const std::string geometryPath = "",
+         const ShaderDefines &defines = ShaderDefines()) {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
     std::string fragmentCode;
+    std::string geometryCode;
     std::ifstream vShaderFile;
     std::ifstream fShaderFile;
+    std::ifstream gShaderFile;
     // ensure ifstream objects can throw exceptions:
     vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try {
       // open files
       vShaderFile.open(vertexPath.c_str());
@@ -36,9 +50,26 @@ public:
       // convert stream into string
       vertexCode = vShaderStream.str();
       fragmentCode = fShaderStream.str();
+      // if geometry shader path is present, also load a geometry shader
+      if (!geometryPath.empty()) {
+        gShaderFile.open(geometryPath.c_str());
+        std::stringstream gShaderStream;
+        gShaderStream << gShaderFile.rdbuf();
+        gShaderFile.close();
+        geometryCode = gShaderStream.str();
+      }
     } catch (std::ifstream::failure e) {
       std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
     }
+    vertexCode = addDefines(vertexCode, defines);
+    fragmentCode = addDefines(fragmentCode, defines);
+    geometryCode = addDefines(geometryCode, defines);
+    const uint64_t binaryKey =
+        ProgramCache::makeKey(vertexCode, fragmentCode, geometryCode);
+    ID = ProgramCache::getDefault().load(binaryKey);
+    if (ID != 0) {
+      return;
+    }
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
 
@@ -71,10 +102,28 @@ public:
                 << infoLog << std::endl;
     };
 
+    // if geometry shader is given, compile geometry shader
+    unsigned int geometry = 0;
+    if (!geometryPath.empty()) {
+      const char *gShaderCode = geometryCode.c_str();
+      geometry = glCreateShader(GL_GEOMETRY_SHADER);
+      glShaderSource(geometry, 1, &gShaderCode, NULL);
+      glCompileShader(geometry);
+      glGetShaderiv(geometry, GL_COMPILE_STATUS, &success);
+      if (!success) {
+        glGetShaderInfoLog(geometry, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::GEOMETRY::COMPILATION_FAILED\n"
+                  << infoLog << std::endl;
+      };
+    }
+
     // shader Program
     ID = glCreateProgram();
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
+    if (!geometryPath.empty())
+      glAttachShader(ID, geometry);
     glLinkProgram(ID);
     // print linking errors if any
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
@@ -82,16 +131,42 @@ public:
       glGetProgramInfoLog(ID, 512, NULL, infoLog);
       std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
                 << infoLog << std::endl;
+    } else {
+      ProgramCache::getDefault().store(binaryKey, ID);
     }
 
     // delete the shaders as they're linked into our program now and no longer
     // necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+    if (!geometryPath.empty())
+      glDeleteShader(geometry);
   }
 
   void use() { glUseProgram(ID); }
 
+  static std::string addDefines(const std::string &source,
+                                const ShaderDefines &defines) {
+    if (defines.empty() || source.empty()) {
+      return source;
+    }
+    std::string lines;
+    for (const auto &[name, value] : defines) {
+      lines += "#define " + name + " " + value + "\n";
+    }
+    // #version must stay the first line
+    size_t version = source.find("#version");
+    if (version == std::string::npos) {
+      return lines + source;
+    }
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+      return source + "\n" + lines;
+    }
+    return source.substr(0, lineEnd + 1) + lines +
+           source.substr(lineEnd + 1);
+  }
+
   void setBool(const std::string &name, bool value) const {
     glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
   }
@@ -109,6 +184,17 @@ public:
                        &mat[0][0]);
   }
 
+  void setFloatArray(const std::string &name, const float *values,
+                     int count) const {
+    glUniform1fv(glGetUniformLocation(ID, name.c_str()), count, values);
+  }
+
+  void setMat4Array(const std::string &name, const glm::mat4 *mats,
+                    int count) const {
+    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), count, GL_FALSE,
+                       &mats[0][0][0]);
+  }
+
   void setVec3(const std::string &name, const glm::vec3 &vec) const {
     glUniform3f(glGetUniformLocation(ID, name.c_str()), vec.x, vec.y, vec.z);
   }
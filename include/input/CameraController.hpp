@@ -0,0 +1,31 @@
+#ifndef CAMERA_CONTROLLER_H
+#define CAMERA_CONTROLLER_H
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Camera.hpp"
+
+// Fly camera driven by input events rather than by polling GLFW, so recorded
+// input replays through exactly the same code.
+class CameraController {
+public:
+  CameraController(Camera &camera, const glm::vec3 boundsMin,
+                   const glm::vec3 boundsMax);
+
+  void setKeys(uint32_t keys);
+  uint32_t getKeys() const;
+  // moves the camera along the held keys
+  void update(float deltaTime);
+  void mouseMove(double xpos, double ypos);
+  void scroll(double yoffset);
+
+private:
+  Camera &m_camera;
+  glm::vec3 m_boundsMin;
+  glm::vec3 m_boundsMax;
+  uint32_t m_keys = 0;
+  float m_sensitivity = 0.04f;
+};
+
+#endif
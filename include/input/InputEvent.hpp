@@ -0,0 +1,47 @@
+#ifndef INPUT_EVENT_H
+#define INPUT_EVENT_H
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// movement keys held during a frame, as a bitmask
+#define MOVE_FORWARD (1u << 0)
+#define MOVE_BACKWARD (1u << 1)
+#define MOVE_LEFT (1u << 2)
+#define MOVE_RIGHT (1u << 3)
+#define MOVE_UP (1u << 4)
+#define MOVE_DOWN (1u << 5)
+
+enum class InputEventType : uint8_t {
+  // end of a frame: camera moved and world advanced by frameTime
+  Frame = 0,
+  // movement key mask changed
+  Keys = 1,
+  MouseMove = 2,
+  Scroll = 3,
+  // command: add a body to the world
+  Spawn = 4,
+};
+
+// Only the fields of the event's type are meaningful.
+struct InputEvent {
+  InputEventType type;
+  // microseconds since the recording started
+  uint64_t timeUs = 0;
+
+  float frameTime = 0.0f;
+  // world state hash after the frame, 0 outside deterministic mode
+  uint64_t stateHash = 0;
+
+  uint32_t keys = 0;
+
+  // cursor position for MouseMove, y is the offset for Scroll
+  double x = 0.0;
+  double y = 0.0;
+
+  glm::vec3 position = glm::vec3(0.0f);
+  glm::vec3 velocity = glm::vec3(0.0f);
+  float radius = 0.0f;
+};
+
+#endif
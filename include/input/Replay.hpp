@@ -0,0 +1,98 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Camera.hpp"
+#include "input/CameraController.hpp"
+#include "input/InputEvent.hpp"
+#include "physics/PhysicsWorld.hpp"
+
+#define REPLAY_MAGIC 0x4c505250u // "PRPL"
+#define REPLAY_VERSION 1u
+
+// Replay file layout: ReplayHeader, the initial WorldSnapshot bytes, then a
+// stream of events until end of file. Each event is a type byte, a varint
+// microsecond delta from the previous event and the type's payload.
+struct ReplayHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t deterministic;
+  float fixedTimestep;
+  glm::vec3 arenaMin;
+  glm::vec3 arenaMax;
+  glm::vec3 cameraBoundsMin;
+  glm::vec3 cameraBoundsMax;
+  uint32_t screenWidth;
+  uint32_t screenHeight;
+  glm::vec3 cameraPosition;
+  glm::vec3 cameraFront;
+  float cameraYaw;
+  float cameraPitch;
+  float cameraFov;
+  float cameraLastX;
+  float cameraLastY;
+  uint32_t cameraFirstMouse;
+  uint64_t snapshotSize;
+};
+
+// Streams input and command events to disk while the engine runs.
+class ReplayRecorder {
+public:
+  // writes the header and the world's current state
+  bool open(const std::string &path, const PhysicsWorld &world,
+            const Camera &camera, const glm::vec3 cameraBoundsMin,
+            const glm::vec3 cameraBoundsMax);
+  bool isOpen() const;
+  void record(InputEvent event);
+  void close();
+
+private:
+  std::ofstream m_file;
+  std::vector<unsigned char> m_buffer;
+  std::chrono::steady_clock::time_point m_start;
+  uint64_t m_lastTimeUs = 0;
+  unsigned int m_framesSinceFlush = 0;
+};
+
+// Re-runs a recording headless, as fast as the events can be applied.
+class ReplayPlayer {
+public:
+  bool open(const std::string &path);
+  // applies the next event, false at the end of the recording or on error
+  bool step();
+  // Plays to the end, returns false on a read error or a desync. A partially
+  // written trailing event is not an error.
+  bool run();
+
+  PhysicsWorld &getWorld();
+  Camera &getCamera();
+  unsigned int getFrameCount() const;
+  uint64_t getRecordedTimeUs() const;
+  // tick of the first frame whose hash differed from the recording
+  bool hasDesynced() const;
+  uint64_t getDesyncTick() const;
+
+private:
+  std::ifstream m_file;
+  ReplayHeader m_header;
+  std::unique_ptr<PhysicsWorld> m_world;
+  std::unique_ptr<Camera> m_camera;
+  std::unique_ptr<CameraController> m_controller;
+  uint64_t m_timeUs = 0;
+  unsigned int m_frames = 0;
+  bool m_desynced = false;
+  // an event failed to parse before the end of the file
+  bool m_readError = false;
+  uint64_t m_desyncTick = 0;
+
+  bool readEvent(InputEvent &event);
+};
+
+#endif
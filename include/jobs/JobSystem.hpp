@@ -0,0 +1,66 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// chunks handed out per thread of a loop, more balance uneven work better
+#define JOB_SYSTEM_CHUNKS_PER_THREAD 4
+
+// Fixed pool of worker threads for data parallel loops. parallelFor splits a
+// range into chunks that the workers and the calling thread take from a
+// shared counter, and returns once every chunk has run, so it slots into
+// frame code like a plain loop. Nothing is allocated per loop.
+//
+// One loop runs at a time, callers on other threads wait their turn. A loop
+// started from inside a job runs inline on that thread.
+class JobSystem {
+public:
+  using RangeJob = std::function<void(unsigned int begin, unsigned int end)>;
+
+  // workerCount threads besides the callers, 0 runs every loop inline
+  explicit JobSystem(unsigned int workerCount);
+  ~JobSystem();
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  // Runs job on disjoint chunks of [0, count) of at least minChunk items.
+  // A range that fits one chunk runs inline.
+  void parallelFor(unsigned int count, unsigned int minChunk,
+                   const RangeJob &job);
+  unsigned int getWorkerCount() const;
+
+  // shared pool with one worker per hardware thread besides the caller,
+  // started on first use
+  static JobSystem &getDefault();
+
+private:
+  std::vector<std::thread> m_workers;
+  // serializes loops from different callers
+  std::mutex m_loopMutex;
+
+  // guards the loop description, m_loop and m_activeWorkers
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  bool m_stopping = false;
+  // bumped per loop, workers join each loop at most once
+  uint64_t m_loop = 0;
+  // null once the current loop has finished
+  const RangeJob *m_job = nullptr;
+  unsigned int m_count = 0;
+  unsigned int m_chunkSize = 0;
+  unsigned int m_chunkCount = 0;
+  unsigned int m_activeWorkers = 0;
+  std::atomic<unsigned int> m_nextChunk{0};
+  std::atomic<unsigned int> m_pendingChunks{0};
+
+  void workerLoop(unsigned int index);
+  void runChunks(const RangeJob &job);
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// first block size, an arena grows to its peak after a frame that overflowed
+#define FRAME_ARENA_DEFAULT_BYTES (256 * 1024)
+
+// Linear allocator for data that dies at the end of a step or frame.
+// Allocation bumps a pointer, deallocation is a no-op and reset() frees
+// everything at once. A full block chains an overflow block; the next reset
+// replaces the chain with a single block sized to the frame's usage, so a
+// steady workload settles into one block and never touches the heap again.
+//
+// Use it through std::pmr containers (FrameVector) or plain allocate(). An
+// arena belongs to one thread; only the peak and capacity may be read from
+// others.
+class FrameArena : public std::pmr::memory_resource {
+public:
+  explicit FrameArena(size_t capacity = FRAME_ARENA_DEFAULT_BYTES);
+  ~FrameArena() override;
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // invalidates every allocation made since the last reset
+  void reset();
+
+  // position to rewind() to, for scratch that dies before the frame ends
+  struct Mark {
+    size_t block;
+    size_t offset;
+    size_t used;
+  };
+  Mark getMark() const;
+  void rewind(const Mark &mark);
+
+  // bytes handed out since the last reset, alignment padding included
+  size_t getUsed() const;
+  // highest usage of any frame up to the last reset or rewind, safe from any
+  // thread
+  size_t getPeak() const;
+  // size of the main block, safe from any thread
+  size_t getCapacity() const;
+  // frames that outgrew the main block
+  unsigned int getOverflowCount() const;
+
+  // the calling thread's own arena, its owner decides when to reset it
+  static FrameArena &forThread();
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override;
+
+private:
+  struct Block {
+    unsigned char *data;
+    size_t size;
+  };
+
+  // the first block is the main one, later ones live until the next reset
+  std::vector<Block> m_blocks;
+  size_t m_block = 0;
+  size_t m_offset = 0;
+  // usage of the blocks before m_block
+  size_t m_retired = 0;
+  // highest usage since the last reset, rewinds included
+  size_t m_framePeak = 0;
+  unsigned int m_overflowCount = 0;
+  std::atomic<size_t> m_peak{0};
+  std::atomic<size_t> m_capacity{0};
+
+  void addBlock(size_t size);
+  void releaseBlocks(size_t first);
+  void notePeak();
+};
+
+template <typename T> using FrameVector = std::pmr::vector<T>;
+
+// Rewinds an arena on scope exit, so a loader can take scratch from a
+// shared arena without waiting for its reset.
+class FrameArenaScope {
+public:
+  explicit FrameArenaScope(FrameArena &arena)
+      : m_arena(arena), m_mark(arena.getMark()) {}
+  ~FrameArenaScope() { m_arena.rewind(m_mark); }
+  FrameArenaScope(const FrameArenaScope &) = delete;
+  FrameArenaScope &operator=(const FrameArenaScope &) = delete;
+
+private:
+  FrameArena &m_arena;
+  FrameArena::Mark m_mark;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "model/SceneGraph.hpp"
+
+struct aiAnimation;
+
+// rate every clip is resampled to at import
+#define ANIMATION_SAMPLE_RATE 30.0f
+// floats per channel in a sample: translation, rotation quaternion xyzw and
+// scale
+#define ANIMATION_CHANNEL_FLOATS 10
+
+// Skeletal animation resampled at a fixed rate into one row of floats per
+// frame, every animated node's translation, rotation and scale side by side.
+// Sampling is then two row lookups and one lerp over contiguous floats,
+// which the compiler vectorizes, instead of a key search per channel.
+// Rotations in consecutive rows are kept in the same hemisphere, so the
+// lerped quaternion only needs normalizing.
+class AnimationClip {
+public:
+  // Resamples the animation's channels; channels whose node is not in nodes
+  // are dropped. False if nothing is left.
+  bool import(const aiAnimation &animation, const SceneGraph &nodes);
+
+  const std::string &getName() const;
+  // seconds, sample() wraps time around it
+  float getDuration() const;
+  unsigned int getChannelCount() const;
+  unsigned int getChannelNode(unsigned int channel) const;
+
+  // overwrites the local transform of every animated node in locals, which
+  // is indexed by scene graph node
+  void sample(float time, glm::mat4 *locals) const;
+
+private:
+  std::string m_name;
+  float m_duration = 0.0f;
+  unsigned int m_frameCount = 0;
+  std::vector<uint32_t> m_channelNodes;
+  // m_frameCount rows of getChannelCount() * ANIMATION_CHANNEL_FLOATS
+  std::vector<float> m_frames;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef GL_OBJECT_H
+#define GL_OBJECT_H
+#include <glad/glad.h>
+
+enum class GlObjectType {
+  Buffer,
+  VertexArray,
+  Texture,
+};
+
+unsigned int createGlObject(GlObjectType type);
+void deleteGlObject(GlObjectType type, unsigned int id);
+
+// Sole owner of one GL object name, deleted with the owner. Move-only, so a
+// copied mesh can never delete buffers another mesh still draws from. Needs a
+// current context wherever one is created or destroyed.
+template <GlObjectType Type> class GlObject {
+public:
+  GlObject() = default;
+  // takes ownership of a name created elsewhere
+  explicit GlObject(unsigned int id) : m_id(id) {}
+  ~GlObject() { reset(); }
+  GlObject(const GlObject &) = delete;
+  GlObject &operator=(const GlObject &) = delete;
+  GlObject(GlObject &&other) noexcept : m_id(other.release()) {}
+  GlObject &operator=(GlObject &&other) noexcept {
+    if (this != &other) {
+      reset();
+      m_id = other.release();
+    }
+    return *this;
+  }
+
+  static GlObject create() { return GlObject(createGlObject(Type)); }
+
+  unsigned int get() const { return m_id; }
+  // gives up ownership without deleting
+  unsigned int release() {
+    unsigned int id = m_id;
+    m_id = 0;
+    return id;
+  }
+  void reset() {
+    if (m_id != 0) {
+      deleteGlObject(Type, m_id);
+      m_id = 0;
+    }
+  }
+
+private:
+  unsigned int m_id = 0;
+};
+
+using GlBuffer = GlObject<GlObjectType::Buffer>;
+using GlVertexArray = GlObject<GlObjectType::VertexArray>;
+using GlTexture = GlObject<GlObjectType::Texture>;
+
+#endif
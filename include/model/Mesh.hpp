@@ -2,24 +2,70 @@
 #define MESH_H
 #include <vector>
 
+#include "Bounds.hpp"
 #include "Shader.hpp"
 #include "Texture.hpp"
 #include "Vertex.hpp"
+#include "model/GlObject.hpp"
+#include "model/MeshOptimizer.hpp"
 
+// per-instance vec4 of position and uniform scale, after the Vertex attributes
+#define MESH_INSTANCE_ATTRIBUTE 7
+
+// Owns its vertex array and buffers, so it is move-only. The CPU copies of
+// vertices and indices are only needed to build the GPU buffers and can be
+// released after the upload.
+//
+// The index buffer holds every detail level back to back, level 0 is the full
+// mesh. Without lods the whole index buffer is the only level.
+//
+// Bounds are taken from the uploaded vertices, so they stay valid after the
+// CPU copy is released.
 class Mesh {
 public:
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
   std::vector<Texture> textures;
+  std::vector<MeshLod> lods;
+  // in model space, of the bind pose for a skinned mesh
+  Aabb bounds;
+  BoundingSphere boundingSphere;
+  // some vertex has bone weights, its vertices are in the space the bone
+  // offsets expect rather than its node's
+  bool skinned = false;
 
+  // pass the vectors with std::move to avoid copying them
   Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-       std::vector<Texture> textures);
+       std::vector<Texture> textures, std::vector<MeshLod> lods = {});
+  // uploads from caller memory and keeps no CPU copy
+  Mesh(const Vertex *vertexData, size_t vertexCount,
+       const unsigned int *indexData, size_t indexCount,
+       std::vector<Texture> textures, std::vector<MeshLod> lods = {});
+  Mesh(const Mesh &) = delete;
+  Mesh &operator=(const Mesh &) = delete;
+  Mesh(Mesh &&) = default;
+  Mesh &operator=(Mesh &&) = default;
+
   void Draw();
   void Draw(Shader &Shader);
+  // draws instanceCount instances of a detail level, levels past the last
+  // draw the last
+  void DrawInstanced(Shader &shader, unsigned int lod,
+                     unsigned int instanceCount, unsigned int baseInstance);
+  // sources the instance attribute from buffer, one vec4 per instance
+  void setInstanceBuffer(unsigned int buffer);
+  // frees vertices and indices, drawing only needs the GPU copy
+  void releaseCpuData();
+  // replaces the GPU vertices, for CPU skinning; the count must not change
+  void updateVertices(const Vertex *vertexData, size_t vertexCount);
 
 private:
-  unsigned int VAO, VBO, EBO;
-  void setupMesh();
+  GlVertexArray VAO;
+  GlBuffer VBO, EBO;
+  void setupMesh(const Vertex *vertexData, size_t vertexCount,
+                 const unsigned int *indexData, size_t indexCount);
+  void computeBounds(const Vertex *vertexData, size_t vertexCount);
+  void bindTextures(Shader &shader);
 };
 
 #endif
@@ -0,0 +1,79 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+#include <cstddef>
+#include <vector>
+
+#include "memory/FrameArena.hpp"
+#include "model/Vertex.hpp"
+
+// post-transform cache entries assumed by the reorder and by computeAcmr
+#define MESH_OPTIMIZER_CACHE_SIZE 32
+// each detail level halves the triangles of the previous one until this few
+// are left or simplification stalls
+#define MESH_LOD_MIN_TRIANGLES 32
+#define MESH_LOD_MAX_LEVELS 8
+
+// Index range of one detail level. Every level indexes the same vertex
+// buffer, error is how far the level strays from the full mesh in model
+// units.
+struct MeshLod {
+  unsigned int indexOffset = 0;
+  unsigned int indexCount = 0;
+  float error = 0.0f;
+};
+
+struct MeshOptimizeStats {
+  size_t vertexCountBefore = 0;
+  size_t vertexCountAfter = 0;
+  size_t triangleCount = 0;
+  // vertex shader invocations per triangle in file order and after the reorder
+  float acmrBefore = 0.0f;
+  float acmrAfter = 0.0f;
+};
+
+// Merges bitwise identical vertices in place and rewrites the indices to the
+// survivors, returns the new vertex count. Unused fields of Vertex must be
+// zeroed or equal vertices will not match.
+size_t weldVertices(Vertex *vertices, size_t vertexCount,
+                    unsigned int *indices, size_t indexCount);
+
+// Reorders triangles so consecutive ones share vertices still in the
+// post-transform cache (Forsyth's linear speed vertex cache optimisation).
+void optimizeVertexCache(unsigned int *indices, size_t indexCount,
+                         size_t vertexCount);
+
+// Renumbers vertices in the order the indices first use them and moves them
+// to match, so fetches walk the vertex buffer forward. Unreferenced vertices
+// are dropped, returns the new vertex count.
+size_t optimizeVertexFetch(Vertex *vertices, size_t vertexCount,
+                           unsigned int *indices, size_t indexCount);
+
+// average cache misses per triangle of a FIFO cache, 0.5 is ideal for a
+// closed grid and 3 means no reuse at all
+float computeAcmr(const unsigned int *indices, size_t indexCount,
+                  size_t vertexCount,
+                  unsigned int cacheSize = MESH_OPTIMIZER_CACHE_SIZE);
+
+// Collapses edges in order of quadric error until at most targetIndexCount
+// indices are left or the next collapse would move the surface further than
+// maxError. Vertices only collapse onto other vertices, so the result indexes
+// the same vertex buffer. Attribute seams and open borders only collapse
+// along themselves. Writes up to indexCount indices to out and returns how
+// many, error receives the distance of the worst collapse taken.
+size_t simplifyMesh(const Vertex *vertices, size_t vertexCount,
+                    const unsigned int *indices, size_t indexCount,
+                    size_t targetIndexCount, float maxError,
+                    unsigned int *out, float *error = nullptr);
+
+// Appends coarser levels of the mesh in indices to its end, each reordered
+// for the vertex cache. lods receives the full mesh as level 0 followed by one
+// entry per level built.
+void buildLodChain(const Vertex *vertices, size_t vertexCount,
+                   FrameVector<unsigned int> &indices,
+                   std::vector<MeshLod> &lods);
+
+// welds, reorders for the vertex cache, then for fetch locality
+MeshOptimizeStats optimizeMesh(Vertex *vertices, size_t vertexCount,
+                               unsigned int *indices, size_t indexCount);
+
+#endif
@@ -6,33 +6,109 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "Bounds.hpp"
 #include "Shader.hpp"
+#include "model/GlObject.hpp"
 #include "model/Mesh.hpp"
+#include "model/AnimationClip.hpp"
+#include "model/MeshOptimizer.hpp"
+#include "model/SceneGraph.hpp"
+#include "model/Skeleton.hpp"
 
 unsigned int TextureFromFile(const char *path, const std::string &directory,
                              bool gamma = false);
 
+// Owns its meshes and the textures it loaded, so it is move-only. Meshes drop
+// their CPU vertex data after upload unless keepCpuData is set.
+//
+// The file's node hierarchy is kept as a SceneGraph and every mesh is drawn
+// with the world transform of the node that holds it, so parts of a model
+// can be moved through their nodes.
+//
+// Skinned meshes are drawn through a bone palette from the model's Skeleton:
+// the palette already holds the mesh's node, so "model" is only the
+// transform passed in. They show their bind pose unless the shader skins
+// them or skinOnCpu() has rewritten their vertices.
 class Model {
 public:
   Model();
-  Model(std::string const &path, bool gamma = false) : gammaCorrection(gamma) {
+  Model(std::string const &path, bool gamma = false, bool keepCpuData = false)
+      : gammaCorrection(gamma), keepCpuData(keepCpuData) {
     loadModel(path);
   }
+  Model(const Model &) = delete;
+  Model &operator=(const Model &) = delete;
+  Model(Model &&) = default;
+  Model &operator=(Model &&) = default;
+
   void Draw();
-  void Draw(Shader &shader);
+  // sets the "model" uniform of each mesh to transform times its node's
+  void Draw(Shader &shader, const glm::mat4 &transform = glm::mat4(1.0f));
+  // Every mesh at detail level lod, see Mesh::DrawInstanced. "model" is set
+  // to the mesh's node transform, the instance transform applies on top.
+  // A skinned shader finds instance i's palette at i * getBoneCount().
+  void DrawInstanced(Shader &shader, unsigned int lod,
+                     unsigned int instanceCount, unsigned int baseInstance);
+  void setInstanceBuffer(unsigned int buffer);
+  // error of each detail level in model units, the worst over the meshes
+  const std::vector<float> &getLodErrors() const;
+
+  // Union of the mesh bounds placed by their nodes, in model space. Covers
+  // the vertices as uploaded after the import post-processing.
+  const Aabb &getBounds() const { return bounds; }
+  const BoundingSphere &getBoundingSphere() const { return boundingSphere; }
+
+  SceneGraph &getSceneGraph() { return nodes; }
+  const SceneGraph &getSceneGraph() const { return nodes; }
+  // applies node transforms changed since the last call and refits the
+  // bounds, drawing does this too
+  void updateTransforms();
+
+  const Skeleton &getSkeleton() const { return skeleton; }
+  const std::vector<AnimationClip> &getAnimations() const {
+    return animations;
+  }
+  bool isSkinned() const;
+  // Poses the skinned meshes on the CPU with a palette from the skeleton,
+  // for drivers without shader storage in the vertex stage. Needs
+  // keepCpuData, false without it.
+  bool skinOnCpu(const glm::mat4 *palette);
+
+  // totals over all meshes of the import optimisation
+  const MeshOptimizeStats &getOptimizeStats() const { return optimizeStats; }
 
 private:
   // model data
   std::vector<Mesh> meshes;
+  // node holding each mesh, a mesh used by several nodes is loaded for each
+  std::vector<unsigned int> meshNodes;
+  SceneGraph nodes;
+  Skeleton skeleton;
+  std::vector<AnimationClip> animations;
   std::string directory;
   std::vector<Texture> textures_loaded;
-  bool gammaCorrection;
+  // deletes the GL textures of textures_loaded with the model
+  std::vector<GlTexture> textureObjects;
+  bool gammaCorrection = false;
+  bool keepCpuData = false;
+  MeshOptimizeStats optimizeStats;
+  std::vector<float> lodErrors;
+  Aabb bounds;
+  BoundingSphere boundingSphere;
 
   void loadModel(std::string const &path);
-  void processNode(aiNode *node, const aiScene *scene);
-  Mesh processMesh(aiMesh *mesh, const aiScene *scene);
-  std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type,
-                                            std::string typeName);
+  // adds the hierarchy below root to nodes, depth first, then its meshes
+  void processNode(aiNode *root, const aiScene *scene);
+  // builds the mesh in place at the end of meshes
+  void processMesh(aiMesh *mesh, const aiScene *scene);
+  // fills the bone fields of vertices with the mesh's strongest influences
+  void processBones(aiMesh *mesh, Vertex *vertices);
+  void addOptimizeStats(const MeshOptimizeStats &stats);
+  void computeBounds();
+  // appends the material's textures of a type to out
+  void loadMaterialTextures(aiMaterial *mat, aiTextureType type,
+                            const std::string &typeName,
+                            std::vector<Texture> &out);
 };
 
 #endif
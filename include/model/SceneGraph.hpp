@@ -0,0 +1,74 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#define SCENE_GRAPH_NO_NODE UINT32_MAX
+// subtrees up to this many nodes are updated by a single job, graphs with
+// fewer than two jobs' worth update on the calling thread
+#define SCENE_GRAPH_JOB_NODES 2048
+
+// Transform hierarchy stored flat in depth first order: every parent comes
+// before its children and a node's subtree is the range
+// [node, getSubtreeEnd(node)). Setting a local transform marks the node
+// dirty; update() recomputes the world transform of dirty nodes and their
+// descendants in one linear pass, a parent is always final before its
+// children read it, so there is no recursion.
+//
+// Large graphs split into independent subtrees updated in parallel on the
+// default JobSystem. Only the few nodes above those subtrees go first on the
+// calling thread.
+class SceneGraph {
+public:
+  // Appends a node and returns its index. The parent must be
+  // SCENE_GRAPH_NO_NODE or the last added node or one of its ancestors, so
+  // the depth first order holds; SCENE_GRAPH_NO_NODE on error.
+  unsigned int addNode(unsigned int parent, const glm::mat4 &local,
+                       const std::string &name = std::string());
+  void clear();
+
+  unsigned int getNodeCount() const;
+  unsigned int getParent(unsigned int node) const;
+  unsigned int getSubtreeEnd(unsigned int node) const;
+  const std::string &getName(unsigned int node) const;
+  // first node of that name, SCENE_GRAPH_NO_NODE if there is none
+  unsigned int findNode(const std::string &name) const;
+
+  const glm::mat4 &getLocalTransform(unsigned int node) const;
+  void setLocalTransform(unsigned int node, const glm::mat4 &local);
+  // as of the last update()
+  const glm::mat4 &getWorldTransform(unsigned int node) const;
+
+  // false if no node was dirty
+  bool update();
+  bool isDirty() const;
+
+private:
+  struct NodeRange {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  std::vector<uint32_t> m_parents;
+  std::vector<uint32_t> m_subtreeEnds;
+  std::vector<glm::mat4> m_locals;
+  std::vector<glm::mat4> m_worlds;
+  // set per node by setLocalTransform and passed down by update()
+  std::vector<uint8_t> m_dirty;
+  std::vector<std::string> m_names;
+  bool m_anyDirty = false;
+
+  // parallel update plan, rebuilt after nodes are added: the nodes above the
+  // job subtrees in order, then the ranges of adjacent subtrees per job
+  std::vector<uint32_t> m_sharedNodes;
+  std::vector<NodeRange> m_jobs;
+  bool m_planStale = true;
+
+  void buildPlan();
+  void updateNode(unsigned int node);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef SKELETON_H
+#define SKELETON_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "model/AnimationClip.hpp"
+#include "model/SceneGraph.hpp"
+#include "model/Vertex.hpp"
+
+// characters per job when evaluating many poses
+#define SKELETON_POSES_PER_JOB 8
+
+// A bone of a skin: the node that moves it and the matrix taking mesh space
+// vertices into the node's space in the bind pose.
+struct Bone {
+  uint32_t node;
+  glm::mat4 offset;
+};
+
+// Playback state of one character.
+struct CharacterPose {
+  unsigned int clip = 0;
+  float time = 0.0f;
+};
+
+// Joint hierarchy of a model, a copy of its scene graph's parents and rest
+// transforms, plus the bones its skinned meshes reference. A pose is a local
+// transform per joint; the palette is one matrix per bone that moves bind
+// pose vertices to the posed model space, what vertex weights blend.
+class Skeleton {
+public:
+  void setHierarchy(const SceneGraph &nodes);
+  // index of the node's bone, adding it on first use
+  unsigned int addBone(unsigned int node, const glm::mat4 &offset);
+
+  unsigned int getJointCount() const;
+  unsigned int getBoneCount() const;
+  const std::vector<glm::mat4> &getRestPose() const;
+
+  // one linear pass over the joints, parents first; worlds receives the
+  // model space transform of every joint
+  void computePalette(const glm::mat4 *locals, glm::mat4 *worlds,
+                      glm::mat4 *palette) const;
+
+private:
+  std::vector<uint32_t> m_parents;
+  std::vector<glm::mat4> m_restPose;
+  std::vector<Bone> m_bones;
+};
+
+// Samples each character's clip and writes its palette to
+// palettes + character * getBoneCount(). Characters are spread over the
+// default JobSystem, scratch comes from each thread's frame arena.
+void evaluatePoses(const Skeleton &skeleton,
+                   const std::vector<AnimationClip> &clips,
+                   const CharacterPose *poses, unsigned int poseCount,
+                   glm::mat4 *palettes);
+
+// CPU skinning: blends positions and normals of count vertices with the
+// palette. Other fields are copied, out may be in.
+void skinVertices(const Vertex *in, size_t count, const glm::mat4 *palette,
+                  Vertex *out);
+
+#endif
@@ -2,6 +2,7 @@
 #define WORLD_OBJECT_H
 #include <glm/glm.hpp>
 
+#include "Bounds.hpp"
 #include "model/Model.hpp"
 
 class WorldObject {
@@ -16,6 +17,12 @@ public:
   void setVelocity(const glm::vec3 velocity);
   glm::vec3 getScale() const;
   void setScale(const glm::vec3 scale);
+  glm::mat4 getTransform() const;
+  // the model's bounds placed in the world by the current transform
+  Aabb getBounds() const;
+  BoundingSphere getBoundingSphere() const;
+  Model &getModel();
+  const Model &getModel() const;
 
 private:
   Model m_model;
@@ -0,0 +1,46 @@
+#ifndef BIT_STREAM_H
+#define BIT_STREAM_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packs values of 1..32 bits LSB first into bytes. Appends to the output
+// vector, so a packet header can be written before the bits.
+class BitWriter {
+public:
+  BitWriter(std::vector<unsigned char> &out);
+
+  void write(uint32_t value, unsigned int bits);
+  void writeBool(bool value);
+  // writes any partial byte, call once after the last write
+  void flush();
+  // bits written so far, including any not yet flushed
+  size_t getBitCount() const;
+
+private:
+  std::vector<unsigned char> &m_out;
+  uint64_t m_scratch = 0;
+  unsigned int m_scratchBits = 0;
+  size_t m_bitCount = 0;
+};
+
+// Reads what BitWriter wrote. Reading past the end yields zeros and sets the
+// overflow flag, check it once after decoding instead of after every read.
+class BitReader {
+public:
+  BitReader(const unsigned char *data, size_t size);
+
+  uint32_t read(unsigned int bits);
+  bool readBool();
+  bool hasOverflowed() const;
+
+private:
+  const unsigned char *m_data;
+  size_t m_size;
+  size_t m_offset = 0;
+  uint64_t m_scratch = 0;
+  unsigned int m_scratchBits = 0;
+  bool m_overflowed = false;
+};
+
+#endif
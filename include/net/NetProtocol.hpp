@@ -0,0 +1,57 @@
+#ifndef NET_PROTOCOL_H
+#define NET_PROTOCOL_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "net/StateCodec.hpp"
+
+#define NET_MAGIC 0x54454e50u // "PNET"
+#define NET_DEFAULT_PORT 27015
+// largest datagram sent, stays below common path MTUs
+#define NET_MAX_PACKET_BYTES 1200
+
+// Packets start with the magic and a type byte. Header fields are raw little
+// endian memory images, same as the snapshot format, body states are bit
+// packed by StateCodec.
+enum class NetPacketType : uint8_t {
+  // client to server, also serves as connect and keepalive
+  ClientView = 1,
+  // server to client, a subset of the bodies the client can see
+  State = 2,
+};
+
+struct ClientViewPacket {
+  glm::vec3 cameraPosition;
+  float interestRadius;
+  // requested cap, the server may clamp it
+  uint32_t bytesPerSecond;
+};
+
+// The arena and codec config travel in every packet so packets decode on
+// their own. Bodies are in ascending id order.
+struct StatePacket {
+  uint64_t tick;
+  float timestep;
+  glm::vec3 arenaMin;
+  glm::vec3 arenaMax;
+  StateCodecConfig codec;
+  std::vector<CodecBodyState> bodies;
+};
+
+#define NET_STATE_HEADER_BYTES (4 + 1 + 8 + 4 + 24 + 12 + 2)
+
+void writeClientView(const ClientViewPacket &packet,
+                     std::vector<unsigned char> &out);
+void writeState(const StatePacket &packet, std::vector<unsigned char> &out);
+
+// false on a foreign or truncated packet
+bool readPacketType(const unsigned char *data, size_t size,
+                    NetPacketType &type);
+bool readClientView(const unsigned char *data, size_t size,
+                    ClientViewPacket &packet);
+bool readState(const unsigned char *data, size_t size, StatePacket &packet);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef REPLICATION_CLIENT_H
+#define REPLICATION_CLIENT_H
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "net/NetProtocol.hpp"
+#include "net/UdpSocket.hpp"
+
+// client view packets per second, doubles as the keepalive
+#define NET_VIEW_RATE 10.0f
+// render this far behind the newest server state so there is usually a later
+// sample to blend towards
+#define NET_INTERPOLATION_DELAY 0.1f
+// bodies not updated for this long left the interest area and are dropped
+#define NET_BODY_TIMEOUT 2.0f
+// longest dead reckoning past a body's newest state
+#define NET_MAX_EXTRAPOLATION 0.25f
+
+// Thin viewer of a ReplicationServer. Keeps the last two received states of
+// every body in view and blends between them at a render clock that trails
+// the server. Bodies the server has not refreshed by then, usually far ones
+// with low priority, are dead reckoned along their last velocity. Exposes the
+// same body accessors as PhysicsWorld so the render path does not care where
+// bodies come from.
+class ReplicationClient {
+public:
+  bool connect(const std::string &server);
+  bool isConnected() const;
+
+  void setView(const glm::vec3 cameraPosition, float interestRadius,
+               uint32_t bytesPerSecond);
+  // sends the view when due, applies received states and moves the render
+  // clock forward
+  void update(float deltaTime);
+
+  unsigned int getBodyCount() const;
+  glm::vec3 getPosition(unsigned int body) const;
+  float getRadius(unsigned int body) const;
+  uint32_t getServerId(unsigned int body) const;
+
+  uint64_t getBytesReceived() const;
+  uint64_t getLatestTick() const;
+
+private:
+  struct Sample {
+    double time;
+    glm::vec3 position;
+    glm::vec3 velocity;
+  };
+
+  UdpSocket m_socket;
+  NetAddress m_server;
+  ClientViewPacket m_view{glm::vec3(0.0f), 30.0f, 64 * 1024};
+  float m_viewTimer = 1.0f / NET_VIEW_RATE;
+
+  // server time of the newest state and the trailing render clock
+  double m_latestTime = 0.0;
+  double m_renderTime = 0.0;
+  bool m_clockStarted = false;
+  uint64_t m_latestTick = 0;
+  uint64_t m_bytesReceived = 0;
+
+  // dense body arrays, server id to index through m_indexOf
+  std::vector<uint32_t> m_ids;
+  std::vector<Sample> m_previous;
+  std::vector<Sample> m_current;
+  std::vector<float> m_radii;
+  std::vector<double> m_lastSeen;
+  std::vector<glm::vec3> m_positions;
+  std::unordered_map<uint32_t, unsigned int> m_indexOf;
+
+  StatePacket m_packet;
+  std::vector<unsigned char> m_buffer;
+
+  void receive();
+  void applyState(const StatePacket &packet);
+  void removeBody(unsigned int index);
+  void interpolate();
+};
+
+#endif
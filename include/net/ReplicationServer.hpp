@@ -0,0 +1,95 @@
+#ifndef REPLICATION_SERVER_H
+#define REPLICATION_SERVER_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "net/NetProtocol.hpp"
+#include "net/StateCodec.hpp"
+#include "net/UdpSocket.hpp"
+#include "physics/PhysicsWorld.hpp"
+
+// state packets per second sent to each client
+#define NET_DEFAULT_SEND_RATE 30.0f
+// upper bound on any client's requested bandwidth
+#define NET_MAX_BYTES_PER_SECOND (256 * 1024)
+// clients silent for this long are dropped
+#define NET_CLIENT_TIMEOUT 5.0f
+// views from further addresses are ignored until a client times out
+#define NET_MAX_CLIENTS 64
+// a body's radius rides along its first few updates to a client, enough to
+// survive some packet loss without acknowledgements
+#define NET_RADIUS_REPEATS 3
+// id delta bits assumed when filling a packet, larger gaps are rare and
+// trimmed after encoding
+#define NET_ID_BITS_ESTIMATE 11
+
+// Broadcasts body states of an authoritative world to viewers over UDP.
+//
+// Each client only receives bodies within its interest radius around its
+// camera, found through the world's broadphase. Every send, the priority of
+// each body in view grows by the time since the last send, weighted towards
+// bodies near the camera. The highest priorities fill the packet and are
+// reset, so far bodies still get through, just less often. A token bucket
+// holds every client to its byte rate.
+//
+// Body ids on the wire are pool slots, stable while a body lives. A slot
+// reused by a new body starts over with zero priority and resends its radius.
+class ReplicationServer {
+public:
+  ReplicationServer(const PhysicsWorld &world);
+
+  bool open(uint16_t port);
+  uint16_t getPort() const;
+  void setSendRate(float packetsPerSecond);
+  void setCodecConfig(const StateCodecConfig &config);
+
+  // reads client packets, then sends state to every client due for it
+  void update(float deltaTime);
+
+  unsigned int getClientCount() const;
+  uint64_t getBytesSent() const;
+  uint64_t getBodiesSent() const;
+
+private:
+  struct Client {
+    NetAddress address;
+    ClientViewPacket view;
+    float silentTime = 0.0f;
+    float sendTimer = 0.0f;
+    // token bucket, in bytes
+    float budget = 0.0f;
+    // per body id, grows while in view until the body is sent
+    std::vector<float> priority;
+    // per body id, updates sent with the radius included
+    std::vector<uint8_t> radiusSends;
+    // per body id, generation of the slot the entries above belong to
+    std::vector<uint32_t> generations;
+  };
+
+  const PhysicsWorld &m_world;
+  UdpSocket m_socket;
+  float m_sendInterval = 1.0f / NET_DEFAULT_SEND_RATE;
+  StateCodecConfig m_codecConfig;
+  StateCodec m_codec;
+  std::vector<Client> m_clients;
+  uint64_t m_bytesSent = 0;
+  uint64_t m_bodiesSent = 0;
+
+  // scratch reused across sends
+  std::vector<unsigned int> m_candidates;
+  // body ids
+  std::vector<unsigned int> m_inView;
+  std::vector<unsigned int> m_batch;
+  StatePacket m_packet;
+  std::vector<unsigned char> m_buffer;
+
+  void receive();
+  void sendState(Client &client, float elapsed);
+  void fillPacket(Client &client, const std::vector<unsigned int> &ids);
+  unsigned int bodyIndex(const Client &client, unsigned int id) const;
+  static size_t getBudgetBytes(const Client &client);
+};
+
+#endif
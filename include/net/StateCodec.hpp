@@ -0,0 +1,74 @@
+#ifndef STATE_CODEC_H
+#define STATE_CODEC_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "net/BitStream.hpp"
+
+// Fixed point encoding of a float range in the fewest bits that keep the
+// given precision. Values outside the range clamp to its ends.
+struct QuantizedRange {
+  float min = 0.0f;
+  float max = 1.0f;
+  unsigned int bits = 16;
+
+  static QuantizedRange fromPrecision(float min, float max, float precision);
+  uint32_t quantize(float value) const;
+  float dequantize(uint32_t value) const;
+};
+
+// Smallest three: drop the largest component (recoverable from unit length),
+// send its index in 2 bits and the other three in componentBits each.
+void writeQuaternion(BitWriter &writer, const glm::quat &q,
+                     unsigned int componentBits);
+glm::quat readQuaternion(BitReader &reader, unsigned int componentBits);
+
+struct StateCodecConfig {
+  // world units
+  float positionPrecision = 1.0f / 32.0f;
+  // units per second, per axis speeds above maxSpeed clamp
+  float velocityPrecision = 0.5f;
+  float maxSpeed = 32.0f;
+};
+
+struct CodecBodyState {
+  uint32_t id = 0;
+  glm::vec3 position = glm::vec3(0.0f);
+  glm::vec3 velocity = glm::vec3(0.0f);
+  // only sent while hasRadius, the receiver keeps the last one
+  bool hasRadius = false;
+  float radius = 0.0f;
+};
+
+// Bit packed body states. Positions are relative to the arena, velocities
+// that quantize to zero cost one bit, ids are sent as deltas so bodies should
+// be written in ascending id order. With the default config a moving body in
+// the default arena takes 29 position bits, 1 + 24 velocity bits and a radius
+// flag bit, plus 4 id bits for gaps up to 4 ids and 7 for gaps up to 36.
+class StateCodec {
+public:
+  StateCodec();
+  StateCodec(const glm::vec3 arenaMin, const glm::vec3 arenaMax,
+             const StateCodecConfig &config);
+
+  // previousId is the id of the body written before, UINT32_MAX for the first
+  void writeBody(BitWriter &writer, const CodecBodyState &body,
+                 uint32_t previousId) const;
+  void readBody(BitReader &reader, CodecBodyState &body,
+                uint32_t previousId) const;
+  // size of a body without its id delta
+  unsigned int getBodyBits(const CodecBodyState &body) const;
+
+  const StateCodecConfig &getConfig() const;
+
+private:
+  StateCodecConfig m_config;
+  QuantizedRange m_position[3];
+  QuantizedRange m_velocity;
+  QuantizedRange m_radius;
+};
+
+#endif
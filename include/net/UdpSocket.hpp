@@ -0,0 +1,45 @@
+#ifndef UDP_SOCKET_H
+#define UDP_SOCKET_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// IPv4 address in host byte order.
+struct NetAddress {
+  uint32_t ip = 0;
+  uint16_t port = 0;
+
+  bool operator==(const NetAddress &other) const {
+    return ip == other.ip && port == other.port;
+  }
+  // "host:port" or "host" with the given default port
+  static bool parse(const std::string &text, uint16_t defaultPort,
+                    NetAddress &out);
+  std::string toString() const;
+};
+
+// Non-blocking IPv4 UDP socket (POSIX).
+class UdpSocket {
+public:
+  UdpSocket() = default;
+  ~UdpSocket();
+  UdpSocket(const UdpSocket &) = delete;
+  UdpSocket &operator=(const UdpSocket &) = delete;
+
+  // port 0 picks an ephemeral port
+  bool open(uint16_t port);
+  void close();
+  bool isOpen() const;
+  uint16_t getPort() const;
+
+  bool send(const NetAddress &to, const void *data, size_t size);
+  // Size of the datagram read into buffer, 0 when nothing is pending.
+  // Datagrams longer than capacity are truncated.
+  size_t receive(void *buffer, size_t capacity, NetAddress &from);
+
+private:
+  int m_socket = -1;
+  uint16_t m_port = 0;
+};
+
+#endif
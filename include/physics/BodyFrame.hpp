@@ -0,0 +1,25 @@
+#ifndef BODY_FRAME_H
+#define BODY_FRAME_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "physics/PhysicsWorld.hpp"
+
+// Copy of the body state the renderer needs, stamped with simulation time.
+// Vectors keep their capacity, so capturing into a reused frame does not
+// allocate once the body count settles.
+struct BodyFrame {
+  uint64_t tick = 0;
+  double time = 0.0;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> velocities;
+  std::vector<float> radii;
+  // tells whether index i is the same body in two frames
+  std::vector<BodyHandle> handles;
+
+  void capture(const PhysicsWorld &world, double time);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef BODY_INTERPOLATOR_H
+#define BODY_INTERPOLATOR_H
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "physics/BodyFrame.hpp"
+#include "physics/PhysicsWorld.hpp"
+
+// longest dead reckoning past the newest state before bodies stop moving
+#define BODY_INTERPOLATOR_MAX_EXTRAPOLATION 0.25f
+
+// Render side copy of body state. Keeps the last few captured states of a
+// world, each stamped with its simulation time, and produces positions for
+// any render time: blended between the two states around it, or dead
+// reckoned along the velocity past the newest one. Physics can then tick at
+// a low fixed rate while frames render at any rate in between.
+//
+// Exposes the same body accessors as PhysicsWorld for the render path.
+class BodyInterpolator {
+public:
+  BodyInterpolator(unsigned int frameCount = 2);
+
+  // copies positions, velocities and radii, time must not go backwards
+  void capture(const PhysicsWorld &world, double time);
+  void capture(const BodyFrame &frame);
+  // computes the positions returned by getPosition
+  void sample(double time);
+  void setMaxExtrapolation(float seconds);
+  void clear();
+
+  unsigned int getBodyCount() const;
+  glm::vec3 getPosition(unsigned int body) const;
+  float getRadius(unsigned int body) const;
+
+private:
+  // ring, m_newest is the last captured
+  std::vector<BodyFrame> m_frames;
+  unsigned int m_newest = 0;
+  unsigned int m_captured = 0;
+  float m_maxExtrapolation = BODY_INTERPOLATOR_MAX_EXTRAPOLATION;
+
+  std::vector<glm::vec3> m_positions;
+
+  BodyFrame &nextFrame();
+  const BodyFrame &getFrame(unsigned int age) const;
+};
+
+#endif
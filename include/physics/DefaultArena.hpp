@@ -0,0 +1,9 @@
+#ifndef DEFAULT_ARENA_H
+#define DEFAULT_ARENA_H
+#include <glm/glm.hpp>
+
+// The arena main() simulates, also the default benchmark scenario
+const glm::vec3 DEFAULT_ARENA_MIN = glm::vec3(-15.0f, 0.0f, -15.0f);
+const glm::vec3 DEFAULT_ARENA_MAX = glm::vec3(15.0f, 8.0f, 15.0f);
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef PHYSICS_WORLD_H
+#define PHYSICS_WORLD_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "memory/FrameArena.hpp"
+#include "physics/UniformGrid.hpp"
+#include "physics/WorldSnapshot.hpp"
+
+struct Contact {
+  unsigned int a;
+  unsigned int b;
+  // points from a to b
+  glm::vec3 normal;
+  float penetration;
+};
+
+// Stable reference to a body. The body index moves when other bodies are
+// removed, the handle does not; a removed body's handle stops resolving even
+// after its slot is reused, because the slot's generation is bumped.
+struct BodyHandle {
+  uint32_t slot = UINT32_MAX;
+  uint32_t generation = 0;
+
+  bool isValid() const { return slot != UINT32_MAX; }
+  bool operator==(const BodyHandle &other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+  bool operator!=(const BodyHandle &other) const { return !(*this == other); }
+};
+
+// body pool size of a new world, reserve() changes it
+#define PHYSICS_DEFAULT_BODY_CAPACITY 16384
+
+// upper bound on catch-up steps per advance(), excess time is dropped
+#define MAX_STEPS_PER_ADVANCE 8
+
+// smallest slice of bodies or pairs a step phase hands to one job
+#define PHYSICS_BODIES_PER_JOB 1024
+#define PHYSICS_PAIRS_PER_JOB 512
+
+// Sphere bodies bouncing inside an axis aligned arena. Body state is stored as
+// dense parallel arrays indexed by body so every phase is a linear pass.
+// Bodies have equal mass.
+//
+// Bodies come from a fixed-capacity pool: adding takes a slot from a free list
+// and appends to the arrays, removing moves the last body into the hole. Both
+// are O(1) and never allocate while the count stays within the capacity.
+//
+// In deterministic mode the same binary produces bit-identical states from the
+// same initial state: every step uses the fixed timestep, bodies are updated
+// in id order, pairs come out in cell order (a pure function of the body
+// state), the physics library is built without FMA contraction, and a state
+// hash is taken after every step. Phases that split over the job system
+// only write per body or join their per-job lists in order, so thread count
+// never changes the result.
+//
+// Pairs and contacts live in a frame arena owned by the world and reset at the
+// start of every step, they stay readable until the next step.
+//
+// Every body has a world space bounding box, refitted once per step before
+// the broadphase buckets them and grown by the contact pass, so between
+// steps a box always holds its body.
+class PhysicsWorld {
+public:
+  PhysicsWorld(const glm::vec3 borderMin, const glm::vec3 borderMax);
+  PhysicsWorld(const PhysicsWorld &) = delete;
+  PhysicsWorld &operator=(const PhysicsWorld &) = delete;
+
+  // invalid handle if the pool is full
+  BodyHandle addBody(const glm::vec3 position, const glm::vec3 velocity,
+                     float radius);
+  // Adds count bodies from parallel arrays, writing their handles to handles
+  // if given. Stops when the pool is full, returns the number added.
+  unsigned int addBodies(const glm::vec3 *positions,
+                         const glm::vec3 *velocities, const float *radii,
+                         unsigned int count, BodyHandle *handles = nullptr);
+  // false if the handle no longer refers to a body
+  bool removeBody(BodyHandle handle);
+  bool isAlive(BodyHandle handle) const;
+  // current index of a live body
+  unsigned int getBodyIndex(BodyHandle handle) const;
+  BodyHandle getBodyHandle(unsigned int body) const;
+  // grows the pool to hold at least bodyCount bodies, never shrinks it
+  void reserve(unsigned int bodyCount);
+  unsigned int getCapacity() const;
+  unsigned int getBodyCount() const;
+  // slots handed out so far, an upper bound on handle slots
+  unsigned int getSlotCount() const;
+
+  glm::vec3 getPosition(unsigned int body) const;
+  void setPosition(unsigned int body, const glm::vec3 position);
+  glm::vec3 getVelocity(unsigned int body) const;
+  void setVelocity(unsigned int body, const glm::vec3 velocity);
+  float getRadius(unsigned int body) const;
+  glm::vec3 getBorderMin() const;
+  glm::vec3 getBorderMax() const;
+  // box of each body, indexed like the other body accessors
+  const std::vector<Aabb> &getBodyBounds() const;
+  // Box around every body. Removing a body does not shrink it until the next
+  // step, empty if there never were bodies.
+  const Aabb &getBounds() const;
+
+  void step(float deltaTime);
+  // Deterministic mode consumes frameTime in fixed steps and keeps the
+  // remainder, otherwise takes a single step of frameTime. Returns the number
+  // of steps taken.
+  unsigned int advance(float frameTime);
+
+  void setDeterministic(bool deterministic);
+  bool isDeterministic() const;
+  void setFixedTimestep(float timestep);
+  float getFixedTimestep() const;
+  // fraction of a fixed step left in the accumulator
+  float getInterpolationAlpha() const;
+  uint64_t getTick() const;
+
+  // hash of all body state, independent of capacity and scratch buffers
+  uint64_t computeStateHash() const;
+  // hash taken after the last deterministic step
+  uint64_t getStateHash() const;
+
+  // Bulk copies of the body columns and contact list, snapshot storage is
+  // reused across calls. Restoring replaces every body, broadphase data is
+  // rebuilt by the next step.
+  void saveSnapshot(WorldSnapshot &snapshot) const;
+  bool restoreSnapshot(const WorldSnapshot &snapshot);
+
+  // step phases, in order, exposed for benchmarking
+  void integrate(float deltaTime);
+  void reflectWalls();
+  void updateBounds();
+  void updateBroadphase();
+  void findPairs();
+  void narrowphase();
+  void resolveContacts();
+
+  const UniformGrid &getBroadphase() const;
+  const FrameVector<BodyPair> &getPairs() const;
+  const FrameVector<Contact> &getContacts() const;
+  // per-step scratch, for usage stats
+  const FrameArena &getStepArena() const;
+
+private:
+  glm::vec3 m_borderMin;
+  glm::vec3 m_borderMax;
+
+  std::vector<glm::vec3> m_positions;
+  std::vector<glm::vec3> m_velocities;
+  std::vector<float> m_radii;
+  std::vector<Aabb> m_bounds;
+  Aabb m_worldBounds;
+  // never shrinks on removal, the grid just keeps its cell size
+  float m_maxRadius = 0.0f;
+
+  // body index -> slot, and per slot the body index or, for a free slot, the
+  // next free slot. Slots past m_slotCount have never been used and have
+  // generation 0.
+  std::vector<uint32_t> m_bodySlots;
+  std::vector<uint32_t> m_slotBodies;
+  std::vector<uint32_t> m_slotGenerations;
+  uint32_t m_slotCount = 0;
+  uint32_t m_freeSlot = UINT32_MAX;
+
+  bool m_deterministic = false;
+  float m_fixedTimestep = 1.0f / 60.0f;
+  double m_accumulator = 0.0;
+  uint64_t m_tick = 0;
+  uint64_t m_stateHash = 0;
+
+  UniformGrid m_broadphase;
+  // declared before the containers it backs
+  FrameArena m_stepArena;
+  FrameVector<BodyPair> m_pairs;
+  FrameVector<Contact> m_contacts;
+  // contacts of each PHYSICS_PAIRS_PER_JOB pairs, joined into m_contacts
+  std::vector<std::vector<Contact>> m_blockContacts;
+
+  void beginStep();
+  void setBodyBounds(unsigned int body);
+};
+
+#endif
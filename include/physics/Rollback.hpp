@@ -0,0 +1,79 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "physics/PhysicsWorld.hpp"
+#include "physics/WorldSnapshot.hpp"
+
+// number of past ticks kept for rollback by default
+#define ROLLBACK_HISTORY_TICKS 16
+
+enum class WorldInputType : uint8_t {
+  SetVelocity = 0,
+  Spawn = 1,
+  Despawn = 2,
+};
+
+// A change applied to the world right before the step that leaves `tick`.
+// Only the fields of the input's type are meaningful. Bodies are named by
+// handle, their indices shift when a despawn compacts the pool.
+struct WorldInput {
+  uint64_t tick = 0;
+  WorldInputType type = WorldInputType::SetVelocity;
+  BodyHandle body;
+  glm::vec3 position = glm::vec3(0.0f);
+  glm::vec3 velocity = glm::vec3(0.0f);
+  float radius = 0.0f;
+};
+
+// Keeps snapshots of the last ticks in a ring, plus the inputs applied on each
+// tick. An input arriving for a past tick rolls the world back to that tick
+// and resimulates up to the present without rendering. Snapshots reuse their
+// storage, so saving and restoring are bulk copies of the body columns.
+//
+// The world must be in deterministic mode for a resimulation to reproduce the
+// states a peer computed from the same inputs.
+class Rollback {
+public:
+  Rollback(PhysicsWorld &world,
+           unsigned int historyTicks = ROLLBACK_HISTORY_TICKS);
+
+  // resimulates pending late inputs, then saves the current tick, applies
+  // its inputs and steps once
+  void step();
+  // Queues an input, one for a past tick marks the world for resimulation.
+  // Inputs of the same tick apply in arrival order. False if the tick is
+  // older than the history.
+  bool addInput(const WorldInput &input);
+  // rolls back to the earliest tick touched by a late input and resimulates
+  // to the current tick, returns the number of ticks resimulated
+  unsigned int resimulate();
+  bool needsResimulation() const;
+
+  // restores the state saved at tick, false if it left the history
+  bool rollbackTo(uint64_t tick);
+  // applies inputs and steps until the world reaches tick
+  void resimulateTo(uint64_t tick);
+
+  // oldest tick that can still be rolled back to
+  uint64_t getOldestTick() const;
+  unsigned int getHistoryTicks() const;
+
+private:
+  PhysicsWorld &m_world;
+  // slot tick % history holds the state at the start of that tick
+  std::vector<WorldSnapshot> m_history;
+  std::vector<uint64_t> m_historyTicks;
+  // sorted by tick, arrival order within a tick
+  std::vector<WorldInput> m_inputs;
+  uint64_t m_dirtyTick = UINT64_MAX;
+
+  void stepOnce();
+  void applyInputs(uint64_t tick);
+  void pruneInputs();
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "physics/BodyFrame.hpp"
+#include "physics/PhysicsWorld.hpp"
+#include "physics/TripleBuffer.hpp"
+
+// Steps a world at its fixed timestep on a thread of its own, paced by the
+// wall clock instead of by frames, and publishes a BodyFrame after every step
+// through a triple buffer. The world belongs to the thread between start()
+// and stop(); other threads only read frames and queue commands.
+class SimulationThread {
+public:
+  SimulationThread(PhysicsWorld &world);
+  ~SimulationThread();
+  SimulationThread(const SimulationThread &) = delete;
+  SimulationThread &operator=(const SimulationThread &) = delete;
+
+  void start();
+  void stop();
+  bool isRunning() const;
+
+  // queued for the next step while running, applied at once otherwise
+  void addBody(const glm::vec3 position, const glm::vec3 velocity,
+               float radius);
+
+  // reader side: swaps in the newest published frame, false if none is new
+  bool acquireFrame();
+  const BodyFrame &getFrame() const;
+  // simulation time the wall clock has reached, frames trail it by up to a
+  // step
+  double getTime() const;
+
+private:
+  struct SpawnCommand {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float radius;
+  };
+
+  PhysicsWorld &m_world;
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  std::chrono::steady_clock::time_point m_startClock;
+  double m_startTime = 0.0;
+  // wall time dropped after falling too far behind, read by getTime()
+  std::atomic<int64_t> m_droppedNs{0};
+
+  std::mutex m_commandMutex;
+  std::vector<SpawnCommand> m_commands;
+  // swapped with m_commands so the lock is held only for the swap
+  std::vector<SpawnCommand> m_pendingCommands;
+
+  TripleBuffer<BodyFrame> m_frames;
+
+  void run();
+  void applyCommands();
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit hashing of raw state bytes for desync detection. Not cryptographic,
+// only fast and sensitive to every bit.
+
+// bytes per independently hashed chunk, reductions over chunks combine in
+// chunk order so the result does not depend on how chunks are scheduled
+#define STATE_HASH_CHUNK_BYTES (64 * 1024)
+
+inline uint64_t stateHashMix(uint64_t h) {
+  // splitmix64 finalizer
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+inline uint64_t stateHashRotl(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+// four independent lanes so the multiply chains overlap
+inline uint64_t stateHashBytes(const void *data, size_t size, uint64_t seed) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  const uint64_t prime = 0x9E3779B97F4A7C15ULL;
+  uint64_t lanes[4] = {seed, seed + prime, seed ^ prime, ~seed};
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (int lane = 0; lane < 4; lane++) {
+      uint64_t word;
+      std::memcpy(&word, bytes + i + lane * 8, 8);
+      lanes[lane] = stateHashRotl(lanes[lane] ^ word, 31) * prime;
+    }
+  }
+  uint64_t h = size * prime;
+  for (int lane = 0; lane < 4; lane++) {
+    h = stateHashMix(h ^ lanes[lane]);
+  }
+  // up to 31 bytes left, folded a word at a time
+  for (; i < size; i += 8) {
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes + i, size - i < 8 ? size - i : 8);
+    h = stateHashMix(h ^ tail);
+  }
+  return h;
+}
+
+// hashes in fixed chunks and folds the chunk hashes in order
+inline uint64_t stateHashColumn(const void *data, size_t size, uint64_t seed) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  uint64_t h = stateHashMix(seed ^ size);
+  for (size_t offset = 0; offset < size; offset += STATE_HASH_CHUNK_BYTES) {
+    size_t chunk = size - offset < STATE_HASH_CHUNK_BYTES
+                       ? size - offset
+                       : STATE_HASH_CHUNK_BYTES;
+    h = stateHashMix(h ^ stateHashBytes(bytes + offset, chunk, offset));
+  }
+  return h;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+#include <atomic>
+
+// Lock-free handoff of whole values from one writer thread to one reader
+// thread. The writer fills its slot and publishes it by swapping it with the
+// shared middle slot; the reader swaps the middle for its own slot when a
+// fresh one is there. Neither side ever waits, and the reader always gets the
+// newest complete value, skipping any it was too slow to see.
+template <typename T> class TripleBuffer {
+public:
+  // writer thread only
+  T &getWriteBuffer() { return m_slots[m_write]; }
+  void publish() {
+    unsigned int previous =
+        m_middle.exchange(m_write | FRESH_BIT, std::memory_order_acq_rel);
+    m_write = previous & INDEX_MASK;
+  }
+
+  // reader thread only, true if a newer value replaced the read buffer
+  bool acquire() {
+    if (!(m_middle.load(std::memory_order_relaxed) & FRESH_BIT)) {
+      return false;
+    }
+    unsigned int previous =
+        m_middle.exchange(m_read, std::memory_order_acq_rel);
+    m_read = previous & INDEX_MASK;
+    return true;
+  }
+  const T &getReadBuffer() const { return m_slots[m_read]; }
+
+private:
+  static const unsigned int INDEX_MASK = 3;
+  static const unsigned int FRESH_BIT = 4;
+
+  T m_slots[3];
+  // each index on its own cache line so the threads do not share one
+  alignas(64) unsigned int m_write = 0;
+  alignas(64) unsigned int m_read = 1;
+  alignas(64) std::atomic<unsigned int> m_middle{2};
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef UNIFORM_GRID_H
+#define UNIFORM_GRID_H
+#include <memory_resource>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+// lower bound on the cell size for small bodies, as cells per body
+#define UNIFORM_GRID_CELLS_PER_BODY 8
+// smallest slice of bodies or z layers handed to one job
+#define UNIFORM_GRID_BODIES_PER_JOB 1024
+#define UNIFORM_GRID_LAYERS_PER_JOB 2
+
+struct BodyPair {
+  unsigned int a;
+  unsigned int b;
+};
+
+// Broadphase over the fixed arena. Bodies are bucketed by the cell holding
+// the min corner of their bounding box with a counting sort, so a rebuild is
+// two linear passes and reuses its storage. Cells are at least as wide as
+// the largest box, so every overlapping pair is found in the 27 neighbouring
+// cells.
+//
+// Cell assignment and the pair search are split over the default job
+// system. Each z layer collects its pairs on its own and the layers are
+// joined in order, so the output is the same for any thread count.
+class UniformGrid {
+public:
+  UniformGrid();
+  UniformGrid(const glm::vec3 boundsMin, const glm::vec3 boundsMax);
+
+  void setBounds(const glm::vec3 boundsMin, const glm::vec3 boundsMax);
+  // maxRadius is half the size of the largest box on any axis
+  void build(const std::vector<Aabb> &bounds, float maxRadius);
+  // storage for builds of up to bodyCount bodies, so they never allocate
+  void reserve(unsigned int bodyCount);
+
+  // candidates for the bodies whose boxes overlap the box, in cell order
+  void queryBox(const glm::vec3 boxMin, const glm::vec3 boxMax,
+                std::vector<unsigned int> &out) const;
+  // pairs with overlapping bounding boxes, a < b, in cell order
+  void findPairs(const std::vector<Aabb> &bounds,
+                 std::pmr::vector<BodyPair> &out);
+
+  float getCellSize() const;
+  glm::ivec3 getDimensions() const;
+
+private:
+  glm::vec3 m_boundsMin;
+  glm::vec3 m_boundsMax;
+  float m_cellSize;
+  float m_inverseCellSize;
+  glm::ivec3 m_dims;
+
+  // m_cellBodies[m_cellStart[c] .. m_cellStart[c + 1]) are the bodies in c
+  std::vector<unsigned int> m_cellStart;
+  std::vector<unsigned int> m_cellBodies;
+  std::vector<unsigned int> m_bodyCell;
+  // pairs found per z layer, kept so steady scenes never allocate
+  std::vector<std::vector<BodyPair>> m_layerPairs;
+
+  // cell size and grid dimensions build() picks
+  float cellSizeFor(unsigned int bodyCount, float maxRadius) const;
+  glm::ivec3 dimensionsFor(float cellSize) const;
+  glm::ivec3 cellCoords(const glm::vec3 position) const;
+  // pairs whose first body is in layer z
+  void findLayerPairs(const std::vector<Aabb> &bounds, int z,
+                      std::vector<BodyPair> &out) const;
+  unsigned int cellIndex(const glm::ivec3 coords) const;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define WORLD_SNAPSHOT_MAGIC 0x4e535750u // "PWSN"
+#define WORLD_SNAPSHOT_VERSION 2u
+// position, velocity, radius and slot of a body
+#define WORLD_SNAPSHOT_BODY_BYTES 32
+// body index or next free slot, and generation of a pool slot
+#define WORLD_SNAPSHOT_SLOT_BYTES 8
+// largest snapshot a delta may decode to, about 25M bodies, so a corrupt
+// size cannot ask for an absurd allocation
+#define WORLD_SNAPSHOT_MAX_BYTES (1ull << 30)
+
+// Layout: WorldSnapshotHeader followed by the body columns in PhysicsWorld
+// order (positions, velocities, radii, slots), the slot tables of the body
+// pool up to slotCount (bodies, generations) and then the contact list, each
+// as a raw memory image. Same-binary only, no endianness or padding
+// conversion.
+struct WorldSnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t tick;
+  uint64_t stateHash;
+  uint32_t bodyCount;
+  uint32_t contactCount;
+  float maxRadius;
+  uint32_t slotCount;
+  uint32_t freeSlot;
+  uint32_t reserved;
+};
+
+struct WorldSnapshot {
+  std::vector<unsigned char> data;
+
+  bool isValid() const;
+  const WorldSnapshotHeader &getHeader() const;
+};
+
+// XOR against the previous snapshot, then run length encode the zero bytes.
+// Bodies at rest and unchanged columns collapse to a few bytes. Either side
+// may be empty (a full snapshot relative to nothing).
+class SnapshotDelta {
+public:
+  static void encode(const WorldSnapshot &previous,
+                     const WorldSnapshot &current,
+                     std::vector<unsigned char> &delta);
+  static bool decode(const WorldSnapshot &previous,
+                     const std::vector<unsigned char> &delta,
+                     WorldSnapshot &current);
+};
+
+bool writeSnapshotFile(const std::string &path, const WorldSnapshot &snapshot);
+bool readSnapshotFile(const std::string &path, WorldSnapshot &snapshot);
+
+#endif
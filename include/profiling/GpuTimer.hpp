@@ -0,0 +1,48 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+#include <cstdint>
+#include <vector>
+
+// frames a query result may lag behind before we read it back, reading any
+// sooner would stall on the GPU
+#define GPU_TIMER_LATENCY 3
+
+// GL_TIME_ELAPSED query pool, one ring of queries per named pass. Results are
+// collected GPU_TIMER_LATENCY frames later and forwarded to the Profiler.
+// Passes may not nest, GL only allows one active time elapsed query.
+class GpuTimer {
+public:
+  GpuTimer();
+  ~GpuTimer();
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+
+  // returns the pass id used by begin/end
+  unsigned int addPass(const char *name);
+  // reads back finished queries and advances to the next ring slot
+  void beginFrame();
+  void begin(unsigned int pass);
+  void end();
+
+  // last collected duration for a pass
+  uint64_t getLastNs(unsigned int pass) const;
+
+private:
+  struct Slot {
+    unsigned int query = 0;
+    bool pending = false;
+    uint64_t cpuStartNs = 0;
+    uint32_t frame = 0;
+  };
+  struct Pass {
+    const char *name;
+    Slot slots[GPU_TIMER_LATENCY];
+    uint64_t lastNs = 0;
+  };
+
+  std::vector<Pass> m_passes;
+  unsigned int m_slot = 0;
+  int m_active = -1;
+};
+
+#endif
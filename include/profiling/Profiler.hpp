@@ -0,0 +1,97 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Fixed size so recording never allocates; a full buffer overwrites its oldest
+// events.
+#define PROFILER_EVENTS_PER_THREAD (1 << 15)
+
+struct ProfileEvent {
+  const char *name;
+  uint64_t startNs;
+  uint64_t durationNs;
+  uint32_t frame;
+};
+
+// Single producer ring owned by one thread, recording takes no locks. The
+// owner claims a slot before overwriting it and publishes it after, readers
+// copy without blocking the owner and drop slots claimed again meanwhile.
+class ProfileRingBuffer {
+public:
+  ProfileRingBuffer(uint32_t threadId, std::string threadName);
+
+  void push(const ProfileEvent &event);
+  // copies the retained events, oldest first
+  std::vector<ProfileEvent> snapshot() const;
+  uint32_t getThreadId() const;
+  const std::string &getThreadName() const;
+
+private:
+  // fields are relaxed atomics so a concurrent copy is not a data race,
+  // torn copies are caught by m_claimed
+  struct Slot {
+    std::atomic<const char *> name;
+    std::atomic<uint64_t> startNs;
+    std::atomic<uint64_t> durationNs;
+    std::atomic<uint32_t> frame;
+  };
+
+  uint32_t m_threadId;
+  std::string m_threadName;
+  // events whose slot write has started and finished
+  std::atomic<uint64_t> m_claimed{0};
+  std::atomic<uint64_t> m_written{0};
+  Slot m_events[PROFILER_EVENTS_PER_THREAD];
+};
+
+class Profiler {
+public:
+  // nanoseconds since the profiler epoch (first use in the process)
+  static uint64_t nowNs();
+
+  static void beginFrame();
+  static uint32_t getFrame();
+
+  static void setThreadName(const std::string &name);
+  static void record(const char *name, uint64_t startNs, uint64_t durationNs);
+  // GPU passes are shown on their own track in the trace
+  static void recordGpu(const char *name, uint64_t startNs, uint64_t durationNs,
+                        uint32_t frame);
+
+  // Total time per scope name over the last completed frame. GPU passes
+  // arrive GPU_TIMER_LATENCY frames late, each reports its newest frame.
+  static std::vector<std::pair<std::string, uint64_t>> lastFrameBreakdown();
+  // Chrome trace event format, load with chrome://tracing or Perfetto
+  static bool writeChromeTrace(const std::string &path);
+
+private:
+  static ProfileRingBuffer &threadBuffer();
+  static ProfileRingBuffer &gpuBuffer();
+};
+
+// RAII CPU scope, name must outlive the profiler (string literals)
+class ProfileScope {
+public:
+  explicit ProfileScope(const char *name)
+      : m_name(name), m_startNs(Profiler::nowNs()) {}
+  ~ProfileScope() {
+    Profiler::record(m_name, m_startNs, Profiler::nowNs() - m_startNs);
+  }
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  const char *m_name;
+  uint64_t m_startNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)                                                    \
+  ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef BONE_PALETTES_H
+#define BONE_PALETTES_H
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "Shader.hpp"
+#include "render/StreamBuffer.hpp"
+
+// shader storage binding the skinning shaders read bone matrices from
+#define BONE_PALETTE_BINDING 1
+
+// Bone palettes of every character drawn this frame, back to back in a
+// range of the frame's StreamBuffer. The skinning path of shadows.vert and
+// simple_depth_shader.vert finds instance i's palette at i * boneCount.
+class BonePalettes {
+public:
+  // Reserves this frame's palettes, evaluatePoses can fill them in place
+  // from its worker threads. Null when the stream is full, nothing is
+  // skinned then.
+  glm::mat4 *allocate(StreamBuffer &stream, unsigned int characterCount,
+                      unsigned int boneCount);
+  // binds the range and turns skinning on in shader until unbind
+  void bind(const Shader &shader) const;
+  void unbind(const Shader &shader) const;
+
+  unsigned int getCharacterCount() const;
+
+private:
+  const StreamBuffer *m_stream = nullptr;
+  size_t m_offset = 0;
+  unsigned int m_characterCount = 0;
+  unsigned int m_boneCount = 0;
+};
+
+#endif
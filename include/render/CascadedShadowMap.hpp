@@ -0,0 +1,57 @@
+#ifndef CASCADED_SHADOW_MAP_H
+#define CASCADED_SHADOW_MAP_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "Camera.hpp"
+#include "Shader.hpp"
+
+// must match the geometry shader invocation count and the uniform array sizes
+// in the shadow shaders
+#define MAX_SHADOW_CASCADES 4
+
+// Directional light shadows split over slices of the camera frustum. Every
+// cascade is a layer of one depth texture array, all layers are rendered in a
+// single pass by instancing the geometry shader per cascade.
+class CascadedShadowMap {
+public:
+  CascadedShadowMap(unsigned int resolution, unsigned int cascadeCount,
+                    float shadowDistance);
+
+  // Re-fits every cascade to its camera frustum slice. sceneBounds bound all
+  // potential shadow casters and only extend the light-space depth range, so
+  // the tighter they are the more depth precision is left.
+  void update(const Camera &camera, const glm::vec3 lightDirection,
+              const Aabb &sceneBounds);
+
+  // binds the layered FBO and viewport, caller restores both afterwards
+  void bindForWriting() const;
+  void bindTexture(unsigned int unit) const;
+  void setDepthUniforms(const Shader &shader) const;
+  void setLightingUniforms(const Shader &shader) const;
+
+  unsigned int getResolution() const;
+  unsigned int getCascadeCount() const;
+  glm::mat4 getLightSpaceMatrix(unsigned int cascade) const;
+
+private:
+  unsigned int m_resolution;
+  unsigned int m_cascadeCount;
+  float m_shadowDistance;
+  // blend between uniform (0) and logarithmic (1) split distribution
+  float m_splitLambda = 0.75f;
+
+  unsigned int m_FBO;
+  unsigned int m_depthMaps;
+
+  float m_cascadeFarPlanes[MAX_SHADOW_CASCADES];
+  float m_cascadeDepthBias[MAX_SHADOW_CASCADES];
+  glm::mat4 m_lightSpaceMatrices[MAX_SHADOW_CASCADES];
+
+  void fitCascade(unsigned int cascade, const Camera &camera, float nearPlane,
+                  float farPlane, const glm::mat4 &lightRotation,
+                  const Aabb &sceneBounds);
+};
+
+#endif
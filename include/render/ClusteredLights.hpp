@@ -0,0 +1,106 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "Shader.hpp"
+#include "render/StreamBuffer.hpp"
+
+// froxels across, down and in depth, must match the grid the lighting
+// shader is given through bind()
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+// shader storage bindings of the lights, the per cluster ranges and the
+// light index list
+#define POINT_LIGHT_BINDING 2
+#define LIGHT_CLUSTER_BINDING 3
+#define LIGHT_INDEX_BINDING 4
+
+// A point light as the shaders read it, two vec4s. Its light fades to zero
+// at radius.
+struct PointLight {
+  glm::vec3 position;
+  float radius;
+  glm::vec3 color;
+  float intensity;
+};
+
+// Clustered forward shading. The view frustum is split into a grid of
+// froxels, screen tiles by depth slices spaced exponentially between the
+// near and far plane. Each frame every light is listed in the froxels its
+// sphere touches, and a fragment shades only the lights of its own froxel,
+// so hundreds of small lights cost a handful each per pixel in one pass.
+//
+// Assignment runs on the CPU: light bounds over the default JobSystem,
+// then one job per depth slice, which owns that slice's froxels and its
+// own index list. The lists are joined and written to three shader storage
+// ranges of the frame's StreamBuffer.
+class ClusteredLights {
+public:
+  ClusteredLights();
+
+  // assigns the lights to the froxels of view and projection, then writes
+  // them to stream; with the stream full no light is shaded this frame
+  void update(const glm::mat4 &view, const glm::mat4 &projection,
+              float nearPlane, float farPlane, const PointLight *lights,
+              unsigned int lightCount, StreamBuffer &stream);
+  // the CPU half of update, no GL calls
+  void assign(const glm::mat4 &view, const glm::mat4 &projection,
+              float nearPlane, float farPlane, const PointLight *lights,
+              unsigned int lightCount);
+  // binds the ranges and sets the grid uniforms of shader, which must be
+  // in use
+  void bind(const Shader &shader) const;
+
+  unsigned int getLightCount() const;
+  // light indices over all froxels, a light counts once per froxel
+  unsigned int getAssignmentCount() const;
+  // froxel x, y, z is cluster (z * Y + y) * X + x
+  const uint32_t *getClusterLights(unsigned int cluster,
+                                   unsigned int &count) const;
+  unsigned int getSlice(float viewDistance) const;
+
+private:
+  // froxel range a light may touch, empty when x0 > x1
+  struct LightRange {
+    glm::vec3 viewCenter;
+    float radius;
+    int x0, x1, y0, y1, z0, z1;
+  };
+
+  unsigned int m_lightCount = 0;
+  // this frame's ranges in m_stream, null until written
+  const StreamBuffer *m_stream = nullptr;
+  size_t m_lightOffset = 0;
+  size_t m_clusterOffset = 0;
+  size_t m_indexOffset = 0;
+
+  // the projection the froxel boxes were built for
+  float m_projectionX = 0.0f;
+  float m_projectionY = 0.0f;
+  float m_nearPlane = 0.0f;
+  float m_farPlane = 0.0f;
+  // slice = log(distance) * scale + bias
+  float m_sliceScale = 0.0f;
+  float m_sliceBias = 0.0f;
+  // view space box of every froxel
+  std::vector<Aabb> m_clusterBounds;
+
+  // offset into m_indices and light count per froxel
+  std::vector<glm::uvec2> m_clusters;
+  // each slice job's lights, joined into m_indices
+  std::vector<std::vector<uint32_t>> m_sliceIndices;
+  std::vector<uint32_t> m_indices;
+
+  void buildClusterBounds(const glm::mat4 &projection, float nearPlane,
+                          float farPlane);
+  LightRange findRange(const glm::mat4 &view, const PointLight &light) const;
+  void assignSlice(unsigned int slice, const LightRange *ranges,
+                   unsigned int lightCount);
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+// The six clip planes of a view projection, normals pointing inwards. The
+// tests are conservative: a volume outside near an edge or corner of the
+// frustum may still be reported as intersecting, one inside never is not.
+class Frustum {
+public:
+  Frustum();
+  explicit Frustum(const glm::mat4 &viewProjection);
+
+  bool intersects(const glm::vec3 &center, float radius) const;
+  bool intersects(const BoundingSphere &sphere) const;
+  bool intersects(const Aabb &box) const;
+
+private:
+  // xyz is the unit normal, w the offset
+  glm::vec4 m_planes[6];
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Camera.hpp"
+
+// largest error in pixels a detail level may show on screen
+#define LOD_PIXEL_ERROR 1.0f
+// a coarser level is only taken once its error is this fraction under the
+// limit, so objects sitting at a threshold do not flicker between levels
+#define LOD_HYSTERESIS 0.25f
+
+// instances drawn at one detail level, a range of the frame's instance buffer
+struct LodBatch {
+  unsigned int first = 0;
+  unsigned int count = 0;
+};
+
+// Picks the detail level of each object from its projected error: the
+// coarsest level whose error, scaled with the object and seen from the
+// camera's distance, stays under the pixel limit. The level chosen last frame
+// is remembered per object, moving to a finer level happens as soon as the
+// limit is crossed, moving to a coarser one needs the hysteresis margin.
+class LodSelector {
+public:
+  explicit LodSelector(float pixelError = LOD_PIXEL_ERROR,
+                       float hysteresis = LOD_HYSTERESIS);
+
+  // camera position and projection scale, once per frame before select()
+  void setView(const Camera &camera);
+  // levelErrors[i] is the error of level i in model units, object indexes
+  // the remembered levels
+  unsigned int select(unsigned int object, const glm::vec3 &center,
+                      float scale, const std::vector<float> &levelErrors);
+  // forgets the levels of objects from objectCount on
+  void resize(unsigned int objectCount);
+
+private:
+  float m_pixelError;
+  float m_hysteresis;
+  glm::vec3 m_eye = glm::vec3(0.0f);
+  // pixels covered by one unit at distance one
+  float m_pixelsPerUnit = 0.0f;
+  std::vector<uint8_t> m_levels;
+};
+
+#endif
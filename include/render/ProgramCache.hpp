@@ -0,0 +1,55 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+#include <cstdint>
+#include <string>
+
+// linked program binaries live here, relative to the project root
+#define PROGRAM_CACHE_DIRECTORY "/cooked/programs"
+#define PROGRAM_CACHE_MAGIC 0x47525050u // "PPRG"
+#define PROGRAM_CACHE_VERSION 1u
+
+// Layout: ProgramBinaryHeader, then size bytes of glGetProgramBinary output.
+// Same-binary only, like the cooked textures.
+struct ProgramBinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t format;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t size;
+};
+
+// Directory of linked program binaries, one file per key. The key hashes
+// every stage's final source, defines included, and the driver's vendor,
+// renderer and version strings, so an edit or a driver change misses and
+// the caller compiles. A driver that still refuses a binary with a matching
+// key fails the load the same way, the fresh link then overwrites it.
+class ProgramCache {
+public:
+  explicit ProgramCache(const std::string &directory);
+
+  // FNV-1a over the sources, in stage order, and the current driver
+  static uint64_t makeKey(const std::string &vertexCode,
+                          const std::string &fragmentCode,
+                          const std::string &geometryCode);
+
+  // a new program from the binary stored under key, 0 if there is none or
+  // the driver rejects it
+  unsigned int load(uint64_t key) const;
+  // saves a linked program, which must have been linked with
+  // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set; false if it cannot be written
+  bool store(uint64_t key, unsigned int program) const;
+
+  std::string getPath(uint64_t key) const;
+  // false when the driver offers no binary formats, load and store then
+  // do nothing
+  static bool isSupported();
+
+  // cache in PROGRAM_CACHE_DIRECTORY
+  static ProgramCache &getDefault();
+
+private:
+  std::string m_directory;
+};
+
+#endif
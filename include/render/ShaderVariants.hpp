@@ -0,0 +1,34 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+#include <string>
+#include <unordered_map>
+
+#include "Shader.hpp"
+
+// Programs built from one set of shader files under different #define sets.
+// Each draw picks the variant specialised for its features, so the shader
+// carries no branches on uniforms for them. A variant compiles on first use
+// and stays cached under its define set; references to it stay valid.
+class ShaderVariants {
+public:
+  // base defines apply to every variant, a variant's own override them
+  ShaderVariants(const std::string &vertexPath,
+                 const std::string &fragmentPath,
+                 const std::string &geometryPath = "",
+                 const ShaderDefines &base = ShaderDefines());
+
+  Shader &get(const ShaderDefines &defines = ShaderDefines());
+  unsigned int getVariantCount() const;
+
+  // "NAME=VALUE;" per define in name order
+  static std::string makeKey(const ShaderDefines &defines);
+
+private:
+  std::string m_vertexPath;
+  std::string m_fragmentPath;
+  std::string m_geometryPath;
+  ShaderDefines m_base;
+  std::unordered_map<std::string, Shader> m_variants;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SPHERE_IMPOSTORS_H
+#define SPHERE_IMPOSTORS_H
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "Shader.hpp"
+#include "model/GlObject.hpp"
+
+// shader storage binding the impostor shaders read spheres from
+#define SPHERE_IMPOSTOR_BINDING 0
+
+// Draws spheres as single quads whose fragments ray trace the sphere and
+// write its depth and normal, six vertices per sphere and no vertex data.
+// Spheres are read from a buffer range of vec4 center and radius. The
+// shader must be the IMPOSTOR variant of shadows or simple_depth_shader; in
+// the shadow pass the quads face the light instead of the camera.
+class SphereImpostors {
+public:
+  SphereImpostors();
+
+  // draws with shader, which is left in use
+  void draw(const Shader &shader, unsigned int sphereBuffer, size_t offset,
+            unsigned int sphereCount) const;
+
+private:
+  // core profile draws need a vertex array even with no attributes
+  GlVertexArray m_vertexArray;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+#include <atomic>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "model/GlObject.hpp"
+
+// frames the CPU may write ahead of the GPU
+#define STREAM_BUFFER_REGIONS 3
+// returned by allocate when the frame's region is full
+#define STREAM_BUFFER_FULL ((size_t)-1)
+
+// Per-frame data streamed to the GPU through one buffer with immutable
+// storage, mapped persistent and coherent once for its whole life. The
+// buffer is split into STREAM_BUFFER_REGIONS regions used round robin, one
+// per frame; a fence after each frame's draws keeps the CPU from
+// overwriting a region the GPU still reads. There is no glBufferData
+// orphaning and no glBufferSubData copy. Body and orb instances are written
+// into mapped memory in place; data the CPU reads back, like the clustered
+// light lists, is built in ordinary memory and copied in once.
+//
+// allocate may be called from any thread between beginFrame and endFrame,
+// and the returned memory may be written by any thread; it must be filled
+// before the draw that reads it is issued. The mapping is write combined on
+// most drivers, never read it back.
+class StreamBuffer {
+public:
+  explicit StreamBuffer(size_t regionBytes);
+  ~StreamBuffer();
+  StreamBuffer(const StreamBuffer &) = delete;
+  StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+  // moves to the next region, waiting for the GPU if it still uses it
+  void beginFrame();
+  // fences the region after the frame's last draw
+  void endFrame();
+
+  // Offset in the buffer of bytes in this frame's region, aligned for
+  // shader storage ranges and vec4 instance attributes.
+  // STREAM_BUFFER_FULL once the region is used up.
+  size_t allocate(size_t bytes);
+  void *getPointer(size_t offset) const;
+  // typed allocate, null when full
+  template <typename T> T *allocate(size_t count, size_t &offset) {
+    offset = allocate(count * sizeof(T));
+    return offset == STREAM_BUFFER_FULL
+               ? nullptr
+               : static_cast<T *>(getPointer(offset));
+  }
+
+  // binds bytes at offset to an indexed shader storage or uniform binding
+  void bindRange(GLenum target, unsigned int index, size_t offset,
+                 size_t bytes) const;
+
+  unsigned int getBuffer() const;
+  size_t getRegionBytes() const;
+  // bytes allocated in the current region, more than it holds after an
+  // allocation failed
+  size_t getUsedBytes() const;
+
+private:
+  GlBuffer m_buffer;
+  size_t m_regionBytes;
+  size_t m_alignment = 16;
+  unsigned char *m_mapped = nullptr;
+  unsigned int m_region = 0;
+  GLsync m_fences[STREAM_BUFFER_REGIONS] = {};
+  std::atomic<size_t> m_used{0};
+  std::atomic<bool> m_overflowReported{false};
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+// bytes of one compressed 4x4 block
+#define BC1_BLOCK_BYTES 8
+#define BC3_BLOCK_BYTES 16
+
+// S3TC encoders and decoders for one 4x4 block of RGBA8 pixels in row order
+// (64 bytes). BC1 stores color only, always in its opaque four color mode;
+// BC3 adds an interpolated alpha block in front of a BC1 color block.
+void encodeBC1Block(const unsigned char *rgba, unsigned char *block);
+void encodeBC3Block(const unsigned char *rgba, unsigned char *block);
+void decodeBC1Block(const unsigned char *block, unsigned char *rgba);
+void decodeBC3Block(const unsigned char *block, unsigned char *rgba);
+
+#endif
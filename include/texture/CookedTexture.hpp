@@ -0,0 +1,82 @@
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define COOKED_TEXTURE_MAGIC 0x58455450u // "PTEX"
+#define COOKED_TEXTURE_VERSION 1u
+// enough for a 32768 pixel edge
+#define COOKED_TEXTURE_MAX_MIPS 16
+// mip data offsets are aligned to this
+#define COOKED_TEXTURE_ALIGNMENT 16
+
+enum class TextureFormat : uint32_t {
+  RGBA8 = 0,
+  // opaque color, 0.5 bytes per pixel
+  BC1 = 1,
+  // color and alpha, 1 byte per pixel
+  BC3 = 2,
+};
+
+struct TextureCookOptions {
+  // BC1 for opaque images and BC3 for ones with alpha, RGBA8 otherwise
+  bool compress = true;
+  bool flipVertically = true;
+};
+
+// Layout: CookedTextureHeader, mipCount CookedMip entries, then the mip
+// images largest first, each at an aligned offset from the start of the file.
+// The source's size and modification time tell when a cook is stale.
+// Same-binary only, no endianness conversion, like the world snapshots.
+struct CookedTextureHeader {
+  uint32_t magic;
+  uint32_t version;
+  TextureFormat format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t mipCount;
+  uint32_t flipped;
+  uint32_t reserved;
+  uint64_t sourceSize;
+  int64_t sourceTime;
+};
+
+struct CookedMip {
+  uint32_t width;
+  uint32_t height;
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Decodes an image, builds its box filtered mip chain and compresses every
+// level. False if the image cannot be decoded.
+bool cookTexture(const std::string &sourcePath,
+                 const TextureCookOptions &options,
+                 std::vector<unsigned char> &out);
+// cooks to a temporary file and renames it over cookedPath
+bool cookTextureFile(const std::string &sourcePath,
+                     const std::string &cookedPath,
+                     const TextureCookOptions &options);
+
+// Checked view of a cooked texture in memory, usually a mapped file. The
+// memory must outlive the view.
+class CookedTextureView {
+public:
+  bool parse(const unsigned char *data, size_t size);
+
+  const CookedTextureHeader &getHeader() const;
+  const CookedMip &getMip(unsigned int level) const;
+  const unsigned char *getMipData(unsigned int level) const;
+
+private:
+  const unsigned char *m_data = nullptr;
+  const CookedTextureHeader *m_header = nullptr;
+  const CookedMip *m_mips = nullptr;
+};
+
+size_t textureLevelBytes(TextureFormat format, uint32_t width,
+                         uint32_t height);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <cstddef>
+#include <string>
+
+// Read-only memory map of a whole file, unmapped with the owner. Pages are
+// read on first touch, so loading a mapped texture skips the copy into a
+// read buffer.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool open(const std::string &path);
+  void close();
+
+  const unsigned char *getData() const;
+  size_t getSize() const;
+
+private:
+  void *m_data = nullptr;
+  size_t m_size = 0;
+};
+
+// Writes size bytes of data to path through a temporary file renamed over
+// it, so readers never see a half written file. Creates missing parent
+// directories, false if any step fails.
+bool writeFileAtomically(const std::string &path, const void *data,
+                         size_t size);
+
+#endif
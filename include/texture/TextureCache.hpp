@@ -0,0 +1,47 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+#include <string>
+
+#include "texture/CookedTexture.hpp"
+
+// cooked textures live here, relative to the project root
+#define TEXTURE_CACHE_DIRECTORY "/cooked"
+
+struct TextureLoadOptions {
+  TextureCookOptions cook;
+  // clamp instead of repeating textures that have alpha, for decals
+  bool clampWithAlpha = false;
+};
+
+// Loads images through a directory of cooked textures. The first load of a
+// source, or of one changed since, decodes and compresses it once; later
+// runs map the cooked file and upload its pre-built mip chain as is.
+// Compressed levels go to GL untouched when the driver has S3TC, otherwise
+// they are decoded to RGBA on the way.
+class TextureCache {
+public:
+  explicit TextureCache(const std::string &directory);
+
+  // GL texture name, 0 if the source can be neither cooked nor loaded
+  unsigned int load(const std::string &sourcePath,
+                    const TextureLoadOptions &options = TextureLoadOptions());
+  // cooks unless the cooked file is up to date, false on failure
+  bool cook(const std::string &sourcePath, const TextureCookOptions &options);
+
+  std::string getCookedPath(const std::string &sourcePath) const;
+  bool isFresh(const std::string &sourcePath,
+               const TextureCookOptions &options) const;
+
+  // cache in TEXTURE_CACHE_DIRECTORY
+  static TextureCache &getDefault();
+
+private:
+  std::string m_directory;
+
+  // cooked from the current source with the same options
+  bool matchesSource(const CookedTextureHeader &header,
+                     const std::string &sourcePath,
+                     const TextureCookOptions &options) const;
+};
+
+#endif
@@ -1,62 +1,176 @@
 #version 460 core
+// variant defines, ShaderVariants prepends the ones a draw selects
+#ifndef IMPOSTOR
+#define IMPOSTOR 0
+#endif
+#ifndef USE_TEXTURE
+#define USE_TEXTURE 0
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+// percentage closer filtering over a (2 * PCF_RADIUS + 1) texel square
+#ifndef PCF_RADIUS
+#define PCF_RADIUS 1
+#endif
+// flat color, for emissive objects like the light orbs
+#ifndef UNLIT
+#define UNLIT 0
+#endif
+
 out vec4 FragColor;
+#if IMPOSTOR
+// impostors push depth back onto the sphere, never forward, which keeps the
+// early depth test
+layout (depth_greater) out float gl_FragDepth;
+#endif
 
 in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
+    flat vec4 Sphere;
 } fs_in;
 
 uniform sampler2D diffuseTexture;
-uniform sampler2D shadowMap;
+uniform sampler2DArray shadowMap;
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 uniform vec3 color;
-uniform bool useTexture;
 uniform vec3 lightDirection;
+uniform mat4 view;
+uniform mat4 projection;
+
+// must match MAX_SHADOW_CASCADES
+uniform mat4 lightSpaceMatrices[4];
+uniform float cascadeFarPlanes[4];
+uniform float cascadeDepthBias[4];
+uniform int cascadeCount;
 
-float ShadowCalculation(vec4 fragPosLightSpace)
+// clustered point lights, see ClusteredLights
+struct PointLight {
+    vec4 positionRadius;
+    vec4 colorIntensity;
+};
+layout (std430, binding = 2) readonly buffer PointLights {
+    PointLight pointLights[];
+};
+// offset into lightIndices and count of each froxel
+layout (std430, binding = 3) readonly buffer LightClusters {
+    uvec2 lightClusters[];
+};
+layout (std430, binding = 4) readonly buffer LightIndices {
+    uint lightIndices[];
+};
+uniform ivec3 clusterGrid;
+// depth slice = log(view distance) * clusterScale + clusterBias
+uniform float clusterScale;
+uniform float clusterBias;
+
+float ShadowCalculation(vec3 fragPosWorldSpace, vec3 normal)
 {
+    // pick the first cascade whose frustum slice contains the fragment
+    float depthValue = abs((view * vec4(fragPosWorldSpace, 1.0)).z);
+    int layer = -1;
+    for (int i = 0; i < cascadeCount; ++i) {
+        if (depthValue < cascadeFarPlanes[i]) {
+            layer = i;
+            break;
+        }
+    }
+    // beyond the shadow distance
+    if (layer == -1)
+        return 0.0;
+
+    vec4 fragPosLightSpace = lightSpaceMatrices[layer] * vec4(fragPosWorldSpace, 1.0);
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
-    // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r;
     // get depth of current fragment from light's perspective
     float currentDepth = projCoords.z;
     // check whether current frag pos is in shadow
 
-    // repeated code from main
-    vec3 normal = normalize(fs_in.Normal);
-
     // this is for perspective light
     //vec3 lightDir = normalize(lightPos - fs_in.FragPos);
 
     // this is for orthogonal light
     vec3 lightDir = -lightDirection;
 
-    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+    // bias is measured in shadow map texels of the selected cascade
+    float bias = cascadeDepthBias[layer] * mix(4.0, 1.5, max(dot(normal, lightDir), 0.0));
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-    for (int x = -1; x <= 1; ++x) {
-        for (int y = -1; y <= 1; ++y) {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    for (int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x) {
+        for (int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y) {
+            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, layer)).r;
             shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
         }
     }
-    shadow /= 9.0;
+    shadow /= float((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
     if (projCoords.z > 1.0)
         shadow = 0.0;
     return shadow;
 }
 
+vec3 PointLighting(vec3 fragPos, vec3 normal, vec3 viewDir)
+{
+    // no lights were written this frame
+    if (clusterGrid.x == 0)
+        return vec3(0.0);
+    // the fragment's froxel: its screen tile and exponential depth slice
+    vec4 viewSpace = view * vec4(fragPos, 1.0);
+    vec4 clipPos = projection * viewSpace;
+    ivec2 tile = ivec2((clipPos.xy / clipPos.w * 0.5 + 0.5) * vec2(clusterGrid.xy));
+    tile = clamp(tile, ivec2(0), clusterGrid.xy - 1);
+    int slice = clamp(int(floor(log(-viewSpace.z) * clusterScale + clusterBias)), 0, clusterGrid.z - 1);
+    uvec2 range = lightClusters[(slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x];
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0; i < range.y; ++i) {
+        PointLight light = pointLights[lightIndices[range.x + i]];
+        vec3 toLight = light.positionRadius.xyz - fragPos;
+        float dist = length(toLight);
+        // inverse square, windowed to reach zero at the radius
+        float ratio = dist / light.positionRadius.w;
+        float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+        float attenuation = window * window / (dist * dist + 1.0);
+        vec3 lightDir = toLight / max(dist, 1e-4);
+        float diff = max(dot(normal, lightDir), 0.0);
+        float spec = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), 64.0);
+        result += (diff + spec) * attenuation * light.colorIntensity.rgb * light.colorIntensity.w;
+    }
+    return result;
+}
+
 void main()
 {           
-    vec3 color = useTexture ? texture(diffuseTexture, fs_in.TexCoords).rgb : color;
+#if UNLIT
+    FragColor = vec4(color, 1.0);
+    return;
+#endif
+    vec3 fragPos = fs_in.FragPos;
     vec3 normal = normalize(fs_in.Normal);
+#if IMPOSTOR
+    {
+        // intersect the eye ray through the quad with the sphere
+        vec3 rayDir = normalize(fs_in.FragPos - viewPos);
+        vec3 fromCenter = viewPos - fs_in.Sphere.xyz;
+        float b = dot(fromCenter, rayDir);
+        float c = dot(fromCenter, fromCenter) - fs_in.Sphere.w * fs_in.Sphere.w;
+        float h = b * b - c;
+        if (h < 0.0)
+            discard;
+        fragPos = viewPos + rayDir * (-b - sqrt(h));
+        normal = (fragPos - fs_in.Sphere.xyz) / fs_in.Sphere.w;
+        vec4 clipPos = projection * view * vec4(fragPos, 1.0);
+        gl_FragDepth = clipPos.z / clipPos.w * 0.5 + 0.5;
+    }
+#endif
+#if USE_TEXTURE
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+#endif
     vec3 lightColor = vec3(0.3);
     // ambient
     vec3 ambient = 0.3 * lightColor;
@@ -70,14 +184,19 @@ void main()
     float diff = max(dot(lightDir, normal), 0.0);
     vec3 diffuse = diff * lightColor;
     // specular
-    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 viewDir = normalize(viewPos - fragPos);
     float spec = 0.0;
     vec3 halfwayDir = normalize(lightDir + viewDir);  
     spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
     vec3 specular = spec * lightColor;    
     // calculate shadow
-    float shadow = ShadowCalculation(fs_in.FragPosLightSpace);       
-    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
+#if SHADOWS
+    float shadow = ShadowCalculation(fragPos, normal);
+#else
+    float shadow = 0.0;
+#endif
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular) +
+                     PointLighting(fragPos, normal, viewDir)) * color;
     
     FragColor = vec4(lighting, 1.0);
 }
@@ -1,25 +1,88 @@
 #version 460 core
+// variant defines, ShaderVariants prepends the ones a draw selects
+#ifndef IMPOSTOR
+#define IMPOSTOR 0
+#endif
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// skinned meshes blend up to four bones, weights sum to one
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+// instanced draws place each instance from its position and uniform scale
+layout (location = 7) in vec4 aInstance;
+
+// impostor draws pull a center and radius per sphere, six vertices each
+layout (std430, binding = 0) readonly buffer Spheres {
+    vec4 spheres[];
+};
+
+// skinned draws read instance i's bone palette at i * boneCount
+layout (std430, binding = 1) readonly buffer BonePalettes {
+    mat4 bones[];
+};
 
 out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
+    flat vec4 Sphere;
 } vs_out;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
-uniform mat4 lightSpaceMatrix;
+uniform vec3 viewPos;
+uniform bool instanced;
+uniform bool skinned;
+uniform int boneCount;
+
+const vec2 IMPOSTOR_CORNERS[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
 
 void main()
 {    
-    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
-    vs_out.Normal = normalize(transpose(inverse(mat3(model))) * aNormal);
+#if IMPOSTOR
+    {
+        vec4 sphere = spheres[gl_VertexID / 6];
+        vec2 corner = IMPOSTOR_CORNERS[gl_VertexID % 6];
+        vec3 toCenter = sphere.xyz - viewPos;
+        float dist = length(toCenter);
+        vec3 forward = toCenter / dist;
+        vec3 up = abs(forward.y) > 0.99 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+        vec3 right = normalize(cross(forward, up));
+        up = cross(right, forward);
+        // the quad touches the sphere's nearest point and covers its
+        // silhouette, so every surface hit lies behind it
+        float nearDist = max(dist - sphere.w, 1e-3);
+        float halfSize = nearDist * sphere.w / sqrt(max(dist * dist - sphere.w * sphere.w, 1e-6));
+        vs_out.FragPos = viewPos + forward * nearDist + (right * corner.x + up * corner.y) * halfSize;
+        vs_out.Normal = -forward;
+        vs_out.TexCoords = corner;
+        vs_out.Sphere = sphere;
+        gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
+        return;
+    }
+#endif
+    mat4 world = model;
+    if (instanced) {
+        // the instance places the model, model holds the mesh's node
+        mat4 instance = mat4(aInstance.w);
+        instance[3] = vec4(aInstance.xyz, 1.0);
+        world = instance * model;
+    }
+    if (skinned) {
+        int base = (gl_BaseInstance + gl_InstanceID) * boneCount;
+        mat4 skin = bones[base + aBoneIds.x] * aWeights.x
+                  + bones[base + aBoneIds.y] * aWeights.y
+                  + bones[base + aBoneIds.z] * aWeights.z
+                  + bones[base + aBoneIds.w] * aWeights.w;
+        world = world * skin;
+    }
+    vs_out.FragPos = vec3(world * vec4(aPos, 1.0));
+    vs_out.Normal = normalize(transpose(inverse(mat3(world))) * aNormal);
     vs_out.TexCoords = aTexCoords;
-    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    vs_out.Sphere = vec4(0.0);
     gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
 }
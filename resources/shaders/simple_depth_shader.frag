@@ -1,2 +1,29 @@
 #version 460
-void main() {}
+// variant defines, ShaderVariants prepends the ones a draw selects
+#ifndef IMPOSTOR
+#define IMPOSTOR 0
+#endif
+
+#if IMPOSTOR
+// impostors push depth back onto the sphere, never forward, which keeps the
+// early depth test
+layout (depth_greater) out float gl_FragDepth;
+#endif
+
+in vec3 gImpostor;
+
+uniform mat4 lightSpaceMatrices[4];
+uniform vec3 lightDirection;
+
+void main() {
+#if IMPOSTOR
+    float distSq = dot(gImpostor.xy, gImpostor.xy);
+    if (distSq > 1.0)
+        discard;
+    // the surface lies behind the quad along the light by the sphere's sag,
+    // the cascade projection is orthographic so depth is linear in it
+    float sag = gImpostor.z * (1.0 - sqrt(1.0 - distSq));
+    float depthPerUnit = 0.5 * (lightSpaceMatrices[gl_Layer] * vec4(lightDirection, 0.0)).z;
+    gl_FragDepth = gl_FragCoord.z + sag * depthPerUnit;
+#endif
+}
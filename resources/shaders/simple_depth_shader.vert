@@ -1,9 +1,70 @@
 #version 460 core
+// variant defines, ShaderVariants prepends the ones a draw selects
+#ifndef IMPOSTOR
+#define IMPOSTOR 0
+#endif
 layout (location = 0) in vec3 aPos;
+// skinned meshes blend up to four bones, weights sum to one
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+// instanced draws place each instance from its position and uniform scale
+layout (location = 7) in vec4 aInstance;
+
+// impostor draws pull a center and radius per sphere, six vertices each
+layout (std430, binding = 0) readonly buffer Spheres {
+    vec4 spheres[];
+};
+
+// skinned draws read instance i's bone palette at i * boneCount
+layout (std430, binding = 1) readonly buffer BonePalettes {
+    mat4 bones[];
+};
+
+// quad coordinates and radius of an impostor, zero for meshes
+out vec3 vImpostor;
 
-uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
+uniform vec3 lightDirection;
+uniform bool instanced;
+uniform bool skinned;
+uniform int boneCount;
+
+const vec2 IMPOSTOR_CORNERS[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
 
 void main() {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+#if IMPOSTOR
+    {
+        // the light is directional, so one quad facing it at the sphere's
+        // front serves every cascade
+        vec4 sphere = spheres[gl_VertexID / 6];
+        vec2 corner = IMPOSTOR_CORNERS[gl_VertexID % 6];
+        vec3 up = abs(lightDirection.y) > 0.99 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+        vec3 right = normalize(cross(lightDirection, up));
+        up = cross(right, lightDirection);
+        vec3 front = sphere.xyz - lightDirection * sphere.w;
+        gl_Position = vec4(front + (right * corner.x + up * corner.y) * sphere.w, 1.0);
+        vImpostor = vec3(corner, sphere.w);
+        return;
+    }
+#endif
+    mat4 world = model;
+    if (instanced) {
+        // the instance places the model, model holds the mesh's node
+        mat4 instance = mat4(aInstance.w);
+        instance[3] = vec4(aInstance.xyz, 1.0);
+        world = instance * model;
+    }
+    if (skinned) {
+        int base = (gl_BaseInstance + gl_InstanceID) * boneCount;
+        mat4 skin = bones[base + aBoneIds.x] * aWeights.x
+                  + bones[base + aBoneIds.y] * aWeights.y
+                  + bones[base + aBoneIds.z] * aWeights.z
+                  + bones[base + aBoneIds.w] * aWeights.w;
+        world = world * skin;
+    }
+    vImpostor = vec3(0.0);
+    // light space transform happens per cascade in the geometry shader
+    gl_Position = world * vec4(aPos, 1.0);
 }
@@ -14,11 +14,17 @@ Camera::Camera(const unsigned int scr_width, const unsigned int scr_height)
 
 void Camera::updateScreenDimensions(const unsigned int width,
                                     const unsigned int height) {
+  m_screenWidth = width;
+  m_screenHeight = height;
   m_projection =
       glm::perspective(glm::radians(m_fov), (float)width / (float)height,
                        m_nearPlane, m_farPlane);
 }
 
+unsigned int Camera::getScreenWidth() const { return m_screenWidth; }
+
+unsigned int Camera::getScreenHeight() const { return m_screenHeight; }
+
 glm::mat4 Camera::getProjection() const { return m_projection; }
 
 glm::mat4 Camera::getViewMatrix() const {
@@ -33,6 +39,14 @@ float Camera::getSpeed() const { return m_speed; }
 
 float Camera::getFov() const { return m_fov; }
 
+float Camera::getNearPlane() const { return m_nearPlane; }
+
+float Camera::getFarPlane() const { return m_farPlane; }
+
+float Camera::getAspectRatio() const {
+  return (float)m_screenWidth / (float)m_screenHeight;
+}
+
 void Camera::setFov(float fov) {
   m_fov = fov;
   m_projection = glm::perspective(glm::radians(m_fov),
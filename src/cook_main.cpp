@@ -0,0 +1,29 @@
+#include <cstring>
+#include <iostream>
+
+#include "texture/TextureCache.hpp"
+
+// Cooks textures ahead of time into the engine's texture cache, so the first
+// run after a checkout skips decoding and compression as well.
+int main(int argc, char **argv) {
+  TextureCookOptions options;
+  int cooked = 0;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--uncompressed") == 0) {
+      options.compress = false;
+      continue;
+    }
+    TextureCache &cache = TextureCache::getDefault();
+    if (!cache.cook(argv[i], options)) {
+      return 1;
+    }
+    std::cout << argv[i] << " -> " << cache.getCookedPath(argv[i])
+              << std::endl;
+    cooked++;
+  }
+  if (cooked == 0) {
+    std::cout << "usage: engine_cook [--uncompressed] <image>..." << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "input/CameraController.hpp"
+
+#include <cmath>
+
+#include "input/InputEvent.hpp"
+
+CameraController::CameraController(Camera &camera, const glm::vec3 boundsMin,
+                                   const glm::vec3 boundsMax)
+    : m_camera(camera), m_boundsMin(boundsMin), m_boundsMax(boundsMax) {}
+
+void CameraController::setKeys(uint32_t keys) { m_keys = keys; }
+
+uint32_t CameraController::getKeys() const { return m_keys; }
+
+void CameraController::update(float deltaTime) {
+  const float cameraSpeed = m_camera.getSpeed() * deltaTime;
+  glm::vec3 moveDirection(0.0f);
+  if (m_keys & MOVE_FORWARD)
+    moveDirection += m_camera.getFront() * glm::vec3(1, 0, 1);
+  if (m_keys & MOVE_BACKWARD)
+    moveDirection -= m_camera.getFront() * glm::vec3(1, 0, 1);
+  if (m_keys & MOVE_LEFT)
+    moveDirection -=
+        glm::normalize(glm::cross(m_camera.getFront(), m_camera.getUp()));
+  if (m_keys & MOVE_RIGHT)
+    moveDirection +=
+        glm::normalize(glm::cross(m_camera.getFront(), m_camera.getUp()));
+  if (m_keys & MOVE_UP)
+    moveDirection += glm::vec3(0.0f, 1.0f, 0.0f);
+  if (m_keys & MOVE_DOWN) {
+    moveDirection -= glm::vec3(0.0f, 1.0f, 0.0f);
+  }
+
+  if (glm::length(moveDirection) != 0.0f) {
+    moveDirection = glm::normalize(moveDirection);
+  }
+  glm::vec3 newPosition =
+      m_camera.getPosition() + (moveDirection * cameraSpeed);
+  // stay a little above the floor
+  glm::vec3 minPosition = m_boundsMin + glm::vec3(0.0f, 0.3f, 0.0f);
+  m_camera.setPosition(glm::clamp(newPosition, minPosition, m_boundsMax));
+}
+
+void CameraController::mouseMove(double xpos, double ypos) {
+  if (m_camera.isFirstMouse()) {
+    m_camera.setLastMousePos(xpos, ypos);
+    m_camera.setFirstMouse(false);
+  }
+  float xoffset = xpos - m_camera.getLastX();
+  float yoffset = m_camera.getLastY() - ypos;
+  m_camera.setLastMousePos(xpos, ypos);
+
+  xoffset *= m_sensitivity;
+  yoffset *= m_sensitivity;
+  m_camera.setYaw(m_camera.getYaw() + xoffset);
+  m_camera.setPitch(m_camera.getPitch() + yoffset);
+
+  if (m_camera.getPitch() > 89.0f)
+    m_camera.setPitch(89.0f);
+  if (m_camera.getPitch() < -89.0f)
+    m_camera.setPitch(-89.0f);
+
+  glm::vec3 direction;
+  direction.x = cos(glm::radians(m_camera.getYaw())) *
+                cos(glm::radians(m_camera.getPitch()));
+  direction.y = sin(glm::radians(m_camera.getPitch()));
+  direction.z = sin(glm::radians(m_camera.getYaw())) *
+                cos(glm::radians(m_camera.getPitch()));
+  m_camera.setFront(glm::normalize(direction));
+}
+
+void CameraController::scroll(double yoffset) {
+  m_camera.setFov(m_camera.getFov() - (float)yoffset);
+  if (m_camera.getFov() < 1.0f)
+    m_camera.setFov(1.0f);
+  if (m_camera.getFov() > 45.0f)
+    m_camera.setFov(45.0f);
+}
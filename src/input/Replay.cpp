@@ -0,0 +1,289 @@
+#include "input/Replay.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "physics/WorldSnapshot.hpp"
+
+// events are written to the OS once per this many frames, a crash loses at
+// most this much of the recording
+#define REPLAY_FLUSH_FRAMES 60
+
+namespace {
+template <typename T>
+void appendRaw(std::vector<unsigned char> &buffer, const T &value) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void appendVarint(std::vector<unsigned char> &buffer, uint64_t value) {
+  while (value >= 0x80) {
+    buffer.push_back((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back((unsigned char)value);
+}
+
+template <typename T> bool readRaw(std::ifstream &file, T &value) {
+  return (bool)file.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+bool readVarint(std::ifstream &file, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = file.get();
+    if (byte == EOF) {
+      return false;
+    }
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+bool ReplayRecorder::open(const std::string &path, const PhysicsWorld &world,
+                          const Camera &camera,
+                          const glm::vec3 cameraBoundsMin,
+                          const glm::vec3 cameraBoundsMax) {
+  m_file.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_file) {
+    std::cout << "ERROR::REPLAY::FILE_NOT_WRITABLE: " << path << std::endl;
+    return false;
+  }
+  WorldSnapshot snapshot;
+  world.saveSnapshot(snapshot);
+
+  ReplayHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = REPLAY_MAGIC;
+  header.version = REPLAY_VERSION;
+  header.deterministic = world.isDeterministic();
+  header.fixedTimestep = world.getFixedTimestep();
+  header.arenaMin = world.getBorderMin();
+  header.arenaMax = world.getBorderMax();
+  header.cameraBoundsMin = cameraBoundsMin;
+  header.cameraBoundsMax = cameraBoundsMax;
+  header.screenWidth = camera.getScreenWidth();
+  header.screenHeight = camera.getScreenHeight();
+  header.cameraPosition = camera.getPosition();
+  header.cameraFront = camera.getFront();
+  header.cameraYaw = camera.getYaw();
+  header.cameraPitch = camera.getPitch();
+  header.cameraFov = camera.getFov();
+  header.cameraLastX = camera.getLastX();
+  header.cameraLastY = camera.getLastY();
+  header.cameraFirstMouse = camera.isFirstMouse();
+  header.snapshotSize = snapshot.data.size();
+
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  m_file.write(reinterpret_cast<const char *>(snapshot.data.data()),
+               snapshot.data.size());
+  m_file.flush();
+  m_start = std::chrono::steady_clock::now();
+  m_lastTimeUs = 0;
+  return (bool)m_file;
+}
+
+bool ReplayRecorder::isOpen() const { return m_file.is_open(); }
+
+void ReplayRecorder::record(InputEvent event) {
+  if (!m_file.is_open()) {
+    return;
+  }
+  event.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - m_start)
+                     .count();
+  m_buffer.push_back((unsigned char)event.type);
+  appendVarint(m_buffer, event.timeUs - m_lastTimeUs);
+  m_lastTimeUs = event.timeUs;
+  switch (event.type) {
+  case InputEventType::Frame:
+    appendRaw(m_buffer, event.frameTime);
+    appendRaw(m_buffer, event.stateHash);
+    break;
+  case InputEventType::Keys:
+    appendVarint(m_buffer, event.keys);
+    break;
+  case InputEventType::MouseMove:
+    appendRaw(m_buffer, event.x);
+    appendRaw(m_buffer, event.y);
+    break;
+  case InputEventType::Scroll:
+    appendRaw(m_buffer, event.y);
+    break;
+  case InputEventType::Spawn:
+    appendRaw(m_buffer, event.position);
+    appendRaw(m_buffer, event.velocity);
+    appendRaw(m_buffer, event.radius);
+    break;
+  }
+
+  if (event.type == InputEventType::Frame) {
+    m_file.write(reinterpret_cast<const char *>(m_buffer.data()),
+                 m_buffer.size());
+    m_buffer.clear();
+    if (++m_framesSinceFlush >= REPLAY_FLUSH_FRAMES) {
+      m_file.flush();
+      m_framesSinceFlush = 0;
+    }
+  }
+}
+
+void ReplayRecorder::close() {
+  if (!m_file.is_open()) {
+    return;
+  }
+  m_file.write(reinterpret_cast<const char *>(m_buffer.data()),
+               m_buffer.size());
+  m_buffer.clear();
+  m_file.close();
+}
+
+bool ReplayPlayer::open(const std::string &path) {
+  m_file.open(path, std::ios::binary);
+  if (!m_file) {
+    std::cout << "ERROR::REPLAY::FILE_NOT_SUCCESSFULLY_READ: " << path
+              << std::endl;
+    return false;
+  }
+  if (!readRaw(m_file, m_header) || m_header.magic != REPLAY_MAGIC ||
+      m_header.version != REPLAY_VERSION) {
+    std::cout << "ERROR::REPLAY::INVALID_HEADER" << std::endl;
+    return false;
+  }
+  // the size is checked against the file before allocating for it
+  const std::streampos snapshotStart = m_file.tellg();
+  m_file.seekg(0, std::ios::end);
+  const std::streamoff remaining = m_file.tellg() - snapshotStart;
+  m_file.seekg(snapshotStart);
+  if (m_header.snapshotSize > (uint64_t)remaining) {
+    std::cout << "ERROR::REPLAY::TRUNCATED_SNAPSHOT" << std::endl;
+    return false;
+  }
+  WorldSnapshot snapshot;
+  snapshot.data.resize(m_header.snapshotSize);
+  if (!m_file.read(reinterpret_cast<char *>(snapshot.data.data()),
+                   snapshot.data.size())) {
+    std::cout << "ERROR::REPLAY::TRUNCATED_SNAPSHOT" << std::endl;
+    return false;
+  }
+
+  m_world = std::make_unique<PhysicsWorld>(m_header.arenaMin,
+                                           m_header.arenaMax);
+  m_world->setDeterministic(m_header.deterministic);
+  m_world->setFixedTimestep(m_header.fixedTimestep);
+  if (!m_world->restoreSnapshot(snapshot)) {
+    return false;
+  }
+
+  m_camera = std::make_unique<Camera>(m_header.screenWidth,
+                                      m_header.screenHeight);
+  m_camera->setPosition(m_header.cameraPosition);
+  m_camera->setFront(m_header.cameraFront);
+  m_camera->setYaw(m_header.cameraYaw);
+  m_camera->setPitch(m_header.cameraPitch);
+  m_camera->setFov(m_header.cameraFov);
+  m_camera->setLastMousePos(m_header.cameraLastX, m_header.cameraLastY);
+  m_camera->setFirstMouse(m_header.cameraFirstMouse);
+  m_controller = std::make_unique<CameraController>(
+      *m_camera, m_header.cameraBoundsMin, m_header.cameraBoundsMax);
+  return true;
+}
+
+bool ReplayPlayer::readEvent(InputEvent &event) {
+  int type = m_file.get();
+  uint64_t timeDelta;
+  if (type == EOF || !readVarint(m_file, timeDelta)) {
+    return false;
+  }
+  event.type = (InputEventType)type;
+  m_timeUs += timeDelta;
+  event.timeUs = m_timeUs;
+  uint64_t keys;
+  switch (event.type) {
+  case InputEventType::Frame:
+    return readRaw(m_file, event.frameTime) && readRaw(m_file, event.stateHash);
+  case InputEventType::Keys:
+    if (!readVarint(m_file, keys)) {
+      return false;
+    }
+    event.keys = keys;
+    return true;
+  case InputEventType::MouseMove:
+    return readRaw(m_file, event.x) && readRaw(m_file, event.y);
+  case InputEventType::Scroll:
+    return readRaw(m_file, event.y);
+  case InputEventType::Spawn:
+    return readRaw(m_file, event.position) &&
+           readRaw(m_file, event.velocity) && readRaw(m_file, event.radius);
+  }
+  std::cout << "ERROR::REPLAY::UNKNOWN_EVENT_TYPE: " << type << std::endl;
+  return false;
+}
+
+bool ReplayPlayer::step() {
+  InputEvent event;
+  if (!m_world) {
+    return false;
+  }
+  if (!readEvent(event)) {
+    // running out of file is the end or a partially written trailing event
+    // after a crash, anything else is corruption
+    if (!m_file.eof()) {
+      std::cout << "ERROR::REPLAY::CORRUPT_EVENT after frame " << m_frames
+                << std::endl;
+      m_readError = true;
+    }
+    return false;
+  }
+  switch (event.type) {
+  case InputEventType::Frame:
+    // same order as the engine's frame: camera first, then the world
+    m_controller->update(event.frameTime);
+    m_world->advance(event.frameTime);
+    m_frames++;
+    if (m_header.deterministic && !m_desynced &&
+        m_world->getStateHash() != event.stateHash) {
+      m_desynced = true;
+      m_desyncTick = m_world->getTick();
+    }
+    break;
+  case InputEventType::Keys:
+    m_controller->setKeys(event.keys);
+    break;
+  case InputEventType::MouseMove:
+    m_controller->mouseMove(event.x, event.y);
+    break;
+  case InputEventType::Scroll:
+    m_controller->scroll(event.y);
+    break;
+  case InputEventType::Spawn:
+    m_world->addBody(event.position, event.velocity, event.radius);
+    break;
+  }
+  return true;
+}
+
+bool ReplayPlayer::run() {
+  if (!m_world) {
+    return false;
+  }
+  while (step()) {
+  }
+  return !m_readError && !m_desynced;
+}
+
+PhysicsWorld &ReplayPlayer::getWorld() { return *m_world; }
+
+Camera &ReplayPlayer::getCamera() { return *m_camera; }
+
+unsigned int ReplayPlayer::getFrameCount() const { return m_frames; }
+
+uint64_t ReplayPlayer::getRecordedTimeUs() const { return m_timeUs; }
+
+bool ReplayPlayer::hasDesynced() const { return m_desynced; }
+
+uint64_t ReplayPlayer::getDesyncTick() const { return m_desyncTick; }
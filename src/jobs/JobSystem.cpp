@@ -0,0 +1,116 @@
+#include "jobs/JobSystem.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "profiling/Profiler.hpp"
+
+namespace {
+// set on a thread while it runs a chunk, nested loops then run inline
+thread_local bool t_inJob = false;
+} // namespace
+
+JobSystem::JobSystem(unsigned int workerCount) {
+  m_workers.reserve(workerCount);
+  for (unsigned int i = 0; i < workerCount; i++) {
+    m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+}
+
+void JobSystem::parallelFor(unsigned int count, unsigned int minChunk,
+                            const RangeJob &job) {
+  if (count == 0) {
+    return;
+  }
+  minChunk = std::max(minChunk, 1u);
+  if (m_workers.empty() || t_inJob || count <= minChunk) {
+    job(0, count);
+    return;
+  }
+  std::lock_guard<std::mutex> loopLock(m_loopMutex);
+  const unsigned int threads = m_workers.size() + 1;
+  const unsigned int chunkCount =
+      std::min((count + minChunk - 1) / minChunk,
+               threads * JOB_SYSTEM_CHUNKS_PER_THREAD);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &job;
+    m_count = count;
+    m_chunkSize = (count + chunkCount - 1) / chunkCount;
+    // rounding up the size may leave the last chunks empty
+    m_chunkCount = (count + m_chunkSize - 1) / m_chunkSize;
+    m_nextChunk = 0;
+    m_pendingChunks = m_chunkCount;
+    m_loop++;
+  }
+  m_wake.notify_all();
+
+  runChunks(job);
+
+  // workers still holding the job must leave before it goes out of scope
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock,
+              [&] { return m_pendingChunks == 0 && m_activeWorkers == 0; });
+  m_job = nullptr;
+}
+
+unsigned int JobSystem::getWorkerCount() const { return m_workers.size(); }
+
+JobSystem &JobSystem::getDefault() {
+  static JobSystem jobs(
+      std::max(std::thread::hardware_concurrency(), 1u) - 1);
+  return jobs;
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+  Profiler::setThreadName("worker " + std::to_string(index));
+  uint64_t seenLoop = 0;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_wake.wait(lock, [&] { return m_stopping || m_loop != seenLoop; });
+    if (m_stopping) {
+      return;
+    }
+    seenLoop = m_loop;
+    if (m_job == nullptr) {
+      continue;
+    }
+    const RangeJob &job = *m_job;
+    m_activeWorkers++;
+    lock.unlock();
+    runChunks(job);
+    lock.lock();
+    m_activeWorkers--;
+    if (m_activeWorkers == 0 && m_pendingChunks == 0) {
+      m_done.notify_all();
+    }
+  }
+}
+
+void JobSystem::runChunks(const RangeJob &job) {
+  t_inJob = true;
+  for (;;) {
+    const unsigned int chunk = m_nextChunk.fetch_add(1);
+    if (chunk >= m_chunkCount) {
+      break;
+    }
+    const unsigned int begin = chunk * m_chunkSize;
+    job(begin, std::min(begin + m_chunkSize, m_count));
+    if (m_pendingChunks.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done.notify_all();
+    }
+  }
+  t_inJob = false;
+}
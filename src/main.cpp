@@ -1,11 +1,12 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include <stb_image.h>
-
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/glm.hpp>
@@ -13,21 +14,77 @@
 #include "Camera.hpp"
 #include "Shader.hpp"
 #include "ProjectRoot.hpp"
+#include "input/CameraController.hpp"
+#include "input/Replay.hpp"
+#include "jobs/JobSystem.hpp"
+#include "memory/FrameArena.hpp"
+#include "model/Skeleton.hpp"
 #include "model/WorldObject.hpp"
+#include "net/ReplicationClient.hpp"
+#include "physics/BodyInterpolator.hpp"
+#include "physics/DefaultArena.hpp"
+#include "physics/PhysicsWorld.hpp"
+#include "physics/SimulationThread.hpp"
+#include "profiling/GpuTimer.hpp"
+#include "profiling/Profiler.hpp"
+#include "render/BonePalettes.hpp"
+#include "render/CascadedShadowMap.hpp"
+#include "render/ClusteredLights.hpp"
+#include "render/Frustum.hpp"
+#include "render/LodSelector.hpp"
+#include "render/ShaderVariants.hpp"
+#include "render/SphereImpostors.hpp"
+#include "render/StreamBuffer.hpp"
+#include "texture/TextureCache.hpp"
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
-void processInput(GLFWwindow *window);
+void processInput(GLFWwindow *window, SimulationThread &simulation,
+                  const PhysicsWorld &world);
 unsigned int loadTexture(char const *path);
 void renderQuad();
 void renderFloor(const Shader &shader);
+// Bodies is BodyInterpolator or ReplicationClient
+template <typename Bodies>
+void prepareBodies(const Model &model, const Bodies &bodies,
+                   const Frustum &view, StreamBuffer &stream);
+void renderBodies(Model &model, const SphereImpostors &impostors,
+                  unsigned int instanceBuffer, Shader &shader,
+                  Shader &impostorShader, bool shadowPass);
+template <typename Bodies>
+void prepareLights(const Model &orbModel, const Bodies &bodies,
+                   const glm::mat4 &view, const glm::mat4 &projection,
+                   ClusteredLights &lights, StreamBuffer &stream);
+void renderLightOrbs(Model &orbModel, Shader &shader);
+void placeCharacters(Model &model, unsigned int instanceBuffer);
+void animateCharacters(Model &model, BonePalettes &palettes,
+                       StreamBuffer &stream);
+void renderCharacters(Model &model, const BonePalettes &palettes,
+                      Shader &shader);
 void renderCube();
 
 // settings
 unsigned int DEFAULT_SCREEN_WIDTH = 1600;
 unsigned int DEFAULT_SCREEN_HEIGHT = 1200;
 
+// shadows
+const unsigned int SHADOW_RESOLUTION = 2048;
+const unsigned int SHADOW_CASCADES = 3;
+const float SHADOW_DISTANCE = 100.0f;
+// compiled into the scene shader variants: SHADOW_PCF_RADIUS 1 filters 3x3
+// texels, SHADOWS off also skips the shadow pass
+const bool SHADOWS = true;
+const int SHADOW_PCF_RADIUS = 1;
+
+// simulation, deterministic mode runs fixed steps independent of frame rate,
+// rendering blends the last two steps so the tick rate can stay low
+const bool DETERMINISTIC_SIMULATION = true;
+const float PHYSICS_TIMESTEP = 1.0f / 60.0f;
+// step physics on its own thread, paced by the clock rather than by vsync.
+// Recording keeps it on the main thread so events line up with frames.
+const bool SIMULATION_THREAD = true;
+
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -39,19 +96,73 @@ float cameraMinY = 0.0f;
 float cameraMaxY = 40.0f;
 float cameraMinZ = -40.0f;
 float cameraMaxZ = 40.0f;
+CameraController cameraController(camera,
+                                  glm::vec3(cameraMinX, cameraMinY,
+                                            cameraMinZ),
+                                  glm::vec3(cameraMaxX, cameraMaxY,
+                                            cameraMaxZ));
+
+// input recording, set ENGINE_RECORD=<path> to write a replay for
+// engine_replay, press E to throw a ball
+ReplayRecorder recorder;
+const float SPAWN_SPEED = 20.0f;
+const float SPAWN_RADIUS = 0.25f;
+
+// networked view, set ENGINE_CONNECT=<host>[:port] to render the bodies of an
+// engine_server instead of simulating locally
+ReplicationClient networkView;
+const float NET_INTEREST_RADIUS = 30.0f;
+const uint32_t NET_BYTES_PER_SECOND = 64 * 1024;
+
+// bodies are ray traced impostors by default, F4 switches to the sphere mesh
+// and its detail levels. F3 prints the bodies drawn per level.
+bool impostorBodies = true;
+LodSelector bodyLods;
+std::vector<LodBatch> bodyBatches;
+// mesh bodies outside the view, drawn into the shadow map only
+LodBatch shadowOnlyBodies;
+
+// the newest bodies, the balls thrown with E, carry glowing point lights,
+// shaded per froxel of the view in the main pass
+const unsigned int MAX_POINT_LIGHTS = 512;
+const float POINT_LIGHT_RADIUS = 6.0f;
+const float POINT_LIGHT_INTENSITY = 8.0f;
+const glm::vec3 POINT_LIGHT_COLOR = glm::vec3(1.0f, 0.55f, 0.2f);
+// lights each worker places per job
+const unsigned int LIGHTS_PER_JOB = 64;
+// body instances each worker writes per job
+const unsigned int BODIES_PER_JOB = 1024;
+// orbs are drawn this much larger than the body they sit on
+const float LIGHT_ORB_SCALE = 1.1f;
+// the orb instances of this frame's lights
+LodBatch lightOrbs;
+
+// animated crowd, set ENGINE_CHARACTER=<path> to a skinned model with
+// animations to walk a grid of copies over the floor. Each copy plays its
+// own clip and time. CPU_SKINNING poses the vertices on the CPU instead of
+// in the vertex shader, a reference path in which every copy takes the
+// first one's pose.
+const unsigned int CHARACTER_GRID = 16;
+const float CHARACTER_HEIGHT = 2.0f;
+const bool CPU_SKINNING = false;
+std::vector<CharacterPose> characterPoses;
+Aabb characterBounds;
+
+// per-frame instances, lights and palettes are written straight into a
+// persistently mapped ring, one region per frame in flight
+const size_t FRAME_STREAM_BYTES = 16 * 1024 * 1024;
 
 // meshes
-float borderMinX = -15.0f;
-float borderMaxX = 15.0f;
-float borderMinY = 0.0f;
-float borderMaxY = 8.0f;
-float borderMinZ = -15.0f;
-float borderMaxZ = 15.0f;
-std::vector<glm::vec3> corners = {
-    {borderMinX, borderMinY, borderMinZ}, {borderMinX, borderMinY, borderMaxZ},
-    {borderMinX, borderMaxY, borderMinZ}, {borderMinX, borderMaxY, borderMaxZ},
-    {borderMaxX, borderMinY, borderMinZ}, {borderMaxX, borderMinY, borderMaxZ},
-    {borderMaxX, borderMaxY, borderMinZ}, {borderMaxX, borderMaxY, borderMaxZ}};
+float borderMinX = DEFAULT_ARENA_MIN.x;
+float borderMaxX = DEFAULT_ARENA_MAX.x;
+float borderMinY = DEFAULT_ARENA_MIN.y;
+float borderMaxY = DEFAULT_ARENA_MAX.y;
+float borderMinZ = DEFAULT_ARENA_MIN.z;
+float borderMaxZ = DEFAULT_ARENA_MAX.z;
+// the floor plus every body this frame, fits the shadow depth range
+const Aabb floorBounds(glm::vec3(borderMinX, cameraMinY, borderMinZ),
+                       glm::vec3(borderMaxX, cameraMinY, borderMaxZ));
+Aabb sceneBounds = floorBounds;
 
 unsigned int planeVAO;
 float planeVertices[] = {
@@ -69,7 +180,7 @@ float planeVertices[] = {
  *  - spheres
  *  - rectangles
  * Render objects with solid colors
- *  - Shader should use bool uniform 'useTexture'
+ *  - Pick the USE_TEXTURE shader variant per object
  */
 int main() {
   glfwInit();
@@ -95,10 +206,6 @@ int main() {
     return -1;
   }
 
-  // tell stb_image to flip loaded texture's on the y-axis (before loading
-  // model)
-  stbi_set_flip_vertically_on_load(true);
-
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_CULL_FACE); // Enables face culling
   glCullFace(GL_BACK);    // Culls (hides) back faces
@@ -108,11 +215,24 @@ int main() {
   camera.setPosition(glm::vec3(borderMaxX, borderMaxY / 2, borderMaxZ));
   camera.lookAt(glm::vec3(0.0f, camera.getPosition().y, 0.0f));
 
-  Shader simpleDepthShader(
+  // one specialised program per kind of draw instead of uniform branches
+  ShaderVariants depthShaders(
       ProjectRoot::getPath("/resources/shaders/simple_depth_shader.vert"),
-      ProjectRoot::getPath("/resources/shaders/simple_depth_shader.frag"));
-  Shader shader(ProjectRoot::getPath("/resources/shaders/shadows.vert"),
-                ProjectRoot::getPath("/resources/shaders/shadows.frag"));
+      ProjectRoot::getPath("/resources/shaders/simple_depth_shader.frag"),
+      ProjectRoot::getPath("/resources/shaders/simple_depth_shader.geom"));
+  Shader &depthShader = depthShaders.get();
+  Shader &depthImpostorShader = depthShaders.get({{"IMPOSTOR", "1"}});
+  ShaderVariants sceneShaders(
+      ProjectRoot::getPath("/resources/shaders/shadows.vert"),
+      ProjectRoot::getPath("/resources/shaders/shadows.frag"), "",
+      {{"SHADOWS", SHADOWS ? "1" : "0"},
+       {"PCF_RADIUS", std::to_string(SHADOW_PCF_RADIUS)}});
+  Shader &floorShader = sceneShaders.get({{"USE_TEXTURE", "1"}});
+  Shader &meshShader = sceneShaders.get();
+  Shader &impostorShader = sceneShaders.get({{"IMPOSTOR", "1"}});
+  Shader &unlitShader = sceneShaders.get({{"UNLIT", "1"}});
+  Shader *const lightingShaders[] = {&floorShader, &meshShader,
+                                     &impostorShader, &unlitShader};
   Shader basicShader(
       ProjectRoot::getPath("/resources/shaders/basic_shader.vert"),
       ProjectRoot::getPath("/resources/shaders/basic_shader.frag"));
@@ -139,158 +259,233 @@ int main() {
   unsigned int woodTexture =
       loadTexture(ProjectRoot::getPath("/resources/wood.png").c_str());
 
-  const unsigned int SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
-  unsigned int depthMapFBO;
-  glGenFramebuffers(1, &depthMapFBO);
-  // create depth texture
-  unsigned int depthMap;
-  glGenTextures(1, &depthMap);
-  glBindTexture(GL_TEXTURE_2D, depthMap);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH,
-               SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-  float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-  // attach depth texture as FBO's depth buffer
-  glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                         depthMap, 0);
-  glDrawBuffer(GL_NONE);
-  glReadBuffer(GL_NONE);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  // shadow memory depends only on resolution and cascade count, not on the
+  // arena size
+  CascadedShadowMap cascadedShadowMap(SHADOW_RESOLUTION, SHADOW_CASCADES,
+                                      SHADOW_DISTANCE);
 
-  shader.use();
-  shader.setBool("useTexture", true);
-  shader.setInt("diffuseTexture", 0);
-  shader.setInt("shadowMap", 1);
+  for (Shader *variant : lightingShaders) {
+    variant->use();
+    variant->setInt("diffuseTexture", 0);
+    variant->setInt("shadowMap", 1);
+  }
 
   WorldObject sphere(ProjectRoot::getPath(
       "/resources/models/smooth_sphere/smooth_sphere.obj"));
-  sphere.setScale(glm::vec3(0.5f));
-  sphere.setPosition(glm::vec3(0.0f, 2.5f, 0.0f));
-  sphere.setVelocity(glm::vec3(40.0f, 40.0f, 20.0f));
+  StreamBuffer frameStream(FRAME_STREAM_BYTES);
+  // bodies are drawn instanced, one draw per detail level
+  sphere.getModel().setInstanceBuffer(frameStream.getBuffer());
+  SphereImpostors bodyImpostors;
+
+  std::unique_ptr<Model> character;
+  GlBuffer characterInstances = GlBuffer::create();
+  BonePalettes characterPalettes;
+  if (const char *characterPath = std::getenv("ENGINE_CHARACTER")) {
+    character = std::make_unique<Model>(characterPath, false, CPU_SKINNING);
+    if (character->isSkinned() && !character->getAnimations().empty()) {
+      placeCharacters(*character, characterInstances.get());
+    } else {
+      std::cout << "Character has no skinned mesh or animation: "
+                << characterPath << std::endl;
+      character.reset();
+    }
+  }
+
+  PhysicsWorld physicsWorld(glm::vec3(borderMinX, borderMinY, borderMinZ),
+                            glm::vec3(borderMaxX, borderMaxY, borderMaxZ));
+  physicsWorld.setDeterministic(DETERMINISTIC_SIMULATION);
+  physicsWorld.setFixedTimestep(PHYSICS_TIMESTEP);
+  physicsWorld.addBody(glm::vec3(0.0f, 2.5f, 0.0f),
+                       glm::vec3(40.0f, 40.0f, 20.0f), 0.5f);
+  BodyInterpolator renderBodyState;
+  renderBodyState.capture(physicsWorld, 0.0);
+
+  if (const char *recordPath = std::getenv("ENGINE_RECORD")) {
+    recorder.open(recordPath, physicsWorld, camera,
+                  glm::vec3(cameraMinX, cameraMinY, cameraMinZ),
+                  glm::vec3(cameraMaxX, cameraMaxY, cameraMaxZ));
+  }
+  if (const char *server = std::getenv("ENGINE_CONNECT")) {
+    networkView.connect(server);
+  }
+  const bool remoteView = networkView.isConnected();
+  SimulationThread simulation(physicsWorld);
+  if (SIMULATION_THREAD && !remoteView && !recorder.isOpen()) {
+    simulation.start();
+  }
 
   glm::vec3 lightPos = glm::vec3(borderMaxX, borderMaxY, borderMaxZ);
   WorldObject lightOrb(
       ProjectRoot::getPath("/resources/models/sphere/sphere.obj"));
+  lightOrb.getModel().setInstanceBuffer(frameStream.getBuffer());
+  ClusteredLights pointLights;
 
-  glm::mat4 lightProjection, lightView;
-  glm::mat4 lightSpaceMatrix;
-  float near_plane = 0.1f,
-        far_plane = std::sqrt(std::pow(borderMaxX - borderMinX, 2) +
-                              std::pow(borderMaxY - borderMinY, 2) +
-                              std::pow(borderMaxZ - borderMinZ, 2));
-  lightView =
-      glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-  // transform world corners into light space
-  std::vector<glm::vec3> lightSpaceCorners;
-  for (glm::vec3 &corner : corners) {
-    glm::vec4 transformed = lightView * glm::vec4(corner, 1.0f);
-    lightSpaceCorners.push_back(glm::vec3(transformed));
-  }
-  // find min/max of lightspace
-  float x1 = std::numeric_limits<float>::max();
-  float x2 = std::numeric_limits<float>::lowest();
-  float y1 = std::numeric_limits<float>::max();
-  float y2 = std::numeric_limits<float>::lowest();
-  for (glm::vec3 &v : lightSpaceCorners) {
-    x1 = std::min(x1, v.x);
-    x2 = std::max(x2, v.x);
-    y1 = std::min(y1, v.y);
-    y2 = std::max(y2, v.y);
-  }
-
-  lightProjection = glm::ortho(x1, x2, y1, y2, near_plane, far_plane);
   glm::vec3 lightDirection = glm::normalize(glm::vec3(0.0f) - lightPos);
-  lightSpaceMatrix = lightProjection * lightView;
+  // shadow impostors face the light
+  depthImpostorShader.use();
+  depthImpostorShader.setVec3("lightDirection", lightDirection);
+
+  // frame instrumentation, set ENGINE_TRACE=<path> to dump a Chrome trace on
+  // exit and press F3 for the last frame's breakdown
+  Profiler::setThreadName("main");
+  GpuTimer gpuTimer;
+  const unsigned int shadowPassTimer = gpuTimer.addPass("shadow pass");
+  const unsigned int mainPassTimer = gpuTimer.addPass("main pass");
 
   bool firstErr = false;
   while (!glfwWindowShouldClose(window)) {
+    Profiler::beginFrame();
+    FrameArena::forThread().reset();
+    frameStream.beginFrame();
+    gpuTimer.beginFrame();
+    PROFILE_SCOPE("frame");
+
     /*** per-frame time logic ***/
     float currentFrame = glfwGetTime();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
     /*** Input ***/
-    processInput(window);
+    {
+      PROFILE_SCOPE("input");
+      processInput(window, simulation, physicsWorld);
+    }
 
     /*** World tick ***/
-    glm::vec3 newPosition =
-        sphere.getPosition() + (deltaTime * sphere.getVelocity());
-    if (newPosition.x <= borderMinX) {
-      sphere.setVelocity(sphere.getVelocity() * glm::vec3(-1.0f, 1.0f, 1.0f));
-      newPosition.x = borderMinX;
-    }
-    if (newPosition.x >= borderMaxX) {
-      sphere.setVelocity(sphere.getVelocity() * glm::vec3(-1.0f, 1.0f, 1.0f));
-      newPosition.x = borderMaxX;
+    if (remoteView) {
+      networkView.setView(camera.getPosition(), NET_INTEREST_RADIUS,
+                          NET_BYTES_PER_SECOND);
+      networkView.update(deltaTime);
+    } else if (simulation.isRunning()) {
+      if (simulation.acquireFrame()) {
+        renderBodyState.capture(simulation.getFrame());
+      }
+      renderBodyState.sample(simulation.getTime() - PHYSICS_TIMESTEP);
+    } else {
+      if (physicsWorld.advance(deltaTime) > 0) {
+        renderBodyState.capture(physicsWorld, physicsWorld.getTick() *
+                                                  (double)PHYSICS_TIMESTEP);
+      }
+      // one step behind, so there is a newer state to blend towards
+      renderBodyState.sample(
+          ((double)physicsWorld.getTick() - 1.0 +
+           physicsWorld.getInterpolationAlpha()) *
+          PHYSICS_TIMESTEP);
+      InputEvent frameEvent;
+      frameEvent.type = InputEventType::Frame;
+      frameEvent.frameTime = deltaTime;
+      frameEvent.stateHash = physicsWorld.getStateHash();
+      recorder.record(frameEvent);
     }
-    if (newPosition.y <= borderMinY) {
-      sphere.setVelocity(sphere.getVelocity() * glm::vec3(1.0f, -1.0f, 1.0f));
-      newPosition.y = borderMinY;
-    }
-    if (newPosition.y >= borderMaxY) {
-      sphere.setVelocity(sphere.getVelocity() * glm::vec3(1.0f, -1.0f, 1.0f));
-      newPosition.y = borderMaxY;
+
+    /*** Rendering commands here ***/
+    glm::mat4 projection = glm::perspective(
+        glm::radians(camera.getFov()),
+        (float)DEFAULT_SCREEN_WIDTH / (float)DEFAULT_SCREEN_HEIGHT,
+        camera.getNearPlane(), camera.getFarPlane());
+    glm::mat4 view = camera.getViewMatrix();
+    {
+      PROFILE_SCOPE("render.lod");
+      bodyLods.setView(camera);
+      const Frustum viewFrustum(projection * view);
+      if (remoteView) {
+        prepareBodies(sphere.getModel(), networkView, viewFrustum,
+                      frameStream);
+      } else {
+        prepareBodies(sphere.getModel(), renderBodyState, viewFrustum,
+                      frameStream);
+      }
     }
-    if (newPosition.z <= borderMinZ) {
-      sphere.setVelocity(sphere.getVelocity() * glm::vec3(1.0f, 1.0f, -1.0f));
-      newPosition.z = borderMinZ;
+    {
+      PROFILE_SCOPE("render.lights");
+      if (remoteView) {
+        prepareLights(lightOrb.getModel(), networkView, view, projection,
+                      pointLights, frameStream);
+      } else {
+        prepareLights(lightOrb.getModel(), renderBodyState, view,
+                      projection, pointLights, frameStream);
+      }
     }
-    if (newPosition.z >= borderMaxZ) {
-      sphere.setVelocity(sphere.getVelocity() * glm::vec3(1.0f, 1.0f, -1.0f));
-      newPosition.z = borderMaxZ;
+    if (character) {
+      PROFILE_SCOPE("animation");
+      animateCharacters(*character, characterPalettes, frameStream);
     }
-    sphere.setPosition(newPosition);
-
-    /*** Rendering commands here ***/
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     /* Render shadows */
-    simpleDepthShader.use();
-    simpleDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, woodTexture);
-    renderFloor(simpleDepthShader);
-    sphere.Draw(simpleDepthShader);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (SHADOWS) {
+      PROFILE_SCOPE("render.shadow");
+      gpuTimer.begin(shadowPassTimer);
+      // all cascades in one pass, the geometry shader routes to each layer
+      cascadedShadowMap.update(camera, lightDirection, sceneBounds);
+      depthImpostorShader.use();
+      cascadedShadowMap.setDepthUniforms(depthImpostorShader);
+      depthShader.use();
+      cascadedShadowMap.setDepthUniforms(depthShader);
+      cascadedShadowMap.bindForWriting();
+      glClear(GL_DEPTH_BUFFER_BIT);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, woodTexture);
+      renderFloor(depthShader);
+      renderBodies(sphere.getModel(), bodyImpostors, frameStream.getBuffer(),
+                   depthShader, depthImpostorShader, true);
+      if (character) {
+        renderCharacters(*character, characterPalettes, depthShader);
+      }
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      gpuTimer.end();
+    }
 
     // reset viewport
     glViewport(0, 0, DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     /* Render scene */
-    shader.use();
-    shader.setBool("useTexture", true);
-    glm::mat4 projection = glm::perspective(glm::radians(camera.getFov()),
-                                            (float)DEFAULT_SCREEN_WIDTH /
-                                                (float)DEFAULT_SCREEN_HEIGHT,
-                                            0.1f, 100.0f);
-    glm::mat4 view = camera.getViewMatrix();
-    shader.setMat4("projection", projection);
-    shader.setMat4("view", view);
-    shader.setVec3("viewPos", camera.getPosition());
-    shader.setVec3("lightPos", lightPos);
-    shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-    shader.setVec3("lightDirection", lightDirection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, woodTexture);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    renderFloor(shader);
-    shader.setBool("useTexture", false);
-    shader.setVec3("color", glm::vec3(0.5f, 0.0f, 0.0f));
-    sphere.Draw(shader);
-
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    {
+      PROFILE_SCOPE("render.main");
+      gpuTimer.begin(mainPassTimer);
+      for (Shader *variant : lightingShaders) {
+        variant->use();
+        variant->setMat4("projection", projection);
+        variant->setMat4("view", view);
+        variant->setVec3("viewPos", camera.getPosition());
+        variant->setVec3("lightPos", lightPos);
+        variant->setVec3("lightDirection", lightDirection);
+        variant->setVec3("color", glm::vec3(0.5f, 0.0f, 0.0f));
+        cascadedShadowMap.setLightingUniforms(*variant);
+        pointLights.bind(*variant);
+      }
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, woodTexture);
+      cascadedShadowMap.bindTexture(1);
+      floorShader.use();
+      renderFloor(floorShader);
+      renderBodies(sphere.getModel(), bodyImpostors, frameStream.getBuffer(),
+                   meshShader, impostorShader, false);
+      if (character) {
+        meshShader.use();
+        meshShader.setVec3("color", glm::vec3(0.2f, 0.3f, 0.6f));
+        renderCharacters(*character, characterPalettes, meshShader);
+      }
+      renderLightOrbs(lightOrb.getModel(), unlitShader);
+      gpuTimer.end();
+    }
+    frameStream.endFrame();
+
+    {
+      PROFILE_SCOPE("swap");
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+    }
+  }
+
+  simulation.stop();
+  recorder.close();
+  if (const char *tracePath = std::getenv("ENGINE_TRACE")) {
+    if (!Profiler::writeChromeTrace(tracePath)) {
+      std::cout << "Failed to write trace to: " << tracePath << std::endl;
+    }
   }
 
   glfwTerminate();
@@ -302,115 +497,110 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
   camera.updateScreenDimensions(width, height);
 }
 
-void processInput(GLFWwindow *window) {
+void processInput(GLFWwindow *window, SimulationThread &simulation,
+                  const PhysicsWorld &world) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(window, true);
-  const float cameraSpeed = camera.getSpeed() * deltaTime;
-  glm::vec3 moveDirection(0.0f);
+  // print on press, not every frame the key is held
+  static bool breakdownKeyDown = false;
+  bool breakdownKey = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+  if (breakdownKey && !breakdownKeyDown) {
+    for (const auto &[name, ns] : Profiler::lastFrameBreakdown()) {
+      std::cout << name << ": " << ns / 1000.0 << " us" << std::endl;
+    }
+    const FrameArena &frameArena = FrameArena::forThread();
+    const FrameArena &stepArena = world.getStepArena();
+    std::cout << "frame arena peak: " << frameArena.getPeak() / 1024.0
+              << " KiB of " << frameArena.getCapacity() / 1024.0 << " KiB"
+              << std::endl;
+    std::cout << "step arena peak: " << stepArena.getPeak() / 1024.0
+              << " KiB of " << stepArena.getCapacity() / 1024.0 << " KiB"
+              << std::endl;
+    if (impostorBodies) {
+      std::cout << "bodies drawn as impostors: "
+                << (bodyBatches.empty() ? 0 : bodyBatches[0].count)
+                << std::endl;
+    } else {
+      for (unsigned int lod = 0; lod < bodyBatches.size(); lod++) {
+        std::cout << "bodies at detail level " << lod << ": "
+                  << bodyBatches[lod].count << std::endl;
+      }
+      std::cout << "bodies outside the view: " << shadowOnlyBodies.count
+                << std::endl;
+    }
+  }
+  breakdownKeyDown = breakdownKey;
+
+  static bool impostorKeyDown = false;
+  bool impostorKey = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+  if (impostorKey && !impostorKeyDown) {
+    impostorBodies = !impostorBodies;
+    std::cout << (impostorBodies ? "bodies drawn as impostors"
+                                 : "bodies drawn as meshes")
+              << std::endl;
+  }
+  impostorKeyDown = impostorKey;
+
+  uint32_t keys = 0;
   if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-    moveDirection += camera.getFront() * glm::vec3(1, 0, 1);
+    keys |= MOVE_FORWARD;
   if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-    moveDirection -= camera.getFront() * glm::vec3(1, 0, 1);
+    keys |= MOVE_BACKWARD;
   if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-    moveDirection -=
-        glm::normalize(glm::cross(camera.getFront(), camera.getUp()));
+    keys |= MOVE_LEFT;
   if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-    moveDirection +=
-        glm::normalize(glm::cross(camera.getFront(), camera.getUp()));
+    keys |= MOVE_RIGHT;
   if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-    moveDirection += glm::vec3(0.0f, 1.0f, 0.0f);
-  if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
-    moveDirection -= glm::vec3(0.0f, 1.0f, 0.0f);
-  }
-
-  if (glm::length(moveDirection) != 0.0f) {
-    moveDirection = glm::normalize(moveDirection);
-  }
-  glm::vec3 newPosition = camera.getPosition() + (moveDirection * cameraSpeed);
-  if (newPosition.x < cameraMinX)
-    newPosition.x = cameraMinX;
-  if (newPosition.x > cameraMaxX)
-    newPosition.x = cameraMaxX;
-  if (newPosition.y < cameraMinY + 0.3f)
-    newPosition.y = cameraMinY + 0.3f;
-  if (newPosition.y > cameraMaxY)
-    newPosition.y = cameraMaxY;
-  if (newPosition.z < cameraMinZ)
-    newPosition.z = cameraMinZ;
-  if (newPosition.z > cameraMaxZ)
-    newPosition.z = cameraMaxZ;
-  camera.setPosition(newPosition);
+    keys |= MOVE_UP;
+  if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+    keys |= MOVE_DOWN;
+  if (keys != cameraController.getKeys()) {
+    InputEvent event;
+    event.type = InputEventType::Keys;
+    event.keys = keys;
+    recorder.record(event);
+    cameraController.setKeys(keys);
+  }
+  cameraController.update(deltaTime);
+
+  static bool spawnKeyDown = false;
+  bool spawnKey = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+  if (spawnKey && !spawnKeyDown) {
+    InputEvent event;
+    event.type = InputEventType::Spawn;
+    event.position = camera.getPosition() + camera.getFront();
+    event.velocity = camera.getFront() * SPAWN_SPEED;
+    event.radius = SPAWN_RADIUS;
+    recorder.record(event);
+    simulation.addBody(event.position, event.velocity, event.radius);
+  }
+  spawnKeyDown = spawnKey;
 }
 
 void mouse_callback(GLFWwindow *window, double xpos, double ypos) {
-  if (camera.isFirstMouse()) {
-    camera.setLastMousePos(xpos, ypos);
-    camera.setFirstMouse(false);
-  }
-  float xoffset = xpos - camera.getLastX();
-  float yoffset = camera.getLastY() - ypos;
-  camera.setLastMousePos(xpos, ypos);
-
-  const float sensitivity = 0.04f;
-  xoffset *= sensitivity;
-  yoffset *= sensitivity;
-  camera.setYaw(camera.getYaw() + xoffset);
-  camera.setPitch(camera.getPitch() + yoffset);
-
-  if (camera.getPitch() > 89.0f)
-    camera.setPitch(89.0f);
-  if (camera.getPitch() < -89.0f)
-    camera.setPitch(-89.0f);
-
-  glm::vec3 direction;
-  direction.x =
-      cos(glm::radians(camera.getYaw())) * cos(glm::radians(camera.getPitch()));
-  direction.y = sin(glm::radians(camera.getPitch()));
-  direction.z =
-      sin(glm::radians(camera.getYaw())) * cos(glm::radians(camera.getPitch()));
-  camera.setFront(glm::normalize(direction));
+  InputEvent event;
+  event.type = InputEventType::MouseMove;
+  event.x = xpos;
+  event.y = ypos;
+  recorder.record(event);
+  cameraController.mouseMove(xpos, ypos);
 }
 
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
-  camera.setFov(camera.getFov() - (float)yoffset);
-  if (camera.getFov() < 1.0f)
-    camera.setFov(1.0f);
-  if (camera.getFov() > 45.0f)
-    camera.setFov(45.0f);
+  InputEvent event;
+  event.type = InputEventType::Scroll;
+  event.y = yoffset;
+  recorder.record(event);
+  cameraController.scroll(yoffset);
 }
 
 unsigned int loadTexture(char const *path) {
-  unsigned int textureID;
-  glGenTextures(1, &textureID);
-
-  int width, height, nrComponents;
-  unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-  if (data) {
-    GLenum format;
-    if (nrComponents == 1)
-      format = GL_RED;
-    else if (nrComponents == 3)
-      format = GL_RGB;
-    else if (nrComponents == 4)
-      format = GL_RGBA;
-
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-                    format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-                    format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-  } else {
+  // cooked once into a compressed mip chain, mapped on later runs
+  TextureLoadOptions options;
+  options.clampWithAlpha = true;
+  unsigned int textureID = TextureCache::getDefault().load(path, options);
+  if (textureID == 0) {
     std::cout << "Texture failed to load at path: " << path << std::endl;
-    stbi_image_free(data);
   }
   return textureID;
 }
@@ -451,6 +641,272 @@ void renderFloor(const Shader &shader) {
   glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
+// Writes one instance per body to stream and refits sceneBounds.
+// Impostors take center and radius and draw every body in one batch in body
+// order, the ones outside the view are clipped on the GPU. For the mesh, each
+// visible body's detail level is selected and the instances are grouped by
+// level into bodyBatches; their scale and offset place the model's bounding
+// sphere on the body. Bodies outside the view go last, in shadowOnlyBodies.
+// Levels are remembered by body index, so a despawn that moves a body only
+// costs it one frame of hysteresis.
+//
+// The first pass only sorts bodies into batches. Once the batch sizes are
+// known, the worker threads write the instances straight into the stream.
+template <typename Bodies>
+void prepareBodies(const Model &model, const Bodies &bodies,
+                   const Frustum &view, StreamBuffer &stream) {
+  const std::vector<float> &levelErrors = model.getLodErrors();
+  const BoundingSphere &modelSphere = model.getBoundingSphere();
+  const float modelRadius =
+      modelSphere.isEmpty() ? 1.0f : std::max(modelSphere.radius, 1e-6f);
+  const unsigned int bodyCount = bodies.getBodyCount();
+  // batch of each body, the levels and then the bodies outside the view
+  const unsigned int levelCount = impostorBodies ? 1 : levelErrors.size();
+  const bool meshBatches = !impostorBodies && levelCount > 0;
+  bodyBatches.assign(levelCount, LodBatch());
+  shadowOnlyBodies = LodBatch();
+  FrameArena &arena = FrameArena::forThread();
+  FrameVector<uint8_t> batches(&arena);
+  if (meshBatches) {
+    bodyLods.resize(bodyCount);
+    batches.resize(bodyCount);
+  }
+  sceneBounds = floorBounds;
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    const glm::vec3 center = bodies.getPosition(i);
+    const float radius = bodies.getRadius(i);
+    sceneBounds.expand(Aabb(center - radius, center + radius));
+    if (meshBatches) {
+      batches[i] = view.intersects(center, radius)
+                       ? bodyLods.select(i, center, radius / modelRadius,
+                                         levelErrors)
+                       : levelCount;
+      LodBatch &batch =
+          batches[i] < levelCount ? bodyBatches[batches[i]] : shadowOnlyBodies;
+      batch.count++;
+    }
+  }
+  if (levelCount == 0) {
+    return;
+  }
+  if (impostorBodies) {
+    bodyBatches[0].count = bodyCount;
+  }
+
+  size_t offset = 0;
+  glm::vec4 *instances = stream.allocate<glm::vec4>(bodyCount, offset);
+  if (!instances) {
+    bodyBatches.clear();
+    return;
+  }
+  // batches index instances from the start of the stream
+  const unsigned int base = offset / sizeof(glm::vec4);
+  unsigned int first = base;
+  for (LodBatch &batch : bodyBatches) {
+    batch.first = first;
+    first += batch.count;
+  }
+  shadowOnlyBodies.first = first;
+
+  JobSystem &jobs = JobSystem::getDefault();
+  if (impostorBodies) {
+    jobs.parallelFor(bodyCount, BODIES_PER_JOB,
+                     [&](unsigned int begin, unsigned int end) {
+                       for (unsigned int i = begin; i < end; i++) {
+                         instances[i] = glm::vec4(bodies.getPosition(i),
+                                                  bodies.getRadius(i));
+                       }
+                     });
+    return;
+  }
+  // each body's place in the stream, bodies keep their order in a batch
+  FrameVector<unsigned int> fill(levelCount + 1, &arena);
+  for (unsigned int lod = 0; lod < levelCount; lod++) {
+    fill[lod] = bodyBatches[lod].first - base;
+  }
+  fill[levelCount] = shadowOnlyBodies.first - base;
+  FrameVector<unsigned int> slots(bodyCount, &arena);
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    slots[i] = fill[batches[i]]++;
+  }
+  jobs.parallelFor(
+      bodyCount, BODIES_PER_JOB, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+          const float scale = bodies.getRadius(i) / modelRadius;
+          instances[slots[i]] = glm::vec4(
+              bodies.getPosition(i) - modelSphere.center * scale, scale);
+        }
+      });
+}
+
+// One impostor draw with impostorShader, or one instanced draw with shader
+// per detail level of the batches prepareBodies built. Impostors always draw
+// every body. For meshes the shadow pass also draws the bodies outside the
+// view at the coarsest level, they may still cast into it.
+void renderBodies(Model &model, const SphereImpostors &impostors,
+                  unsigned int instanceBuffer, Shader &shader,
+                  Shader &impostorShader, bool shadowPass) {
+  if (bodyBatches.empty()) {
+    return;
+  }
+  if (impostorBodies) {
+    impostors.draw(impostorShader, instanceBuffer,
+                   bodyBatches[0].first * sizeof(glm::vec4),
+                   bodyBatches[0].count);
+    return;
+  }
+  const unsigned int shadowOnlyCount =
+      shadowPass ? shadowOnlyBodies.count : 0;
+  shader.use();
+  shader.setBool("instanced", true);
+  for (unsigned int lod = 0; lod < bodyBatches.size(); lod++) {
+    if (bodyBatches[lod].count > 0) {
+      model.DrawInstanced(shader, lod, bodyBatches[lod].count,
+                          bodyBatches[lod].first);
+    }
+  }
+  if (shadowOnlyCount > 0) {
+    model.DrawInstanced(shader, bodyBatches.size() - 1, shadowOnlyCount,
+                        shadowOnlyBodies.first);
+  }
+  shader.setBool("instanced", false);
+}
+
+// One point light per body from the newest back, up to MAX_POINT_LIGHTS,
+// assigned to the froxels of the view. The orbs marking them are written
+// to stream as the lightOrbs instances, placed over their bodies like the
+// body meshes, by the worker threads that build the lights.
+template <typename Bodies>
+void prepareLights(const Model &orbModel, const Bodies &bodies,
+                   const glm::mat4 &view, const glm::mat4 &projection,
+                   ClusteredLights &lights, StreamBuffer &stream) {
+  const unsigned int bodyCount = bodies.getBodyCount();
+  const unsigned int lightCount = std::min(bodyCount, MAX_POINT_LIGHTS);
+  const BoundingSphere &orbSphere = orbModel.getBoundingSphere();
+  const float orbRadius =
+      orbSphere.isEmpty() ? 1.0f : std::max(orbSphere.radius, 1e-6f);
+  // the lights are read back by the cluster assignment, the orbs never
+  FrameVector<PointLight> lit(lightCount, &FrameArena::forThread());
+  size_t offset = 0;
+  glm::vec4 *orbs = stream.allocate<glm::vec4>(lightCount, offset);
+  JobSystem::getDefault().parallelFor(
+      lightCount, LIGHTS_PER_JOB, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+          const unsigned int body = bodyCount - 1 - i;
+          const glm::vec3 center = bodies.getPosition(body);
+          lit[i].position = center;
+          lit[i].radius = POINT_LIGHT_RADIUS;
+          lit[i].color = POINT_LIGHT_COLOR;
+          lit[i].intensity = POINT_LIGHT_INTENSITY;
+          if (orbs) {
+            const float scale =
+                bodies.getRadius(body) * LIGHT_ORB_SCALE / orbRadius;
+            orbs[i] = glm::vec4(center - orbSphere.center * scale, scale);
+          }
+        }
+      });
+  lights.update(view, projection, camera.getNearPlane(),
+                camera.getFarPlane(), lit.data(), lightCount, stream);
+  lightOrbs.first = offset / sizeof(glm::vec4);
+  lightOrbs.count = orbs ? lightCount : 0;
+}
+
+// the orbs glow in the lights' color, they cast no shadow
+void renderLightOrbs(Model &orbModel, Shader &shader) {
+  if (lightOrbs.count == 0) {
+    return;
+  }
+  shader.use();
+  shader.setVec3("color", POINT_LIGHT_COLOR);
+  shader.setBool("instanced", true);
+  orbModel.DrawInstanced(shader, 0, lightOrbs.count, lightOrbs.first);
+  shader.setBool("instanced", false);
+}
+
+// Stands one copy of the character on the floor per grid cell, scaled to
+// CHARACTER_HEIGHT, and starts each on a clip and time of its own.
+void placeCharacters(Model &model, unsigned int instanceBuffer) {
+  const Aabb &bounds = model.getBounds();
+  const float height = std::max(bounds.max.y - bounds.min.y, 1e-6f);
+  const float scale = CHARACTER_HEIGHT / height;
+  const glm::vec3 foot(bounds.getCenter().x, bounds.min.y,
+                       bounds.getCenter().z);
+  const unsigned int clipCount = model.getAnimations().size();
+  const float cellX = (borderMaxX - borderMinX) / CHARACTER_GRID;
+  const float cellZ = (borderMaxZ - borderMinZ) / CHARACTER_GRID;
+  std::vector<glm::vec4> instances;
+  characterPoses.clear();
+  characterBounds = Aabb();
+  for (unsigned int z = 0; z < CHARACTER_GRID; z++) {
+    for (unsigned int x = 0; x < CHARACTER_GRID; x++) {
+      const unsigned int i = z * CHARACTER_GRID + x;
+      const glm::vec3 position(borderMinX + (x + 0.5f) * cellX, cameraMinY,
+                               borderMinZ + (z + 0.5f) * cellZ);
+      instances.push_back(glm::vec4(position - foot * scale, scale));
+      CharacterPose pose;
+      pose.clip = i % clipCount;
+      pose.time = model.getAnimations()[pose.clip].getDuration() * i /
+                  (CHARACTER_GRID * CHARACTER_GRID);
+      characterPoses.push_back(pose);
+      // limbs leave the bind pose box, a character height of slack
+      const glm::vec3 base = glm::vec3(instances.back());
+      characterBounds.expand(
+          Aabb(base + bounds.min * scale - CHARACTER_HEIGHT,
+               base + bounds.max * scale + CHARACTER_HEIGHT));
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec4),
+               instances.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  model.setInstanceBuffer(instanceBuffer);
+}
+
+// Advances every character's clip and has the pose jobs write their
+// palettes straight into stream, or skins the mesh on the CPU with the
+// first character's palette.
+void animateCharacters(Model &model, BonePalettes &palettes,
+                       StreamBuffer &stream) {
+  const std::vector<AnimationClip> &clips = model.getAnimations();
+  for (CharacterPose &pose : characterPoses) {
+    const float duration = clips[pose.clip].getDuration();
+    pose.time = duration > 0.0f ? std::fmod(pose.time + deltaTime, duration)
+                                : 0.0f;
+  }
+  const Skeleton &skeleton = model.getSkeleton();
+  const unsigned int characterCount = characterPoses.size();
+  if (CPU_SKINNING) {
+    // skinning reads the palettes back, so they stay in CPU memory
+    FrameVector<glm::mat4> bones(characterCount * skeleton.getBoneCount(),
+                                 &FrameArena::forThread());
+    evaluatePoses(skeleton, clips, characterPoses.data(), characterCount,
+                  bones.data());
+    model.skinOnCpu(bones.data());
+  } else if (glm::mat4 *bones = palettes.allocate(
+                 stream, characterCount, skeleton.getBoneCount())) {
+    evaluatePoses(skeleton, clips, characterPoses.data(), characterCount,
+                  bones);
+  }
+  sceneBounds.expand(characterBounds);
+}
+
+void renderCharacters(Model &model, const BonePalettes &palettes,
+                      Shader &shader) {
+  if (!CPU_SKINNING && palettes.getCharacterCount() == 0) {
+    return;
+  }
+  shader.use();
+  if (!CPU_SKINNING) {
+    palettes.bind(shader);
+  }
+  shader.setBool("instanced", true);
+  model.DrawInstanced(shader, 0, characterPoses.size(), 0);
+  shader.setBool("instanced", false);
+  if (!CPU_SKINNING) {
+    palettes.unbind(shader);
+  }
+}
+
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -0,0 +1,119 @@
+#include "memory/FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace {
+// blocks start on a cache line, larger alignments are padded inside
+const size_t BLOCK_ALIGNMENT = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+FrameArena::FrameArena(size_t capacity)
+    : m_capacity(alignUp(std::max(capacity, BLOCK_ALIGNMENT),
+                         BLOCK_ALIGNMENT)) {}
+
+FrameArena::~FrameArena() { releaseBlocks(0); }
+
+void FrameArena::reset() {
+  notePeak();
+  const size_t capacity = m_capacity.load(std::memory_order_relaxed);
+  if (m_framePeak > capacity) {
+    // regrow once to what this frame needed, with headroom for padding
+    m_overflowCount++;
+    releaseBlocks(0);
+    m_capacity.store(alignUp(m_framePeak + m_framePeak / 4, BLOCK_ALIGNMENT),
+                     std::memory_order_relaxed);
+  } else {
+    releaseBlocks(std::min<size_t>(m_blocks.size(), 1));
+  }
+  m_block = 0;
+  m_offset = 0;
+  m_retired = 0;
+  m_framePeak = 0;
+}
+
+FrameArena::Mark FrameArena::getMark() const {
+  return {m_block, m_offset, getUsed()};
+}
+
+void FrameArena::rewind(const Mark &mark) {
+  notePeak();
+  releaseBlocks(std::min(m_blocks.size(), mark.block + 1));
+  m_block = mark.block;
+  m_offset = mark.offset;
+  m_retired = mark.used - mark.offset;
+}
+
+size_t FrameArena::getUsed() const { return m_retired + m_offset; }
+
+size_t FrameArena::getPeak() const {
+  return m_peak.load(std::memory_order_relaxed);
+}
+
+size_t FrameArena::getCapacity() const {
+  return m_capacity.load(std::memory_order_relaxed);
+}
+
+unsigned int FrameArena::getOverflowCount() const { return m_overflowCount; }
+
+FrameArena &FrameArena::forThread() {
+  // blocks are allocated on first use, so idle threads cost nothing
+  static thread_local FrameArena arena;
+  return arena;
+}
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment) {
+  if (m_blocks.empty()) {
+    const size_t capacity = m_capacity.load(std::memory_order_relaxed);
+    addBlock(std::max(capacity, alignUp(bytes + alignment, BLOCK_ALIGNMENT)));
+    m_block = 0;
+    m_offset = 0;
+  }
+  Block &block = m_blocks[m_block];
+  uintptr_t base = (uintptr_t)block.data;
+  size_t offset = alignUp(base + m_offset, alignment) - base;
+  if (offset + bytes > block.size) {
+    // chain a block at least as large as the main one
+    m_retired += m_offset;
+    addBlock(std::max(m_blocks[0].size,
+                      alignUp(bytes + alignment, BLOCK_ALIGNMENT)));
+    m_block = m_blocks.size() - 1;
+    m_offset = 0;
+    base = (uintptr_t)m_blocks[m_block].data;
+    offset = alignUp(base, alignment) - base;
+  }
+  m_offset = offset + bytes;
+  m_framePeak = std::max(m_framePeak, getUsed());
+  return m_blocks[m_block].data + offset;
+}
+
+void FrameArena::do_deallocate(void *, size_t, size_t) {}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource &other) const
+    noexcept {
+  return this == &other;
+}
+
+void FrameArena::addBlock(size_t size) {
+  unsigned char *data = (unsigned char *)::operator new(
+      size, std::align_val_t(BLOCK_ALIGNMENT));
+  m_blocks.push_back({data, size});
+}
+
+void FrameArena::releaseBlocks(size_t first) {
+  for (size_t i = first; i < m_blocks.size(); i++) {
+    ::operator delete(m_blocks[i].data, std::align_val_t(BLOCK_ALIGNMENT));
+  }
+  m_blocks.resize(first);
+}
+
+void FrameArena::notePeak() {
+  if (m_framePeak > m_peak.load(std::memory_order_relaxed)) {
+    m_peak.store(m_framePeak, std::memory_order_relaxed);
+  }
+}
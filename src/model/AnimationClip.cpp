@@ -0,0 +1,185 @@
+#include "model/AnimationClip.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <assimp/anim.h>
+#include <glm/gtc/quaternion.hpp>
+
+#include "memory/FrameArena.hpp"
+
+namespace {
+// assimp leaves the tick rate at 0 when the file has none
+const double DEFAULT_TICKS_PER_SECOND = 25.0;
+
+// index of the last key at or before time, 0 before the first
+template <typename Key>
+unsigned int findKey(const Key *keys, unsigned int count, double time) {
+  auto after = std::upper_bound(
+      keys, keys + count, time,
+      [](double t, const Key &key) { return t < key.mTime; });
+  return after == keys ? 0 : after - keys - 1;
+}
+
+template <typename Key>
+float keyBlend(const Key *keys, unsigned int count, unsigned int key,
+               double time) {
+  if (key + 1 >= count) {
+    return 0.0f;
+  }
+  const double span = keys[key + 1].mTime - keys[key].mTime;
+  return span > 0.0 ? (float)std::clamp((time - keys[key].mTime) / span, 0.0,
+                                        1.0)
+                    : 0.0f;
+}
+
+glm::vec3 sampleVector(const aiVectorKey *keys, unsigned int count,
+                       double time, const glm::vec3 &fallback) {
+  if (count == 0) {
+    return fallback;
+  }
+  const unsigned int key = findKey(keys, count, time);
+  const float alpha = keyBlend(keys, count, key, time);
+  const aiVector3D &a = keys[key].mValue;
+  const aiVector3D &b = keys[std::min(key + 1, count - 1)].mValue;
+  return glm::mix(glm::vec3(a.x, a.y, a.z), glm::vec3(b.x, b.y, b.z), alpha);
+}
+
+glm::quat sampleRotation(const aiQuatKey *keys, unsigned int count,
+                         double time, const glm::quat &fallback) {
+  if (count == 0) {
+    return fallback;
+  }
+  const unsigned int key = findKey(keys, count, time);
+  const float alpha = keyBlend(keys, count, key, time);
+  const aiQuaternion &a = keys[key].mValue;
+  const aiQuaternion &b = keys[std::min(key + 1, count - 1)].mValue;
+  return glm::slerp(glm::quat(a.w, a.x, a.y, a.z),
+                    glm::quat(b.w, b.x, b.y, b.z), alpha);
+}
+} // namespace
+
+bool AnimationClip::import(const aiAnimation &animation,
+                           const SceneGraph &nodes) {
+  m_name = animation.mName.C_Str();
+  const double ticksPerSecond = animation.mTicksPerSecond > 0.0
+                                    ? animation.mTicksPerSecond
+                                    : DEFAULT_TICKS_PER_SECOND;
+  m_duration = (float)(animation.mDuration / ticksPerSecond);
+  m_frameCount =
+      (unsigned int)std::ceil(m_duration * ANIMATION_SAMPLE_RATE) + 1;
+
+  std::vector<const aiNodeAnim *> channels;
+  m_channelNodes.clear();
+  for (unsigned int i = 0; i < animation.mNumChannels; i++) {
+    const aiNodeAnim *channel = animation.mChannels[i];
+    const unsigned int node = nodes.findNode(channel->mNodeName.C_Str());
+    if (node != SCENE_GRAPH_NO_NODE) {
+      channels.push_back(channel);
+      m_channelNodes.push_back(node);
+    }
+  }
+  const unsigned int rowFloats = channels.size() * ANIMATION_CHANNEL_FLOATS;
+  m_frames.resize(m_frameCount * rowFloats);
+  if (channels.empty()) {
+    return false;
+  }
+
+  for (unsigned int c = 0; c < channels.size(); c++) {
+    const aiNodeAnim &channel = *channels[c];
+    // channels without keys of a kind keep the node's rest value for it
+    const glm::mat4 &rest = nodes.getLocalTransform(m_channelNodes[c]);
+    const glm::vec3 restTranslation = glm::vec3(rest[3]);
+    const glm::vec3 restScale(glm::length(glm::vec3(rest[0])),
+                              glm::length(glm::vec3(rest[1])),
+                              glm::length(glm::vec3(rest[2])));
+    const glm::quat restRotation = glm::quat_cast(
+        glm::mat3(glm::vec3(rest[0]) / restScale.x,
+                  glm::vec3(rest[1]) / restScale.y,
+                  glm::vec3(rest[2]) / restScale.z));
+    glm::quat previous = restRotation;
+    for (unsigned int frame = 0; frame < m_frameCount; frame++) {
+      const double time =
+          std::min(frame / (double)ANIMATION_SAMPLE_RATE, (double)m_duration) *
+          ticksPerSecond;
+      const glm::vec3 translation =
+          sampleVector(channel.mPositionKeys, channel.mNumPositionKeys, time,
+                       restTranslation);
+      glm::quat rotation = sampleRotation(
+          channel.mRotationKeys, channel.mNumRotationKeys, time, restRotation);
+      const glm::vec3 scale = sampleVector(
+          channel.mScalingKeys, channel.mNumScalingKeys, time, restScale);
+      // q and -q are the same rotation, lerping across them is not
+      if (glm::dot(rotation, previous) < 0.0f) {
+        rotation = -rotation;
+      }
+      previous = rotation;
+
+      float *out = &m_frames[frame * rowFloats + c * ANIMATION_CHANNEL_FLOATS];
+      const float values[ANIMATION_CHANNEL_FLOATS] = {
+          translation.x, translation.y, translation.z,
+          rotation.x,    rotation.y,    rotation.z,
+          rotation.w,    scale.x,       scale.y,
+          scale.z};
+      std::copy(values, values + ANIMATION_CHANNEL_FLOATS, out);
+    }
+  }
+  return true;
+}
+
+const std::string &AnimationClip::getName() const { return m_name; }
+
+float AnimationClip::getDuration() const { return m_duration; }
+
+unsigned int AnimationClip::getChannelCount() const {
+  return m_channelNodes.size();
+}
+
+unsigned int AnimationClip::getChannelNode(unsigned int channel) const {
+  return m_channelNodes[channel];
+}
+
+void AnimationClip::sample(float time, glm::mat4 *locals) const {
+  const unsigned int channelCount = m_channelNodes.size();
+  if (channelCount == 0) {
+    return;
+  }
+  time = m_duration > 0.0f ? std::fmod(time, m_duration) : 0.0f;
+  if (time < 0.0f) {
+    time += m_duration;
+  }
+  // the last interval ends at the duration and may be shorter than a frame
+  const float position = time * ANIMATION_SAMPLE_RATE;
+  const unsigned int frame =
+      std::min((unsigned int)position, std::max(m_frameCount, 2u) - 2);
+  const unsigned int next = std::min(frame + 1, m_frameCount - 1);
+  const float frameTime = frame / ANIMATION_SAMPLE_RATE;
+  const float span = std::min(next / ANIMATION_SAMPLE_RATE, m_duration) -
+                     frameTime;
+  const float alpha =
+      span > 0.0f ? std::clamp((time - frameTime) / span, 0.0f, 1.0f) : 0.0f;
+
+  const unsigned int rowFloats = channelCount * ANIMATION_CHANNEL_FLOATS;
+  const float *a = &m_frames[frame * rowFloats];
+  const float *b = &m_frames[next * rowFloats];
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  FrameVector<float> blended(rowFloats, &arena);
+  float *out = blended.data();
+  // one flat loop over every channel, no per-channel branching
+  for (unsigned int i = 0; i < rowFloats; i++) {
+    out[i] = a[i] + (b[i] - a[i]) * alpha;
+  }
+
+  for (unsigned int c = 0; c < channelCount; c++) {
+    const float *v = out + c * ANIMATION_CHANNEL_FLOATS;
+    const glm::quat rotation =
+        glm::normalize(glm::quat(v[6], v[3], v[4], v[5]));
+    glm::mat4 local = glm::mat4_cast(rotation);
+    local[0] *= v[7];
+    local[1] *= v[8];
+    local[2] *= v[9];
+    local[3] = glm::vec4(v[0], v[1], v[2], 1.0f);
+    locals[m_channelNodes[c]] = local;
+  }
+}
@@ -0,0 +1,31 @@
+#include "model/GlObject.hpp"
+
+unsigned int createGlObject(GlObjectType type) {
+  unsigned int id = 0;
+  switch (type) {
+  case GlObjectType::Buffer:
+    glGenBuffers(1, &id);
+    break;
+  case GlObjectType::VertexArray:
+    glGenVertexArrays(1, &id);
+    break;
+  case GlObjectType::Texture:
+    glGenTextures(1, &id);
+    break;
+  }
+  return id;
+}
+
+void deleteGlObject(GlObjectType type, unsigned int id) {
+  switch (type) {
+  case GlObjectType::Buffer:
+    glDeleteBuffers(1, &id);
+    break;
+  case GlObjectType::VertexArray:
+    glDeleteVertexArrays(1, &id);
+    break;
+  case GlObjectType::Texture:
+    glDeleteTextures(1, &id);
+    break;
+  }
+}
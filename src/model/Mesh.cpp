@@ -1,19 +1,32 @@
 #include <model/Mesh.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <utility>
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-           std::vector<Texture> textures) {
-  this->vertices = vertices;
-  this->indices = indices;
-  this->textures = textures;
-  setupMesh();
+           std::vector<Texture> textures, std::vector<MeshLod> lods) {
+  this->vertices = std::move(vertices);
+  this->indices = std::move(indices);
+  this->textures = std::move(textures);
+  this->lods = std::move(lods);
+  setupMesh(this->vertices.data(), this->vertices.size(),
+            this->indices.data(), this->indices.size());
+}
+
+Mesh::Mesh(const Vertex *vertexData, size_t vertexCount,
+           const unsigned int *indexData, size_t indexCount,
+           std::vector<Texture> textures, std::vector<MeshLod> lods) {
+  this->textures = std::move(textures);
+  this->lods = std::move(lods);
+  setupMesh(vertexData, vertexCount, indexData, indexCount);
 }
 
 void Mesh::Draw() {
   // draw mesh
-  glBindVertexArray(VAO);
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+  glBindVertexArray(VAO.get());
+  glDrawElements(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_INT, 0);
   glBindVertexArray(0);
 
   // always good practice to set everything back to defaults once configured
@@ -21,6 +34,42 @@ void Mesh::Draw() {
 }
 
 void Mesh::Draw(Shader &shader) {
+  bindTextures(shader);
+
+  // draw mesh
+  glBindVertexArray(VAO.get());
+  glDrawElements(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_INT, 0);
+  glBindVertexArray(0);
+
+  // always good practice to set everything back to defaults once configured
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::DrawInstanced(Shader &shader, unsigned int lod,
+                         unsigned int instanceCount,
+                         unsigned int baseInstance) {
+  const MeshLod &level = lods[std::min<size_t>(lod, lods.size() - 1)];
+  bindTextures(shader);
+  glBindVertexArray(VAO.get());
+  glDrawElementsInstancedBaseInstance(
+      GL_TRIANGLES, level.indexCount, GL_UNSIGNED_INT,
+      (void *)(level.indexOffset * sizeof(unsigned int)), instanceCount,
+      baseInstance);
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::setInstanceBuffer(unsigned int buffer) {
+  glBindVertexArray(VAO.get());
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glEnableVertexAttribArray(MESH_INSTANCE_ATTRIBUTE);
+  glVertexAttribPointer(MESH_INSTANCE_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(glm::vec4), (void *)0);
+  glVertexAttribDivisor(MESH_INSTANCE_ATTRIBUTE, 1);
+  glBindVertexArray(0);
+}
+
+void Mesh::bindTextures(Shader &shader) {
   unsigned int diffuseNr = 1;
   unsigned int specularNr = 1;
   unsigned int normalNr = 1;
@@ -43,30 +92,65 @@ void Mesh::Draw(Shader &shader) {
     glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
     glBindTexture(GL_TEXTURE_2D, textures[i].id);
   }
+}
 
-  // draw mesh
-  glBindVertexArray(VAO);
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-  glBindVertexArray(0);
+void Mesh::releaseCpuData() {
+  // swap with empty vectors, clear() would keep the capacity
+  std::vector<Vertex>().swap(vertices);
+  std::vector<unsigned int>().swap(indices);
+}
 
-  // always good practice to set everything back to defaults once configured
-  glActiveTexture(GL_TEXTURE0);
+void Mesh::updateVertices(const Vertex *vertexData, size_t vertexCount) {
+  glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+  glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(Vertex),
+                  vertexData);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void Mesh::setupMesh() {
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  glGenBuffers(1, &EBO);
+void Mesh::computeBounds(const Vertex *vertexData, size_t vertexCount) {
+  bounds = Aabb();
+  skinned = false;
+  for (size_t i = 0; i < vertexCount; i++) {
+    bounds.expand(vertexData[i].Position);
+    skinned = skinned || vertexData[i].m_Weights[0] > 0.0f;
+  }
+  if (bounds.isEmpty()) {
+    boundingSphere = BoundingSphere();
+    return;
+  }
+  // centered on the box, a little looser than the minimal sphere but never
+  // larger than the sphere around the box
+  boundingSphere.center = bounds.getCenter();
+  float radiusSquared = 0.0f;
+  for (size_t i = 0; i < vertexCount; i++) {
+    const glm::vec3 d = vertexData[i].Position - boundingSphere.center;
+    radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+  }
+  boundingSphere.radius = std::sqrt(radiusSquared);
+}
+
+void Mesh::setupMesh(const Vertex *vertexData, size_t vertexCount,
+                     const unsigned int *indexData, size_t indexCount) {
+  if (lods.empty()) {
+    MeshLod full;
+    full.indexCount = indexCount;
+    lods.push_back(full);
+  }
+  computeBounds(vertexData, vertexCount);
+  VAO = GlVertexArray::create();
+  VBO = GlBuffer::create();
+  EBO = GlBuffer::create();
 
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBindVertexArray(VAO.get());
+  glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
 
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0],
-               GL_STATIC_DRAW);
+  // CPU skinned meshes rewrite their vertices every frame
+  glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData,
+               skinned ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
-               &indices[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int),
+               indexData, GL_STATIC_DRAW);
 
   // vertex positions
   glEnableVertexAttribArray(0);
@@ -87,10 +171,10 @@ void Mesh::setupMesh() {
   glEnableVertexAttribArray(4);
   glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                         (void *)offsetof(Vertex, Bitangent));
-  // ids
+  // ids, integer so the shader can index the bone palette
   glEnableVertexAttribArray(5);
-  glVertexAttribPointer(5, 4, GL_INT, GL_FALSE, sizeof(Vertex),
-                        (void *)offsetof(Vertex, m_BoneIDs));
+  glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex),
+                         (void *)offsetof(Vertex, m_BoneIDs));
   // weights
   glEnableVertexAttribArray(6);
   glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
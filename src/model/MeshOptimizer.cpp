@@ -0,0 +1,681 @@
+#include "model/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "memory/FrameArena.hpp"
+#include "profiling/Profiler.hpp"
+
+namespace {
+const unsigned int NO_INDEX = UINT_MAX;
+
+// weights from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// open borders weigh this much more than the surface, so they stay in place
+const double BORDER_WEIGHT = 10.0;
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+// FNV-1a over raw bytes, so only bitwise equal keys are merged
+uint64_t hashBytes(uint64_t seed, const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+// Vertices about to leave the cache score low, the last triangle's
+// vertices get a fixed score so its neighbours are not always preferred, and
+// vertices with few triangles left are boosted to finish them off.
+float vertexScore(int cachePosition, unsigned int remaining) {
+  if (remaining == 0) {
+    return -1.0f;
+  }
+  float score = 0.0f;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      score = LAST_TRIANGLE_SCORE;
+    } else {
+      const float scale = 1.0f / (MESH_OPTIMIZER_CACHE_SIZE - 3);
+      score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+    }
+  }
+  return score + VALENCE_BOOST_SCALE *
+                     std::pow((float)remaining, -VALENCE_BOOST_POWER);
+}
+
+// Sum of squared distances to a set of weighted planes, as the symmetric
+// 4x4 matrix of Garland and Heckbert. error() divides by the total weight,
+// so it is a mean squared distance whatever the triangle sizes.
+struct Quadric {
+  double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+  double b2 = 0.0, bc = 0.0, bd = 0.0;
+  double c2 = 0.0, cd = 0.0;
+  double d2 = 0.0;
+  double weight = 0.0;
+
+  void addPlane(const glm::dvec3 &n, double d, double w) {
+    a2 += w * n.x * n.x;
+    ab += w * n.x * n.y;
+    ac += w * n.x * n.z;
+    ad += w * n.x * d;
+    b2 += w * n.y * n.y;
+    bc += w * n.y * n.z;
+    bd += w * n.y * d;
+    c2 += w * n.z * n.z;
+    cd += w * n.z * d;
+    d2 += w * d * d;
+    weight += w;
+  }
+
+  void add(const Quadric &other) {
+    a2 += other.a2;
+    ab += other.ab;
+    ac += other.ac;
+    ad += other.ad;
+    b2 += other.b2;
+    bc += other.bc;
+    bd += other.bd;
+    c2 += other.c2;
+    cd += other.cd;
+    d2 += other.d2;
+    weight += other.weight;
+  }
+
+  double error(const glm::dvec3 &p) const {
+    if (weight <= 0.0) {
+      return 0.0;
+    }
+    const double e = a2 * p.x * p.x + b2 * p.y * p.y + c2 * p.z * p.z +
+                     2.0 * (ab * p.x * p.y + ac * p.x * p.z + bc * p.y * p.z +
+                            ad * p.x + bd * p.y + cd * p.z) +
+                     d2;
+    return std::max(e, 0.0) / weight;
+  }
+};
+
+// what a position may collapse onto, seams are positions shared by several
+// vertices and borders lie on edges with a single triangle
+enum class PositionKind : uint8_t {
+  Manifold,
+  Seam,
+  Border,
+  Locked,
+};
+
+bool canCollapse(PositionKind from, PositionKind to) {
+  switch (from) {
+  case PositionKind::Manifold:
+    return true;
+  case PositionKind::Seam:
+    return to == PositionKind::Seam || to == PositionKind::Locked;
+  case PositionKind::Border:
+    return to == PositionKind::Border || to == PositionKind::Locked;
+  case PositionKind::Locked:
+    return false;
+  }
+  return false;
+}
+
+struct Collapse {
+  unsigned int from;
+  unsigned int to;
+  double cost;
+};
+
+bool cheaperCollapse(const Collapse &a, const Collapse &b) {
+  return a.cost < b.cost;
+}
+
+uint64_t edgeKey(unsigned int a, unsigned int b) {
+  return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+}
+
+glm::dvec3 triangleNormal(const glm::dvec3 &p0, const glm::dvec3 &p1,
+                          const glm::dvec3 &p2) {
+  return glm::cross(p1 - p0, p2 - p0);
+}
+} // namespace
+
+size_t weldVertices(Vertex *vertices, size_t vertexCount,
+                    unsigned int *indices, size_t indexCount) {
+  if (vertexCount == 0) {
+    return 0;
+  }
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  size_t tableSize = 16;
+  while (tableSize < vertexCount * 2) {
+    tableSize *= 2;
+  }
+  const size_t mask = tableSize - 1;
+  // open addressing table of welded vertex indices
+  FrameVector<unsigned int> table(tableSize, NO_INDEX, &arena);
+  FrameVector<unsigned int> remap(vertexCount, &arena);
+
+  size_t unique = 0;
+  for (size_t i = 0; i < vertexCount; i++) {
+    size_t slot =
+        hashBytes(FNV_OFFSET, &vertices[i], sizeof(Vertex)) & mask;
+    while (true) {
+      const unsigned int candidate = table[slot];
+      if (candidate == NO_INDEX) {
+        // survivors are compacted to the front, unique never passes i
+        vertices[unique] = vertices[i];
+        table[slot] = unique;
+        remap[i] = unique++;
+        break;
+      }
+      if (std::memcmp(&vertices[candidate], &vertices[i], sizeof(Vertex)) ==
+          0) {
+        remap[i] = candidate;
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+  }
+  for (size_t i = 0; i < indexCount; i++) {
+    indices[i] = remap[indices[i]];
+  }
+  return unique;
+}
+
+void optimizeVertexCache(unsigned int *indices, size_t indexCount,
+                         size_t vertexCount) {
+  const size_t triangleCount = indexCount / 3;
+  if (triangleCount == 0) {
+    return;
+  }
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+
+  // triangles of each vertex, the first remaining[v] entries are not emitted
+  FrameVector<unsigned int> remaining(vertexCount, 0, &arena);
+  for (size_t i = 0; i < triangleCount * 3; i++) {
+    remaining[indices[i]]++;
+  }
+  FrameVector<unsigned int> offsets(vertexCount + 1, 0, &arena);
+  for (size_t v = 0; v < vertexCount; v++) {
+    offsets[v + 1] = offsets[v] + remaining[v];
+  }
+  FrameVector<unsigned int> adjacency(triangleCount * 3, &arena);
+  FrameVector<unsigned int> fill(offsets.begin(), offsets.end() - 1, &arena);
+  for (size_t i = 0; i < triangleCount * 3; i++) {
+    adjacency[fill[indices[i]]++] = i / 3;
+  }
+
+  FrameVector<int> cachePosition(vertexCount, -1, &arena);
+  FrameVector<float> scores(vertexCount, &arena);
+  for (size_t v = 0; v < vertexCount; v++) {
+    scores[v] = vertexScore(-1, remaining[v]);
+  }
+  FrameVector<float> triangleScores(triangleCount, &arena);
+  for (size_t t = 0; t < triangleCount; t++) {
+    triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] +
+                        scores[indices[t * 3 + 2]];
+  }
+  FrameVector<bool> emitted(triangleCount, false, &arena);
+  FrameVector<unsigned int> output(triangleCount * 3, &arena);
+
+  // the cache briefly holds 3 extra vertices before the oldest are evicted
+  unsigned int cache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+  unsigned int nextCache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+  size_t cacheCount = 0;
+  size_t nextInOrder = 0;
+  unsigned int best = NO_INDEX;
+
+  for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+    if (best == NO_INDEX) {
+      // nothing in the cache has triangles left, restart in file order
+      while (emitted[nextInOrder]) {
+        nextInOrder++;
+      }
+      best = nextInOrder;
+    }
+    const unsigned int *triangle = indices + (size_t)best * 3;
+    std::copy(triangle, triangle + 3, output.begin() + emittedCount * 3);
+    emitted[best] = true;
+
+    for (unsigned int k = 0; k < 3; k++) {
+      const unsigned int v = triangle[k];
+      unsigned int *list = adjacency.data() + offsets[v];
+      for (unsigned int j = 0; j < remaining[v]; j++) {
+        if (list[j] == best) {
+          list[j] = list[--remaining[v]];
+          break;
+        }
+      }
+    }
+
+    // the emitted triangle's vertices move to the front of the cache
+    size_t nextCount = 0;
+    for (unsigned int k = 0; k < 3; k++) {
+      if (std::find(nextCache, nextCache + nextCount, triangle[k]) ==
+          nextCache + nextCount) {
+        nextCache[nextCount++] = triangle[k];
+      }
+    }
+    for (size_t i = 0; i < cacheCount; i++) {
+      const unsigned int v = cache[i];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+        nextCache[nextCount++] = v;
+      }
+    }
+
+    // rescore every vertex whose position changed, evicted ones included
+    for (size_t i = 0; i < nextCount; i++) {
+      const unsigned int v = nextCache[i];
+      cachePosition[v] = i < MESH_OPTIMIZER_CACHE_SIZE ? (int)i : -1;
+      const float score = vertexScore(cachePosition[v], remaining[v]);
+      const float delta = score - scores[v];
+      scores[v] = score;
+      const unsigned int *list = adjacency.data() + offsets[v];
+      for (unsigned int j = 0; j < remaining[v]; j++) {
+        triangleScores[list[j]] += delta;
+      }
+    }
+    cacheCount = std::min(nextCount, (size_t)MESH_OPTIMIZER_CACHE_SIZE);
+    std::copy(nextCache, nextCache + cacheCount, cache);
+
+    // the next triangle is the best one touching the cache
+    best = NO_INDEX;
+    float bestScore = -1.0f;
+    for (size_t i = 0; i < cacheCount; i++) {
+      const unsigned int v = cache[i];
+      const unsigned int *list = adjacency.data() + offsets[v];
+      for (unsigned int j = 0; j < remaining[v]; j++) {
+        if (triangleScores[list[j]] > bestScore) {
+          bestScore = triangleScores[list[j]];
+          best = list[j];
+        }
+      }
+    }
+  }
+  std::copy(output.begin(), output.end(), indices);
+}
+
+size_t optimizeVertexFetch(Vertex *vertices, size_t vertexCount,
+                           unsigned int *indices, size_t indexCount) {
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  FrameVector<unsigned int> remap(vertexCount, NO_INDEX, &arena);
+  unsigned int next = 0;
+  for (size_t i = 0; i < indexCount; i++) {
+    unsigned int &index = remap[indices[i]];
+    if (index == NO_INDEX) {
+      index = next++;
+    }
+    indices[i] = index;
+  }
+  FrameVector<Vertex> reordered(next, &arena);
+  for (size_t v = 0; v < vertexCount; v++) {
+    if (remap[v] != NO_INDEX) {
+      reordered[remap[v]] = vertices[v];
+    }
+  }
+  std::copy(reordered.begin(), reordered.end(), vertices);
+  return next;
+}
+
+float computeAcmr(const unsigned int *indices, size_t indexCount,
+                  size_t vertexCount, unsigned int cacheSize) {
+  const size_t triangleCount = indexCount / 3;
+  if (triangleCount == 0) {
+    return 0.0f;
+  }
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  // miss count when each vertex last entered, 0 for never; a FIFO holds the
+  // last cacheSize misses
+  FrameVector<size_t> entered(vertexCount, 0, &arena);
+  size_t misses = 0;
+  for (size_t i = 0; i < triangleCount * 3; i++) {
+    size_t &time = entered[indices[i]];
+    if (time == 0 || misses - time >= cacheSize) {
+      time = ++misses;
+    }
+  }
+  return (float)misses / triangleCount;
+}
+
+size_t simplifyMesh(const Vertex *vertices, size_t vertexCount,
+                    const unsigned int *indices, size_t indexCount,
+                    size_t targetIndexCount, float maxError,
+                    unsigned int *out, float *error) {
+  const size_t triangleCount = indexCount / 3;
+  if (error) {
+    *error = 0.0f;
+  }
+  if (triangleCount * 3 <= targetIndexCount || vertexCount == 0) {
+    std::copy(indices, indices + triangleCount * 3, out);
+    return triangleCount * 3;
+  }
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+
+  // vertices sharing a position move together, differing only in attributes
+  size_t tableSize = 16;
+  while (tableSize < vertexCount * 2) {
+    tableSize *= 2;
+  }
+  const size_t mask = tableSize - 1;
+  FrameVector<unsigned int> table(tableSize, NO_INDEX, &arena);
+  FrameVector<unsigned int> positionOf(vertexCount, &arena);
+  FrameVector<glm::dvec3> points(&arena);
+  for (size_t v = 0; v < vertexCount; v++) {
+    const glm::vec3 &position = vertices[v].Position;
+    size_t slot = hashBytes(FNV_OFFSET, &position, sizeof(glm::vec3)) & mask;
+    while (table[slot] != NO_INDEX &&
+           vertices[table[slot]].Position != position) {
+      slot = (slot + 1) & mask;
+    }
+    if (table[slot] == NO_INDEX) {
+      table[slot] = v;
+      positionOf[v] = points.size();
+      points.push_back(glm::dvec3(position));
+    } else {
+      positionOf[v] = positionOf[table[slot]];
+    }
+  }
+  const size_t positionCount = points.size();
+
+  FrameVector<unsigned int> vertexOffsets(positionCount + 1, 0, &arena);
+  for (size_t v = 0; v < vertexCount; v++) {
+    vertexOffsets[positionOf[v] + 1]++;
+  }
+  for (size_t p = 0; p < positionCount; p++) {
+    vertexOffsets[p + 1] += vertexOffsets[p];
+  }
+  FrameVector<unsigned int> positionVertices(vertexCount, &arena);
+  FrameVector<unsigned int> fill(vertexOffsets.begin(),
+                                 vertexOffsets.end() - 1, &arena);
+  for (size_t v = 0; v < vertexCount; v++) {
+    positionVertices[fill[positionOf[v]]++] = v;
+  }
+
+  FrameVector<PositionKind> kinds(positionCount, PositionKind::Manifold,
+                                  &arena);
+  for (size_t p = 0; p < positionCount; p++) {
+    if (vertexOffsets[p + 1] - vertexOffsets[p] > 1) {
+      kinds[p] = PositionKind::Seam;
+    }
+  }
+
+  // triangles keep their original corner vertices for the attributes and
+  // track the positions the corners have collapsed onto
+  FrameVector<unsigned int> corners(indices, indices + triangleCount * 3,
+                                    &arena);
+  FrameVector<unsigned int> cornerPositions(triangleCount * 3, &arena);
+  for (size_t i = 0; i < triangleCount * 3; i++) {
+    cornerPositions[i] = positionOf[indices[i]];
+  }
+  FrameVector<bool> alive(triangleCount, true, &arena);
+  size_t liveIndexCount = triangleCount * 3;
+
+  FrameVector<Quadric> quadrics(positionCount, &arena);
+  FrameVector<glm::dvec3> normals(triangleCount, &arena);
+  for (size_t t = 0; t < triangleCount; t++) {
+    const unsigned int *p = cornerPositions.data() + t * 3;
+    glm::dvec3 n = triangleNormal(points[p[0]], points[p[1]], points[p[2]]);
+    const double length = glm::length(n);
+    if (length > 0.0) {
+      n /= length;
+      for (unsigned int k = 0; k < 3; k++) {
+        quadrics[p[k]].addPlane(n, -glm::dot(n, points[p[0]]), length * 0.5);
+      }
+    }
+    normals[t] = n;
+  }
+
+  // edges with one triangle are open borders, held by a plane through the
+  // edge perpendicular to its triangle; edges with more than two are locked
+  struct Edge {
+    uint64_t key;
+    unsigned int triangle;
+    unsigned int corner;
+  };
+  FrameVector<Edge> edges(&arena);
+  edges.reserve(triangleCount * 3);
+  for (size_t t = 0; t < triangleCount; t++) {
+    for (unsigned int k = 0; k < 3; k++) {
+      edges.push_back({edgeKey(cornerPositions[t * 3 + k],
+                               cornerPositions[t * 3 + (k + 1) % 3]),
+                       (unsigned int)t, k});
+    }
+  }
+  std::sort(edges.begin(), edges.end(),
+            [](const Edge &a, const Edge &b) { return a.key < b.key; });
+  for (size_t first = 0; first < edges.size();) {
+    size_t last = first + 1;
+    while (last < edges.size() && edges[last].key == edges[first].key) {
+      last++;
+    }
+    const unsigned int a = edges[first].key >> 32;
+    const unsigned int b = edges[first].key & 0xFFFFFFFFu;
+    if (last - first == 1) {
+      const glm::dvec3 edge = points[b] - points[a];
+      glm::dvec3 n = glm::cross(edge, normals[edges[first].triangle]);
+      const double length = glm::length(n);
+      if (length > 0.0) {
+        n /= length;
+        const double weight = glm::length(edge) * BORDER_WEIGHT;
+        quadrics[a].addPlane(n, -glm::dot(n, points[a]), weight);
+        quadrics[b].addPlane(n, -glm::dot(n, points[a]), weight);
+      }
+      for (unsigned int p : {a, b}) {
+        kinds[p] = kinds[p] == PositionKind::Manifold ? PositionKind::Border
+                                                      : PositionKind::Locked;
+      }
+    } else if (last - first > 2) {
+      kinds[a] = PositionKind::Locked;
+      kinds[b] = PositionKind::Locked;
+    }
+    first = last;
+  }
+
+  const double maxErrorSquared = (double)maxError * maxError;
+  double worstError = 0.0;
+  FrameVector<unsigned int> triangleOffsets(positionCount + 1, &arena);
+  FrameVector<unsigned int> positionTriangles(&arena);
+  FrameVector<Collapse> collapses(&arena);
+  FrameVector<bool> touched(positionCount, false, &arena);
+
+  // Each pass takes the cheapest collapses that do not share a neighbourhood,
+  // so every collapse is checked against an unchanged ring of triangles.
+  while (liveIndexCount > targetIndexCount) {
+    std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+    for (size_t t = 0; t < triangleCount; t++) {
+      if (alive[t]) {
+        for (unsigned int k = 0; k < 3; k++) {
+          triangleOffsets[cornerPositions[t * 3 + k] + 1]++;
+        }
+      }
+    }
+    for (size_t p = 0; p < positionCount; p++) {
+      triangleOffsets[p + 1] += triangleOffsets[p];
+    }
+    positionTriangles.resize(triangleOffsets[positionCount]);
+    fill.assign(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    collapses.clear();
+    for (size_t t = 0; t < triangleCount; t++) {
+      if (!alive[t]) {
+        continue;
+      }
+      for (unsigned int k = 0; k < 3; k++) {
+        const unsigned int a = cornerPositions[t * 3 + k];
+        const unsigned int b = cornerPositions[t * 3 + (k + 1) % 3];
+        positionTriangles[fill[a]++] = t;
+        Quadric combined = quadrics[a];
+        combined.add(quadrics[b]);
+        if (canCollapse(kinds[a], kinds[b])) {
+          collapses.push_back({a, b, combined.error(points[b])});
+        }
+        if (canCollapse(kinds[b], kinds[a])) {
+          collapses.push_back({b, a, combined.error(points[a])});
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(), cheaperCollapse);
+
+    std::fill(touched.begin(), touched.end(), false);
+    const size_t trianglesToRemove = (liveIndexCount - targetIndexCount) / 3;
+    size_t removed = 0;
+    bool collapsed = false;
+    for (const Collapse &collapse : collapses) {
+      if (removed >= trianglesToRemove || collapse.cost > maxErrorSquared) {
+        break;
+      }
+      if (touched[collapse.from] || touched[collapse.to]) {
+        continue;
+      }
+      const unsigned int *ring =
+          positionTriangles.data() + triangleOffsets[collapse.from];
+      const size_t ringSize =
+          triangleOffsets[collapse.from + 1] - triangleOffsets[collapse.from];
+
+      // the triangles that survive must not turn over
+      bool flips = false;
+      for (size_t i = 0; i < ringSize && !flips; i++) {
+        const unsigned int *p = cornerPositions.data() + (size_t)ring[i] * 3;
+        if (p[0] == collapse.to || p[1] == collapse.to || p[2] == collapse.to) {
+          continue;
+        }
+        glm::dvec3 moved[3];
+        for (unsigned int k = 0; k < 3; k++) {
+          moved[k] = points[p[k] == collapse.from ? collapse.to : p[k]];
+        }
+        const glm::dvec3 before =
+            triangleNormal(points[p[0]], points[p[1]], points[p[2]]);
+        flips = glm::dot(before, triangleNormal(moved[0], moved[1],
+                                                moved[2])) <= 0.0;
+      }
+      if (flips) {
+        continue;
+      }
+
+      for (size_t i = 0; i < ringSize; i++) {
+        unsigned int *p = cornerPositions.data() + (size_t)ring[i] * 3;
+        for (unsigned int k = 0; k < 3; k++) {
+          touched[p[k]] = true;
+        }
+        if (p[0] == collapse.to || p[1] == collapse.to || p[2] == collapse.to) {
+          alive[ring[i]] = false;
+          liveIndexCount -= 3;
+          removed++;
+        } else {
+          for (unsigned int k = 0; k < 3; k++) {
+            if (p[k] == collapse.from) {
+              p[k] = collapse.to;
+            }
+          }
+        }
+      }
+      quadrics[collapse.to].add(quadrics[collapse.from]);
+      worstError = std::max(worstError, collapse.cost);
+      collapsed = true;
+    }
+    if (!collapsed) {
+      break;
+    }
+  }
+
+  // a corner whose position moved takes the vertex at the new position with
+  // the closest attributes, which keeps it on its side of a seam
+  size_t written = 0;
+  for (size_t t = 0; t < triangleCount; t++) {
+    if (!alive[t]) {
+      continue;
+    }
+    for (unsigned int k = 0; k < 3; k++) {
+      const unsigned int corner = corners[t * 3 + k];
+      const unsigned int p = cornerPositions[t * 3 + k];
+      unsigned int best = corner;
+      if (positionOf[corner] != p) {
+        float bestDistance = FLT_MAX;
+        for (unsigned int i = vertexOffsets[p]; i < vertexOffsets[p + 1];
+             i++) {
+          const Vertex &candidate = vertices[positionVertices[i]];
+          const glm::vec3 normal = candidate.Normal - vertices[corner].Normal;
+          const glm::vec2 uv = candidate.TexCoords - vertices[corner].TexCoords;
+          const float distance = glm::dot(normal, normal) + glm::dot(uv, uv);
+          if (distance < bestDistance) {
+            bestDistance = distance;
+            best = positionVertices[i];
+          }
+        }
+      }
+      out[written++] = best;
+    }
+  }
+  if (error) {
+    *error = (float)std::sqrt(worstError);
+  }
+  return written;
+}
+
+void buildLodChain(const Vertex *vertices, size_t vertexCount,
+                   FrameVector<unsigned int> &indices,
+                   std::vector<MeshLod> &lods) {
+  const size_t baseCount = indices.size();
+  lods.clear();
+  MeshLod base;
+  base.indexCount = baseCount;
+  lods.push_back(base);
+
+  size_t previous = baseCount;
+  while (lods.size() < MESH_LOD_MAX_LEVELS &&
+         previous / 3 > MESH_LOD_MIN_TRIANGLES) {
+    const size_t target =
+        std::max(previous / 6 * 3, (size_t)MESH_LOD_MIN_TRIANGLES * 3);
+    // levels are simplified from the full mesh so errors do not compound,
+    // the room is grown here since the simplifier's scratch is rewound
+    const size_t offset = indices.size();
+    indices.resize(offset + baseCount);
+    float error = 0.0f;
+    const size_t count =
+        simplifyMesh(vertices, vertexCount, indices.data(), baseCount, target,
+                     FLT_MAX, indices.data() + offset, &error);
+    // locked seams and borders can stall the reduction
+    if (count == 0 || count > previous * 85 / 100) {
+      indices.resize(offset);
+      break;
+    }
+    indices.resize(offset + count);
+    optimizeVertexCache(indices.data() + offset, count, vertexCount);
+
+    MeshLod lod;
+    lod.indexOffset = offset;
+    lod.indexCount = count;
+    lod.error = std::max(error, lods.back().error);
+    lods.push_back(lod);
+    previous = count;
+  }
+}
+
+MeshOptimizeStats optimizeMesh(Vertex *vertices, size_t vertexCount,
+                               unsigned int *indices, size_t indexCount) {
+  PROFILE_SCOPE("model.optimize");
+  MeshOptimizeStats stats;
+  stats.vertexCountBefore = vertexCount;
+  stats.triangleCount = indexCount / 3;
+  stats.acmrBefore = computeAcmr(indices, indexCount, vertexCount);
+
+  vertexCount = weldVertices(vertices, vertexCount, indices, indexCount);
+  optimizeVertexCache(indices, indexCount, vertexCount);
+  vertexCount = optimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+
+  stats.vertexCountAfter = vertexCount;
+  stats.acmrAfter = computeAcmr(indices, indexCount, vertexCount);
+  return stats;
+}
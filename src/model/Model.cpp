@@ -1,6 +1,21 @@
 #include "model/Model.hpp"
 
-#include "stb_image.h"
+#include <algorithm>
+#include <utility>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "memory/FrameArena.hpp"
+#include "model/MeshOptimizer.hpp"
+#include "profiling/Profiler.hpp"
+#include "texture/TextureCache.hpp"
+
+namespace {
+glm::mat4 toGlm(const aiMatrix4x4 &matrix) {
+  // assimp stores rows, glm columns
+  return glm::transpose(glm::make_mat4(&matrix.a1));
+}
+} // namespace
 
 Model::Model() {}
 
@@ -9,16 +24,73 @@ void Model::Draw() {
     meshes[i].Draw();
   }
 }
-void Model::Draw(Shader &shader) {
+void Model::Draw(Shader &shader, const glm::mat4 &transform) {
+  updateTransforms();
   for (unsigned int i = 0; i < meshes.size(); i++) {
+    shader.setMat4("model",
+                   meshes[i].skinned
+                       ? transform
+                       : transform * nodes.getWorldTransform(meshNodes[i]));
     meshes[i].Draw(shader);
   }
 }
 
+void Model::DrawInstanced(Shader &shader, unsigned int lod,
+                          unsigned int instanceCount,
+                          unsigned int baseInstance) {
+  updateTransforms();
+  for (unsigned int i = 0; i < meshes.size(); i++) {
+    shader.setMat4("model", meshes[i].skinned
+                                ? glm::mat4(1.0f)
+                                : nodes.getWorldTransform(meshNodes[i]));
+    meshes[i].DrawInstanced(shader, lod, instanceCount, baseInstance);
+  }
+}
+
+void Model::setInstanceBuffer(unsigned int buffer) {
+  for (unsigned int i = 0; i < meshes.size(); i++) {
+    meshes[i].setInstanceBuffer(buffer);
+  }
+}
+
+const std::vector<float> &Model::getLodErrors() const { return lodErrors; }
+
+bool Model::isSkinned() const {
+  return std::any_of(meshes.begin(), meshes.end(),
+                     [](const Mesh &mesh) { return mesh.skinned; });
+}
+
+bool Model::skinOnCpu(const glm::mat4 *palette) {
+  PROFILE_SCOPE("animation.cpu_skinning");
+  FrameArena &arena = FrameArena::forThread();
+  for (Mesh &mesh : meshes) {
+    if (!mesh.skinned) {
+      continue;
+    }
+    if (mesh.vertices.empty()) {
+      std::cout << "ERROR::MODEL::CPU_SKINNING_WITHOUT_CPU_DATA" << std::endl;
+      return false;
+    }
+    FrameArenaScope scratch(arena);
+    FrameVector<Vertex> posed(mesh.vertices.size(), &arena);
+    skinVertices(mesh.vertices.data(), mesh.vertices.size(), palette,
+                 posed.data());
+    mesh.updateVertices(posed.data(), posed.size());
+  }
+  return true;
+}
+
+void Model::updateTransforms() {
+  if (nodes.update()) {
+    computeBounds();
+  }
+}
+
 void Model::loadModel(std::string const &path) {
   Assimp::Importer import;
   const aiScene *scene =
-      import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+      import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs |
+                                aiProcess_LimitBoneWeights);
 
   if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
       !scene->mRootNode) {
@@ -26,29 +98,84 @@ void Model::loadModel(std::string const &path) {
     return;
   }
   directory = path.substr(0, path.find_last_of('/'));
+  meshes.reserve(meshes.size() + scene->mNumMeshes);
 
   processNode(scene->mRootNode, scene);
+  updateTransforms();
+  skeleton.setHierarchy(nodes);
+  for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
+    AnimationClip clip;
+    if (clip.import(*scene->mAnimations[i], nodes)) {
+      animations.push_back(std::move(clip));
+    }
+  }
+  // a level's error is its worst mesh, meshes with fewer levels stay at
+  // their last
+  for (const Mesh &mesh : meshes) {
+    if (lodErrors.size() < mesh.lods.size()) {
+      lodErrors.resize(mesh.lods.size(), lodErrors.empty() ? 0.0f
+                                                           : lodErrors.back());
+    }
+    for (size_t level = 0; level < lodErrors.size(); level++) {
+      const MeshLod &lod = mesh.lods[std::min(level, mesh.lods.size() - 1)];
+      lodErrors[level] = std::max(lodErrors[level], lod.error);
+    }
+  }
+  std::cout << "optimized " << path << ": vertices "
+            << optimizeStats.vertexCountBefore << " -> "
+            << optimizeStats.vertexCountAfter << ", ACMR "
+            << optimizeStats.acmrBefore << " -> " << optimizeStats.acmrAfter
+            << ", " << lodErrors.size() << " detail levels" << std::endl;
+  if (skeleton.getBoneCount() > 0) {
+    std::cout << "skinned " << path << ": " << skeleton.getBoneCount()
+              << " bones, " << animations.size() << " animations"
+              << std::endl;
+  }
 }
 
-void Model::processNode(aiNode *node, const aiScene *scene) {
-  // process all the node's meshes (if any)
-  for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-    aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-    meshes.push_back(processMesh(mesh, scene));
+void Model::processNode(aiNode *root, const aiScene *scene) {
+  // Children are pushed last first, so they pop in file order and each
+  // subtree is finished before the next sibling starts.
+  std::vector<std::pair<aiNode *, unsigned int>> pending = {
+      {root, SCENE_GRAPH_NO_NODE}};
+  std::vector<std::pair<aiNode *, unsigned int>> added;
+  while (!pending.empty()) {
+    auto [node, parent] = pending.back();
+    pending.pop_back();
+    const unsigned int index =
+        nodes.addNode(parent, toGlm(node->mTransformation),
+                      node->mName.C_Str());
+    added.push_back({node, index});
+    for (unsigned int i = node->mNumChildren; i > 0; i--) {
+      pending.push_back({node->mChildren[i - 1], index});
+    }
   }
-  // then do the same for each of its children
-  for (unsigned int i = 0; i < node->mNumChildren; i++) {
-    processNode(node->mChildren[i], scene);
+  // bones name nodes anywhere in the file, so meshes wait for all of them
+  for (const auto &[node, index] : added) {
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+      aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+      processMesh(mesh, scene);
+      meshNodes.push_back(index);
+    }
   }
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
-  std::vector<Vertex> vertices;
-  std::vector<unsigned int> indices;
+void Model::processMesh(aiMesh *mesh, const aiScene *scene) {
+  // scratch comes from the thread's frame arena, the GPU upload reads it
+  // directly unless the mesh keeps a CPU copy
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  FrameVector<Vertex> vertices(&arena);
+  FrameVector<unsigned int> indices(&arena);
   std::vector<Texture> textures;
 
+  vertices.reserve(mesh->mNumVertices);
+  // faces are triangles after aiProcess_Triangulate
+  indices.reserve(mesh->mNumFaces * 3);
+
   for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-    Vertex vertex;
+    // zeroed so the fields assimp does not fill compare equal when welding
+    Vertex vertex{};
     // process vertex positions, normals, and texture coordinates
     glm::vec3 vector;
     vector.x = mesh->mVertices[i].x;
@@ -72,38 +199,143 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
 
     vertices.push_back(vertex);
   }
+  processBones(mesh, vertices.data());
   // process indices
   for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-    aiFace face = mesh->mFaces[i];
+    const aiFace &face = mesh->mFaces[i];
     for (unsigned int j = 0; j < face.mNumIndices; j++) {
       indices.push_back(face.mIndices[j]);
     }
   }
+  // OBJ meshes come in with a vertex per face corner and in file order
+  MeshOptimizeStats stats = optimizeMesh(vertices.data(), vertices.size(),
+                                         indices.data(), indices.size());
+  vertices.resize(stats.vertexCountAfter);
+  addOptimizeStats(stats);
+  std::vector<MeshLod> lods;
+  buildLodChain(vertices.data(), vertices.size(), indices, lods);
   // process material
   if (mesh->mMaterialIndex >= 0) {
     aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-    std::vector<Texture> diffuseMaps = loadMaterialTextures(
-        material, aiTextureType_DIFFUSE, "texture_diffuse");
-    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-    std::vector<Texture> specularMaps = loadMaterialTextures(
-        material, aiTextureType_SPECULAR, "texture_specular");
-    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    textures.reserve(material->GetTextureCount(aiTextureType_DIFFUSE) +
+                     material->GetTextureCount(aiTextureType_SPECULAR));
+    loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse",
+                         textures);
+    loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular",
+                         textures);
   }
 
-  return Mesh(vertices, indices, textures);
+  if (keepCpuData) {
+    meshes.emplace_back(
+        std::vector<Vertex>(vertices.begin(), vertices.end()),
+        std::vector<unsigned int>(indices.begin(), indices.end()),
+        std::move(textures), std::move(lods));
+  } else {
+    meshes.emplace_back(vertices.data(), vertices.size(), indices.data(),
+                        indices.size(), std::move(textures), std::move(lods));
+  }
 }
 
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat,
-                                                 aiTextureType type,
-                                                 std::string typeName) {
-  std::vector<Texture> textures;
+void Model::processBones(aiMesh *mesh, Vertex *vertices) {
+  for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+    const aiBone *bone = mesh->mBones[b];
+    const unsigned int node = nodes.findNode(bone->mName.C_Str());
+    if (node == SCENE_GRAPH_NO_NODE) {
+      std::cout << "ERROR::MODEL::BONE_WITHOUT_NODE " << bone->mName.C_Str()
+                << std::endl;
+      continue;
+    }
+    const int boneIndex = skeleton.addBone(node, toGlm(bone->mOffsetMatrix));
+    for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+      const aiVertexWeight &weight = bone->mWeights[w];
+      Vertex &vertex = vertices[weight.mVertexId];
+      // slots stay sorted by weight, the weakest influence drops out
+      int slot = MAX_BONE_INFLUENCE;
+      while (slot > 0 && vertex.m_Weights[slot - 1] < weight.mWeight) {
+        slot--;
+      }
+      if (slot == MAX_BONE_INFLUENCE) {
+        continue;
+      }
+      for (int k = MAX_BONE_INFLUENCE - 1; k > slot; k--) {
+        vertex.m_Weights[k] = vertex.m_Weights[k - 1];
+        vertex.m_BoneIDs[k] = vertex.m_BoneIDs[k - 1];
+      }
+      vertex.m_Weights[slot] = weight.mWeight;
+      vertex.m_BoneIDs[slot] = boneIndex;
+    }
+  }
+  if (mesh->mNumBones == 0) {
+    return;
+  }
+  for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+    float *weights = vertices[i].m_Weights;
+    const float total = weights[0] + weights[1] + weights[2] + weights[3];
+    for (int k = 0; k < MAX_BONE_INFLUENCE && total > 0.0f; k++) {
+      weights[k] /= total;
+    }
+  }
+}
+
+void Model::addOptimizeStats(const MeshOptimizeStats &stats) {
+  // ACMR of the whole model is the per-mesh ACMR weighted by triangles
+  const size_t triangles = optimizeStats.triangleCount + stats.triangleCount;
+  if (triangles > 0) {
+    optimizeStats.acmrBefore =
+        (optimizeStats.acmrBefore * optimizeStats.triangleCount +
+         stats.acmrBefore * stats.triangleCount) /
+        triangles;
+    optimizeStats.acmrAfter =
+        (optimizeStats.acmrAfter * optimizeStats.triangleCount +
+         stats.acmrAfter * stats.triangleCount) /
+        triangles;
+  }
+  optimizeStats.vertexCountBefore += stats.vertexCountBefore;
+  optimizeStats.vertexCountAfter += stats.vertexCountAfter;
+  optimizeStats.triangleCount = triangles;
+}
+
+void Model::computeBounds() {
+  bounds = Aabb();
+  for (unsigned int i = 0; i < meshes.size(); i++) {
+    bounds.expand(
+        meshes[i].bounds.transformed(nodes.getWorldTransform(meshNodes[i])));
+  }
+  boundingSphere = BoundingSphere();
+  if (bounds.isEmpty()) {
+    return;
+  }
+  // around the box center, wide enough for every mesh's placed sphere
+  boundingSphere.center = bounds.getCenter();
+  boundingSphere.radius = 0.0f;
+  for (unsigned int i = 0; i < meshes.size(); i++) {
+    const BoundingSphere &sphere = meshes[i].boundingSphere;
+    if (sphere.isEmpty()) {
+      continue;
+    }
+    const glm::mat4 &world = nodes.getWorldTransform(meshNodes[i]);
+    const float scale = std::max({glm::length(glm::vec3(world[0])),
+                                  glm::length(glm::vec3(world[1])),
+                                  glm::length(glm::vec3(world[2]))});
+    const glm::vec3 center =
+        glm::vec3(world * glm::vec4(sphere.center, 1.0f));
+    boundingSphere.radius =
+        std::max(boundingSphere.radius,
+                 glm::length(center - boundingSphere.center) +
+                     sphere.radius * scale);
+  }
+}
+
+void Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type,
+                                 const std::string &typeName,
+                                 std::vector<Texture> &out) {
   for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
     aiString str;
     mat->GetTexture(type, i, &str);
     bool skip = false;
     for (unsigned int j = 0; j < textures_loaded.size(); j++) {
       if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-        textures.push_back(textures_loaded[j]);
+        out.push_back(textures_loaded[j]);
         skip = true;
         break;
       }
@@ -112,13 +344,12 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat,
       Texture texture;
       texture.id = TextureFromFile(str.C_Str(), directory);
       texture.type = typeName;
-      ;
       texture.path = str.C_Str();
-      textures.push_back(texture);
-      textures_loaded.push_back(texture);
+      textureObjects.emplace_back(texture.id);
+      out.push_back(texture);
+      textures_loaded.push_back(std::move(texture));
     }
   }
-  return textures;
 }
 
 unsigned int TextureFromFile(const char *path, const std::string &directory,
@@ -126,37 +357,9 @@ unsigned int TextureFromFile(const char *path, const std::string &directory,
   std::string filename = std::string(path);
   filename = directory + '/' + filename;
 
-  unsigned int textureID;
-  glGenTextures(1, &textureID);
-
-  int width, height, nrComponents;
-  unsigned char *data =
-      stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-  if (data) {
-    GLenum format;
-    if (nrComponents == 1)
-      format = GL_RED;
-    else if (nrComponents == 3)
-      format = GL_RGB;
-    else if (nrComponents == 4)
-      format = GL_RGBA;
-
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-  } else {
+  unsigned int textureID = TextureCache::getDefault().load(filename);
+  if (textureID == 0) {
     std::cout << "Texture failed to load at path: " << path << std::endl;
-    stbi_image_free(data);
   }
-
   return textureID;
 }
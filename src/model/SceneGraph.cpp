@@ -0,0 +1,152 @@
+#include "model/SceneGraph.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "jobs/JobSystem.hpp"
+#include "profiling/Profiler.hpp"
+
+unsigned int SceneGraph::addNode(unsigned int parent, const glm::mat4 &local,
+                                 const std::string &name) {
+  const uint32_t node = m_parents.size();
+  // only the ancestors of the last node still have open subtrees
+  if (parent != SCENE_GRAPH_NO_NODE &&
+      (parent >= node || m_subtreeEnds[parent] != node)) {
+    std::cout << "ERROR::SCENE_GRAPH::PARENT_NOT_ON_OPEN_PATH" << std::endl;
+    return SCENE_GRAPH_NO_NODE;
+  }
+  for (uint32_t ancestor = parent; ancestor != SCENE_GRAPH_NO_NODE;
+       ancestor = m_parents[ancestor]) {
+    m_subtreeEnds[ancestor] = node + 1;
+  }
+  m_parents.push_back(parent);
+  m_subtreeEnds.push_back(node + 1);
+  m_locals.push_back(local);
+  m_worlds.push_back(local);
+  m_dirty.push_back(1);
+  m_names.push_back(name);
+  m_anyDirty = true;
+  m_planStale = true;
+  return node;
+}
+
+void SceneGraph::clear() {
+  m_parents.clear();
+  m_subtreeEnds.clear();
+  m_locals.clear();
+  m_worlds.clear();
+  m_dirty.clear();
+  m_names.clear();
+  m_anyDirty = false;
+  m_planStale = true;
+}
+
+unsigned int SceneGraph::getNodeCount() const { return m_parents.size(); }
+
+unsigned int SceneGraph::getParent(unsigned int node) const {
+  return m_parents[node];
+}
+
+unsigned int SceneGraph::getSubtreeEnd(unsigned int node) const {
+  return m_subtreeEnds[node];
+}
+
+const std::string &SceneGraph::getName(unsigned int node) const {
+  return m_names[node];
+}
+
+unsigned int SceneGraph::findNode(const std::string &name) const {
+  auto it = std::find(m_names.begin(), m_names.end(), name);
+  return it == m_names.end() ? SCENE_GRAPH_NO_NODE : it - m_names.begin();
+}
+
+const glm::mat4 &SceneGraph::getLocalTransform(unsigned int node) const {
+  return m_locals[node];
+}
+
+void SceneGraph::setLocalTransform(unsigned int node, const glm::mat4 &local) {
+  m_locals[node] = local;
+  m_dirty[node] = 1;
+  m_anyDirty = true;
+}
+
+const glm::mat4 &SceneGraph::getWorldTransform(unsigned int node) const {
+  return m_worlds[node];
+}
+
+bool SceneGraph::update() {
+  if (!m_anyDirty) {
+    return false;
+  }
+  PROFILE_SCOPE("scene.transforms");
+  if (m_planStale) {
+    buildPlan();
+  }
+  if (m_jobs.size() < 2) {
+    for (uint32_t node = 0; node < m_parents.size(); node++) {
+      updateNode(node);
+    }
+  } else {
+    for (uint32_t node : m_sharedNodes) {
+      updateNode(node);
+    }
+    // each job only writes its own nodes and reads shared ones that are done
+    JobSystem::getDefault().parallelFor(
+        m_jobs.size(), 1, [this](unsigned int begin, unsigned int end) {
+          for (unsigned int job = begin; job < end; job++) {
+            for (uint32_t node = m_jobs[job].begin; node < m_jobs[job].end;
+                 node++) {
+              updateNode(node);
+            }
+          }
+        });
+  }
+  // flags are only cleared once every child has seen its parent's
+  std::fill(m_dirty.begin(), m_dirty.end(), 0);
+  m_anyDirty = false;
+  return true;
+}
+
+bool SceneGraph::isDirty() const { return m_anyDirty; }
+
+void SceneGraph::buildPlan() {
+  m_sharedNodes.clear();
+  m_jobs.clear();
+  m_planStale = false;
+  const uint32_t nodeCount = m_parents.size();
+  if (nodeCount < 2 * SCENE_GRAPH_JOB_NODES) {
+    m_jobs.push_back({0, nodeCount});
+    return;
+  }
+  // Subtrees that fit a job become one, larger ones are split at their
+  // root, which updates first. Adjacent subtrees share a job up to the size
+  // limit; their parents are all shared nodes or earlier in the job.
+  uint32_t node = 0;
+  while (node < nodeCount) {
+    const uint32_t end = m_subtreeEnds[node];
+    if (end - node > SCENE_GRAPH_JOB_NODES) {
+      m_sharedNodes.push_back(node);
+      node++;
+      continue;
+    }
+    if (!m_jobs.empty() && m_jobs.back().end == node &&
+        end - m_jobs.back().begin <= SCENE_GRAPH_JOB_NODES) {
+      m_jobs.back().end = end;
+    } else {
+      m_jobs.push_back({node, end});
+    }
+    node = end;
+  }
+}
+
+void SceneGraph::updateNode(unsigned int node) {
+  const uint32_t parent = m_parents[node];
+  if (parent == SCENE_GRAPH_NO_NODE) {
+    if (m_dirty[node]) {
+      m_worlds[node] = m_locals[node];
+    }
+  } else if (m_dirty[node] || m_dirty[parent]) {
+    m_worlds[node] = m_worlds[parent] * m_locals[node];
+    m_dirty[node] = 1;
+  }
+}
@@ -0,0 +1,97 @@
+#include "model/Skeleton.hpp"
+
+#include <algorithm>
+
+#include "jobs/JobSystem.hpp"
+#include "memory/FrameArena.hpp"
+#include "profiling/Profiler.hpp"
+
+void Skeleton::setHierarchy(const SceneGraph &nodes) {
+  const unsigned int nodeCount = nodes.getNodeCount();
+  m_parents.resize(nodeCount);
+  m_restPose.resize(nodeCount);
+  for (unsigned int node = 0; node < nodeCount; node++) {
+    m_parents[node] = nodes.getParent(node);
+    m_restPose[node] = nodes.getLocalTransform(node);
+  }
+}
+
+unsigned int Skeleton::addBone(unsigned int node, const glm::mat4 &offset) {
+  for (unsigned int bone = 0; bone < m_bones.size(); bone++) {
+    if (m_bones[bone].node == node) {
+      return bone;
+    }
+  }
+  m_bones.push_back({node, offset});
+  return m_bones.size() - 1;
+}
+
+unsigned int Skeleton::getJointCount() const { return m_parents.size(); }
+
+unsigned int Skeleton::getBoneCount() const { return m_bones.size(); }
+
+const std::vector<glm::mat4> &Skeleton::getRestPose() const {
+  return m_restPose;
+}
+
+void Skeleton::computePalette(const glm::mat4 *locals, glm::mat4 *worlds,
+                              glm::mat4 *palette) const {
+  const unsigned int jointCount = m_parents.size();
+  for (unsigned int joint = 0; joint < jointCount; joint++) {
+    const uint32_t parent = m_parents[joint];
+    worlds[joint] = parent == SCENE_GRAPH_NO_NODE
+                        ? locals[joint]
+                        : worlds[parent] * locals[joint];
+  }
+  for (unsigned int bone = 0; bone < m_bones.size(); bone++) {
+    palette[bone] = worlds[m_bones[bone].node] * m_bones[bone].offset;
+  }
+}
+
+void evaluatePoses(const Skeleton &skeleton,
+                   const std::vector<AnimationClip> &clips,
+                   const CharacterPose *poses, unsigned int poseCount,
+                   glm::mat4 *palettes) {
+  PROFILE_SCOPE("animation.poses");
+  const unsigned int jointCount = skeleton.getJointCount();
+  const unsigned int boneCount = skeleton.getBoneCount();
+  const std::vector<glm::mat4> &restPose = skeleton.getRestPose();
+  JobSystem::getDefault().parallelFor(
+      poseCount, SKELETON_POSES_PER_JOB,
+      [&](unsigned int begin, unsigned int end) {
+        FrameArena &arena = FrameArena::forThread();
+        FrameArenaScope scratch(arena);
+        FrameVector<glm::mat4> locals(jointCount, &arena);
+        FrameVector<glm::mat4> worlds(jointCount, &arena);
+        for (unsigned int i = begin; i < end; i++) {
+          std::copy(restPose.begin(), restPose.end(), locals.begin());
+          if (poses[i].clip < clips.size()) {
+            clips[poses[i].clip].sample(poses[i].time, locals.data());
+          }
+          skeleton.computePalette(locals.data(), worlds.data(),
+                                  palettes + (size_t)i * boneCount);
+        }
+      });
+}
+
+void skinVertices(const Vertex *in, size_t count, const glm::mat4 *palette,
+                  Vertex *out) {
+  for (size_t i = 0; i < count; i++) {
+    const Vertex &vertex = in[i];
+    glm::mat4 skin(0.0f);
+    float total = 0.0f;
+    for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+      if (vertex.m_Weights[k] > 0.0f) {
+        skin += vertex.m_Weights[k] * palette[vertex.m_BoneIDs[k]];
+        total += vertex.m_Weights[k];
+      }
+    }
+    Vertex skinned = vertex;
+    if (total > 0.0f) {
+      skinned.Position = glm::vec3(skin * glm::vec4(vertex.Position, 1.0f));
+      // bones are rigid up to uniform scale, so no inverse transpose
+      skinned.Normal = glm::normalize(glm::mat3(skin) * vertex.Normal);
+    }
+    out[i] = skinned;
+  }
+}
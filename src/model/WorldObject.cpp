@@ -1,8 +1,11 @@
 #include "model/WorldObject.hpp"
+
+#include <algorithm>
+
 #include <glm/gtc/matrix_transform.hpp>
 
 WorldObject::WorldObject() {}
-WorldObject::WorldObject(std::string const &path) { m_model = Model(path); }
+WorldObject::WorldObject(std::string const &path) : m_model(path) {}
 
 void WorldObject::Draw() { this->m_model.Draw(); }
 
@@ -11,12 +14,7 @@ void WorldObject::Draw() { this->m_model.Draw(); }
 // passing.
 void WorldObject::Draw(Shader &shader) {
   shader.use();
-  glm::mat4 modelTransform = glm::mat4(1.0f);
-  modelTransform = glm::translate(modelTransform, m_position);
-  //  todo, add rotation
-  modelTransform = glm::scale(modelTransform, m_scale);
-  shader.setMat4("model", modelTransform);
-  this->m_model.Draw(shader);
+  this->m_model.Draw(shader, getTransform());
 }
 
 glm::vec3 WorldObject::getPosition() const { return m_position; }
@@ -34,3 +32,31 @@ void WorldObject::setVelocity(const glm::vec3 velocity) {
 glm::vec3 WorldObject::getScale() const { return m_scale; }
 
 void WorldObject::setScale(const glm::vec3 scale) { m_scale = scale; }
+
+glm::mat4 WorldObject::getTransform() const {
+  glm::mat4 transform = glm::mat4(1.0f);
+  transform = glm::translate(transform, m_position);
+  //  todo, add rotation
+  return glm::scale(transform, m_scale);
+}
+
+Aabb WorldObject::getBounds() const {
+  return m_model.getBounds().transformed(getTransform());
+}
+
+BoundingSphere WorldObject::getBoundingSphere() const {
+  const BoundingSphere &local = m_model.getBoundingSphere();
+  if (local.isEmpty()) {
+    return local;
+  }
+  // a non-uniform scale stretches the sphere by its largest axis
+  const glm::vec3 scale = glm::abs(m_scale);
+  BoundingSphere sphere;
+  sphere.center = m_position + m_scale * local.center;
+  sphere.radius = local.radius * std::max({scale.x, scale.y, scale.z});
+  return sphere;
+}
+
+Model &WorldObject::getModel() { return m_model; }
+
+const Model &WorldObject::getModel() const { return m_model; }
@@ -0,0 +1,54 @@
+#include "net/BitStream.hpp"
+
+BitWriter::BitWriter(std::vector<unsigned char> &out) : m_out(out) {}
+
+void BitWriter::write(uint32_t value, unsigned int bits) {
+  if (bits < 32) {
+    value &= (1u << bits) - 1;
+  }
+  m_scratch |= (uint64_t)value << m_scratchBits;
+  m_scratchBits += bits;
+  m_bitCount += bits;
+  while (m_scratchBits >= 8) {
+    m_out.push_back((unsigned char)m_scratch);
+    m_scratch >>= 8;
+    m_scratchBits -= 8;
+  }
+}
+
+void BitWriter::writeBool(bool value) { write(value ? 1 : 0, 1); }
+
+void BitWriter::flush() {
+  if (m_scratchBits > 0) {
+    m_out.push_back((unsigned char)m_scratch);
+    m_scratch = 0;
+    m_scratchBits = 0;
+  }
+}
+
+size_t BitWriter::getBitCount() const { return m_bitCount; }
+
+BitReader::BitReader(const unsigned char *data, size_t size)
+    : m_data(data), m_size(size) {}
+
+uint32_t BitReader::read(unsigned int bits) {
+  while (m_scratchBits < bits) {
+    uint64_t byte = 0;
+    if (m_offset < m_size) {
+      byte = m_data[m_offset++];
+    } else {
+      m_overflowed = true;
+    }
+    m_scratch |= byte << m_scratchBits;
+    m_scratchBits += 8;
+  }
+  uint32_t value =
+      (uint32_t)(bits < 32 ? m_scratch & ((1ull << bits) - 1) : m_scratch);
+  m_scratch >>= bits;
+  m_scratchBits -= bits;
+  return value;
+}
+
+bool BitReader::readBool() { return read(1) != 0; }
+
+bool BitReader::hasOverflowed() const { return m_overflowed; }
@@ -0,0 +1,104 @@
+#include "net/NetProtocol.hpp"
+
+#include <cstring>
+
+namespace {
+template <typename T>
+void appendRaw(std::vector<unsigned char> &buffer, const T &value) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+// reads advance offset, every read is bounds checked
+template <typename T>
+bool readRaw(const unsigned char *data, size_t size, size_t &offset,
+             T &value) {
+  if (offset + sizeof(T) > size) {
+    return false;
+  }
+  std::memcpy(&value, data + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+void writeHeader(NetPacketType type, std::vector<unsigned char> &out) {
+  out.clear();
+  appendRaw(out, (uint32_t)NET_MAGIC);
+  appendRaw(out, (uint8_t)type);
+}
+} // namespace
+
+void writeClientView(const ClientViewPacket &packet,
+                     std::vector<unsigned char> &out) {
+  writeHeader(NetPacketType::ClientView, out);
+  appendRaw(out, packet.cameraPosition);
+  appendRaw(out, packet.interestRadius);
+  appendRaw(out, packet.bytesPerSecond);
+}
+
+void writeState(const StatePacket &packet, std::vector<unsigned char> &out) {
+  writeHeader(NetPacketType::State, out);
+  appendRaw(out, packet.tick);
+  appendRaw(out, packet.timestep);
+  appendRaw(out, packet.arenaMin);
+  appendRaw(out, packet.arenaMax);
+  appendRaw(out, packet.codec.positionPrecision);
+  appendRaw(out, packet.codec.velocityPrecision);
+  appendRaw(out, packet.codec.maxSpeed);
+  appendRaw(out, (uint16_t)packet.bodies.size());
+
+  StateCodec codec(packet.arenaMin, packet.arenaMax, packet.codec);
+  BitWriter writer(out);
+  uint32_t previousId = UINT32_MAX;
+  for (const CodecBodyState &body : packet.bodies) {
+    codec.writeBody(writer, body, previousId);
+    previousId = body.id;
+  }
+  writer.flush();
+}
+
+bool readPacketType(const unsigned char *data, size_t size,
+                    NetPacketType &type) {
+  size_t offset = 0;
+  uint32_t magic;
+  uint8_t rawType;
+  if (!readRaw(data, size, offset, magic) || magic != NET_MAGIC ||
+      !readRaw(data, size, offset, rawType)) {
+    return false;
+  }
+  type = (NetPacketType)rawType;
+  return true;
+}
+
+bool readClientView(const unsigned char *data, size_t size,
+                    ClientViewPacket &packet) {
+  size_t offset = 5;
+  return readRaw(data, size, offset, packet.cameraPosition) &&
+         readRaw(data, size, offset, packet.interestRadius) &&
+         readRaw(data, size, offset, packet.bytesPerSecond);
+}
+
+bool readState(const unsigned char *data, size_t size, StatePacket &packet) {
+  size_t offset = 5;
+  uint16_t count;
+  if (!readRaw(data, size, offset, packet.tick) ||
+      !readRaw(data, size, offset, packet.timestep) ||
+      !readRaw(data, size, offset, packet.arenaMin) ||
+      !readRaw(data, size, offset, packet.arenaMax) ||
+      !readRaw(data, size, offset, packet.codec.positionPrecision) ||
+      !readRaw(data, size, offset, packet.codec.velocityPrecision) ||
+      !readRaw(data, size, offset, packet.codec.maxSpeed) ||
+      !readRaw(data, size, offset, count)) {
+    return false;
+  }
+
+  StateCodec codec(packet.arenaMin, packet.arenaMax, packet.codec);
+  BitReader reader(data + offset, size - offset);
+  packet.bodies.resize(count);
+  uint32_t previousId = UINT32_MAX;
+  for (CodecBodyState &body : packet.bodies) {
+    codec.readBody(reader, body, previousId);
+    previousId = body.id;
+  }
+  return !reader.hasOverflowed();
+}
@@ -0,0 +1,169 @@
+#include "net/ReplicationClient.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "profiling/Profiler.hpp"
+
+bool ReplicationClient::connect(const std::string &server) {
+  if (!NetAddress::parse(server, NET_DEFAULT_PORT, m_server)) {
+    return false;
+  }
+  if (!m_socket.open(0)) {
+    return false;
+  }
+  std::cout << "connecting to " << m_server.toString() << std::endl;
+  return true;
+}
+
+bool ReplicationClient::isConnected() const { return m_socket.isOpen(); }
+
+void ReplicationClient::setView(const glm::vec3 cameraPosition,
+                                float interestRadius,
+                                uint32_t bytesPerSecond) {
+  m_view.cameraPosition = cameraPosition;
+  m_view.interestRadius = interestRadius;
+  m_view.bytesPerSecond = bytesPerSecond;
+}
+
+void ReplicationClient::update(float deltaTime) {
+  PROFILE_SCOPE("net.client");
+  if (!m_socket.isOpen()) {
+    return;
+  }
+  m_viewTimer += deltaTime;
+  if (m_viewTimer >= 1.0f / NET_VIEW_RATE) {
+    m_viewTimer = 0.0f;
+    writeClientView(m_view, m_buffer);
+    m_socket.send(m_server, m_buffer.data(), m_buffer.size());
+  }
+
+  m_renderTime += deltaTime;
+  receive();
+  if (!m_clockStarted) {
+    return;
+  }
+  // drift back towards the target delay instead of jumping, a hard reset
+  // would make every body skip
+  double target = m_latestTime - NET_INTERPOLATION_DELAY;
+  m_renderTime += (target - m_renderTime) * std::min(deltaTime * 2.0f, 1.0f);
+
+  for (unsigned int i = 0; i < m_ids.size();) {
+    if (m_latestTime - m_lastSeen[i] > NET_BODY_TIMEOUT) {
+      removeBody(i);
+    } else {
+      i++;
+    }
+  }
+  interpolate();
+}
+
+unsigned int ReplicationClient::getBodyCount() const { return m_ids.size(); }
+
+glm::vec3 ReplicationClient::getPosition(unsigned int body) const {
+  return m_positions[body];
+}
+
+float ReplicationClient::getRadius(unsigned int body) const {
+  return m_radii[body];
+}
+
+uint32_t ReplicationClient::getServerId(unsigned int body) const {
+  return m_ids[body];
+}
+
+uint64_t ReplicationClient::getBytesReceived() const {
+  return m_bytesReceived;
+}
+
+uint64_t ReplicationClient::getLatestTick() const { return m_latestTick; }
+
+void ReplicationClient::receive() {
+  unsigned char data[NET_MAX_PACKET_BYTES];
+  NetAddress from;
+  while (size_t size = m_socket.receive(data, sizeof(data), from)) {
+    NetPacketType type;
+    if (!(from == m_server) || !readPacketType(data, size, type) ||
+        type != NetPacketType::State || !readState(data, size, m_packet)) {
+      continue;
+    }
+    m_bytesReceived += size;
+    applyState(m_packet);
+  }
+}
+
+void ReplicationClient::applyState(const StatePacket &packet) {
+  const double time = packet.tick * (double)packet.timestep;
+  if (!m_clockStarted) {
+    m_renderTime = time - NET_INTERPOLATION_DELAY;
+    m_clockStarted = true;
+  }
+  m_latestTick = std::max(m_latestTick, packet.tick);
+  m_latestTime = std::max(m_latestTime, time);
+
+  for (const CodecBodyState &body : packet.bodies) {
+    auto found = m_indexOf.find(body.id);
+    if (found == m_indexOf.end()) {
+      m_indexOf[body.id] = m_ids.size();
+      m_ids.push_back(body.id);
+      m_previous.push_back({time, body.position, body.velocity});
+      m_current.push_back({time, body.position, body.velocity});
+      // invisible until a packet with the radius gets through
+      m_radii.push_back(body.hasRadius ? body.radius : 0.0f);
+      m_lastSeen.push_back(time);
+      m_positions.push_back(body.position);
+      continue;
+    }
+    unsigned int index = found->second;
+    // UDP reorders, an older state than the one held is useless
+    if (time <= m_current[index].time) {
+      continue;
+    }
+    m_previous[index] = m_current[index];
+    m_current[index] = {time, body.position, body.velocity};
+    if (body.hasRadius) {
+      m_radii[index] = body.radius;
+    }
+    m_lastSeen[index] = time;
+  }
+}
+
+void ReplicationClient::removeBody(unsigned int index) {
+  // swap with the last body so the arrays stay dense
+  const unsigned int last = m_ids.size() - 1;
+  m_indexOf.erase(m_ids[index]);
+  if (index != last) {
+    m_ids[index] = m_ids[last];
+    m_previous[index] = m_previous[last];
+    m_current[index] = m_current[last];
+    m_radii[index] = m_radii[last];
+    m_lastSeen[index] = m_lastSeen[last];
+    m_positions[index] = m_positions[last];
+    m_indexOf[m_ids[index]] = index;
+  }
+  m_ids.pop_back();
+  m_previous.pop_back();
+  m_current.pop_back();
+  m_radii.pop_back();
+  m_lastSeen.pop_back();
+  m_positions.pop_back();
+}
+
+void ReplicationClient::interpolate() {
+  for (unsigned int i = 0; i < m_ids.size(); i++) {
+    const Sample &from = m_previous[i];
+    const Sample &to = m_current[i];
+    if (m_renderTime > to.time) {
+      float ahead = (float)std::min(m_renderTime - to.time,
+                                    (double)NET_MAX_EXTRAPOLATION);
+      m_positions[i] = to.position + to.velocity * ahead;
+      continue;
+    }
+    double span = to.time - from.time;
+    float alpha =
+        span > 0.0 ? (float)std::clamp((m_renderTime - from.time) / span,
+                                       0.0, 1.0)
+                   : 1.0f;
+    m_positions[i] = glm::mix(from.position, to.position, alpha);
+  }
+}
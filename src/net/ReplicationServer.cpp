@@ -0,0 +1,228 @@
+#include "net/ReplicationServer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "profiling/Profiler.hpp"
+
+ReplicationServer::ReplicationServer(const PhysicsWorld &world)
+    : m_world(world), m_codec(world.getBorderMin(), world.getBorderMax(),
+                              m_codecConfig) {}
+
+bool ReplicationServer::open(uint16_t port) { return m_socket.open(port); }
+
+uint16_t ReplicationServer::getPort() const { return m_socket.getPort(); }
+
+void ReplicationServer::setSendRate(float packetsPerSecond) {
+  m_sendInterval = 1.0f / std::max(packetsPerSecond, 1.0f);
+}
+
+void ReplicationServer::setCodecConfig(const StateCodecConfig &config) {
+  m_codecConfig = config;
+  m_codec =
+      StateCodec(m_world.getBorderMin(), m_world.getBorderMax(), m_codecConfig);
+}
+
+void ReplicationServer::update(float deltaTime) {
+  PROFILE_SCOPE("net.server");
+  if (!m_socket.isOpen()) {
+    return;
+  }
+  receive();
+  for (Client &client : m_clients) {
+    client.silentTime += deltaTime;
+    client.sendTimer += deltaTime;
+    const float rate = client.view.bytesPerSecond;
+    // at most a quarter second of unused bandwidth is saved up
+    client.budget =
+        std::min(client.budget + rate * deltaTime,
+                 std::max(rate * 0.25f, (float)NET_MAX_PACKET_BYTES));
+    if (client.sendTimer >= m_sendInterval) {
+      sendState(client, client.sendTimer);
+      client.sendTimer = 0.0f;
+    }
+  }
+  m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+                                 [](const Client &client) {
+                                   return client.silentTime >
+                                          NET_CLIENT_TIMEOUT;
+                                 }),
+                  m_clients.end());
+}
+
+unsigned int ReplicationServer::getClientCount() const {
+  return m_clients.size();
+}
+
+uint64_t ReplicationServer::getBytesSent() const { return m_bytesSent; }
+
+uint64_t ReplicationServer::getBodiesSent() const { return m_bodiesSent; }
+
+void ReplicationServer::receive() {
+  unsigned char data[NET_MAX_PACKET_BYTES];
+  NetAddress from;
+  while (size_t size = m_socket.receive(data, sizeof(data), from)) {
+    NetPacketType type;
+    ClientViewPacket view;
+    if (!readPacketType(data, size, type) ||
+        type != NetPacketType::ClientView ||
+        !readClientView(data, size, view)) {
+      continue;
+    }
+    // the view comes off the wire, a bad radius or camera would poison the
+    // priorities and the broadphase query
+    const glm::vec3 camera = view.cameraPosition;
+    if (!std::isfinite(view.interestRadius) || !(view.interestRadius > 0.0f) ||
+        !std::isfinite(camera.x) || !std::isfinite(camera.y) ||
+        !std::isfinite(camera.z)) {
+      continue;
+    }
+    // keeps the query box within a few arena sizes, so cell coordinates stay
+    // far from int overflow
+    const glm::vec3 arenaMin = m_world.getBorderMin();
+    const glm::vec3 arenaMax = m_world.getBorderMax();
+    const glm::vec3 arenaSize = arenaMax - arenaMin;
+    view.cameraPosition =
+        glm::clamp(camera, arenaMin - arenaSize, arenaMax + arenaSize);
+    view.interestRadius = std::min(view.interestRadius, glm::length(arenaSize));
+    view.bytesPerSecond =
+        std::min(view.bytesPerSecond, (uint32_t)NET_MAX_BYTES_PER_SECOND);
+
+    auto client = std::find_if(
+        m_clients.begin(), m_clients.end(),
+        [&](const Client &client) { return client.address == from; });
+    if (client == m_clients.end()) {
+      if (m_clients.size() >= NET_MAX_CLIENTS) {
+        continue;
+      }
+      std::cout << "client connected: " << from.toString() << std::endl;
+      m_clients.push_back(Client());
+      client = m_clients.end() - 1;
+      client->address = from;
+    }
+    client->view = view;
+    client->silentTime = 0.0f;
+  }
+}
+
+void ReplicationServer::sendState(Client &client, float elapsed) {
+  // interest: bodies whose center is within the radius of the camera
+  const glm::vec3 center = client.view.cameraPosition;
+  const float radius = client.view.interestRadius;
+  m_candidates.clear();
+  m_world.getBroadphase().queryBox(center - glm::vec3(radius),
+                                   center + glm::vec3(radius), m_candidates);
+  const unsigned int slotCount = m_world.getSlotCount();
+  client.priority.resize(slotCount, 0.0f);
+  client.radiusSends.resize(slotCount, 0);
+  client.generations.resize(slotCount, 0);
+  m_inView.clear();
+  for (unsigned int body : m_candidates) {
+    // the grid is from the last step, bodies added or removed since are not
+    if (body >= m_world.getBodyCount()) {
+      continue;
+    }
+    float distance = glm::length(m_world.getPosition(body) - center);
+    if (distance > radius) {
+      continue;
+    }
+    const BodyHandle handle = m_world.getBodyHandle(body);
+    if (client.generations[handle.slot] != handle.generation) {
+      client.generations[handle.slot] = handle.generation;
+      client.priority[handle.slot] = 0.0f;
+      client.radiusSends[handle.slot] = 0;
+    }
+    // a body at the camera gains priority twice as fast as one at the edge
+    client.priority[handle.slot] += elapsed * (2.0f - distance / radius);
+    m_inView.push_back(handle.slot);
+  }
+
+  // as many packets as the budget allows, highest priority first
+  const size_t minPacket = NET_STATE_HEADER_BYTES + 8;
+  const size_t minBodyBits = m_codec.getBodyBits(CodecBodyState()) + 4;
+  const size_t maxBodies =
+      std::min(getBudgetBytes(client) * 8 / minBodyBits, m_inView.size());
+  std::partial_sort(m_inView.begin(), m_inView.begin() + maxBodies,
+                    m_inView.end(), [&](unsigned int a, unsigned int b) {
+                      // ties go to the lower id so sends are repeatable
+                      if (client.priority[a] != client.priority[b]) {
+                        return client.priority[a] > client.priority[b];
+                      }
+                      return a < b;
+                    });
+
+  size_t next = 0;
+  while (next < maxBodies && getBudgetBytes(client) >= minPacket) {
+    const size_t packetBytes =
+        std::min(getBudgetBytes(client), (size_t)NET_MAX_PACKET_BYTES);
+    // take bodies while their estimated size fits
+    m_batch.clear();
+    size_t bits = NET_STATE_HEADER_BYTES * 8;
+    for (; next < maxBodies; next++) {
+      unsigned int id = m_inView[next];
+      CodecBodyState state;
+      state.velocity = m_world.getVelocity(bodyIndex(client, id));
+      state.hasRadius = client.radiusSends[id] < NET_RADIUS_REPEATS;
+      size_t bodyBits = m_codec.getBodyBits(state) + NET_ID_BITS_ESTIMATE;
+      if (bits + bodyBits > packetBytes * 8) {
+        break;
+      }
+      bits += bodyBits;
+      m_batch.push_back(id);
+    }
+    if (m_batch.empty()) {
+      break;
+    }
+    std::sort(m_batch.begin(), m_batch.end());
+    fillPacket(client, m_batch);
+    // a rare run of large id gaps can overshoot the estimate
+    while (m_buffer.size() > packetBytes && m_packet.bodies.size() > 1) {
+      m_packet.bodies.pop_back();
+      writeState(m_packet, m_buffer);
+    }
+    if (!m_socket.send(client.address, m_buffer.data(), m_buffer.size())) {
+      break;
+    }
+    for (const CodecBodyState &state : m_packet.bodies) {
+      client.priority[state.id] = 0.0f;
+      if (state.hasRadius) {
+        client.radiusSends[state.id]++;
+      }
+    }
+    client.budget -= m_buffer.size();
+    m_bytesSent += m_buffer.size();
+    m_bodiesSent += m_packet.bodies.size();
+  }
+}
+
+void ReplicationServer::fillPacket(Client &client,
+                                   const std::vector<unsigned int> &ids) {
+  m_packet.tick = m_world.getTick();
+  m_packet.timestep = m_world.getFixedTimestep();
+  m_packet.arenaMin = m_world.getBorderMin();
+  m_packet.arenaMax = m_world.getBorderMax();
+  m_packet.codec = m_codecConfig;
+  m_packet.bodies.resize(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    const unsigned int body = bodyIndex(client, ids[i]);
+    CodecBodyState &state = m_packet.bodies[i];
+    state.id = ids[i];
+    state.position = m_world.getPosition(body);
+    state.velocity = m_world.getVelocity(body);
+    state.hasRadius = client.radiusSends[ids[i]] < NET_RADIUS_REPEATS;
+    state.radius = m_world.getRadius(body);
+  }
+  writeState(m_packet, m_buffer);
+}
+
+unsigned int ReplicationServer::bodyIndex(const Client &client,
+                                          unsigned int id) const {
+  // ids in view were checked against their generation this send
+  return m_world.getBodyIndex({id, client.generations[id]});
+}
+
+size_t ReplicationServer::getBudgetBytes(const Client &client) {
+  // an overshooting packet can leave the bucket in debt
+  return client.budget > 0.0f ? (size_t)client.budget : 0;
+}
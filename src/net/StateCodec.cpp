@@ -0,0 +1,175 @@
+#include "net/StateCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// largest magnitude of the three smallest components of a unit quaternion
+const float QUATERNION_COMPONENT_MAX = 0.70710678f;
+
+// id deltas come in four size classes behind a 2-bit prefix
+const unsigned int ID_CLASS_BITS[4] = {2, 5, 9, 32};
+const uint32_t ID_CLASS_START[4] = {1, 5, 37, 0};
+
+void writeIdDelta(BitWriter &writer, uint32_t id, uint32_t previousId) {
+  // wraps so the first body (previous UINT32_MAX) is sent as id + 1
+  uint32_t delta = id - previousId;
+  for (int c = 0; c < 3; c++) {
+    if (delta >= ID_CLASS_START[c] &&
+        delta - ID_CLASS_START[c] < (1u << ID_CLASS_BITS[c])) {
+      writer.write(c, 2);
+      writer.write(delta - ID_CLASS_START[c], ID_CLASS_BITS[c]);
+      return;
+    }
+  }
+  writer.write(3, 2);
+  writer.write(id, 32);
+}
+
+uint32_t readId(BitReader &reader, uint32_t previousId) {
+  uint32_t c = reader.read(2);
+  uint32_t value = reader.read(ID_CLASS_BITS[c]);
+  if (c == 3) {
+    return value;
+  }
+  return previousId + ID_CLASS_START[c] + value;
+}
+} // namespace
+
+QuantizedRange QuantizedRange::fromPrecision(float min, float max,
+                                             float precision) {
+  QuantizedRange range;
+  range.min = min;
+  range.max = max;
+  double steps = std::ceil((max - min) / std::max(precision, 1e-6f));
+  range.bits = std::clamp((int)std::ceil(std::log2(steps + 1.0)), 1, 32);
+  return range;
+}
+
+uint32_t QuantizedRange::quantize(float value) const {
+  const double maxValue = bits < 32 ? (double)((1u << bits) - 1) : 4294967295.0;
+  double t = (value - min) / std::max(max - min, 1e-6f);
+  return (uint32_t)std::llround(std::clamp(t, 0.0, 1.0) * maxValue);
+}
+
+float QuantizedRange::dequantize(uint32_t value) const {
+  const double maxValue = bits < 32 ? (double)((1u << bits) - 1) : 4294967295.0;
+  return min + (float)((max - min) * (value / maxValue));
+}
+
+void writeQuaternion(BitWriter &writer, const glm::quat &q,
+                     unsigned int componentBits) {
+  float components[4] = {q.x, q.y, q.z, q.w};
+  int largest = 0;
+  for (int i = 1; i < 4; i++) {
+    if (std::abs(components[i]) > std::abs(components[largest])) {
+      largest = i;
+    }
+  }
+  // q and -q are the same rotation, flip so the dropped one is positive
+  float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+  QuantizedRange range{-QUATERNION_COMPONENT_MAX, QUATERNION_COMPONENT_MAX,
+                       componentBits};
+  writer.write(largest, 2);
+  for (int i = 0; i < 4; i++) {
+    if (i != largest) {
+      writer.write(range.quantize(components[i] * sign), componentBits);
+    }
+  }
+}
+
+glm::quat readQuaternion(BitReader &reader, unsigned int componentBits) {
+  QuantizedRange range{-QUATERNION_COMPONENT_MAX, QUATERNION_COMPONENT_MAX,
+                       componentBits};
+  int largest = reader.read(2);
+  float components[4];
+  float sumSquares = 0.0f;
+  for (int i = 0; i < 4; i++) {
+    if (i != largest) {
+      components[i] = range.dequantize(reader.read(componentBits));
+      sumSquares += components[i] * components[i];
+    }
+  }
+  components[largest] = std::sqrt(std::max(1.0f - sumSquares, 0.0f));
+  glm::quat q(components[3], components[0], components[1], components[2]);
+  return glm::normalize(q);
+}
+
+StateCodec::StateCodec() : StateCodec(glm::vec3(0.0f), glm::vec3(1.0f), {}) {}
+
+StateCodec::StateCodec(const glm::vec3 arenaMin, const glm::vec3 arenaMax,
+                       const StateCodecConfig &config)
+    : m_config(config) {
+  for (int axis = 0; axis < 3; axis++) {
+    m_position[axis] = QuantizedRange::fromPrecision(
+        arenaMin[axis], arenaMax[axis], config.positionPrecision);
+  }
+  m_velocity = QuantizedRange::fromPrecision(-config.maxSpeed, config.maxSpeed,
+                                             config.velocityPrecision);
+  // radii to a thousandth of a unit up to 64 units
+  m_radius = QuantizedRange{0.0f, 64.0f, 16};
+}
+
+void StateCodec::writeBody(BitWriter &writer, const CodecBodyState &body,
+                           uint32_t previousId) const {
+  writeIdDelta(writer, body.id, previousId);
+  for (int axis = 0; axis < 3; axis++) {
+    writer.write(m_position[axis].quantize(body.position[axis]),
+                 m_position[axis].bits);
+  }
+  uint32_t velocity[3];
+  bool moving = false;
+  const uint32_t zero = m_velocity.quantize(0.0f);
+  for (int axis = 0; axis < 3; axis++) {
+    velocity[axis] = m_velocity.quantize(body.velocity[axis]);
+    moving = moving || velocity[axis] != zero;
+  }
+  writer.writeBool(moving);
+  if (moving) {
+    for (int axis = 0; axis < 3; axis++) {
+      writer.write(velocity[axis], m_velocity.bits);
+    }
+  }
+  writer.writeBool(body.hasRadius);
+  if (body.hasRadius) {
+    writer.write(m_radius.quantize(body.radius), m_radius.bits);
+  }
+}
+
+void StateCodec::readBody(BitReader &reader, CodecBodyState &body,
+                          uint32_t previousId) const {
+  body.id = readId(reader, previousId);
+  for (int axis = 0; axis < 3; axis++) {
+    body.position[axis] =
+        m_position[axis].dequantize(reader.read(m_position[axis].bits));
+  }
+  body.velocity = glm::vec3(0.0f);
+  if (reader.readBool()) {
+    for (int axis = 0; axis < 3; axis++) {
+      body.velocity[axis] =
+          m_velocity.dequantize(reader.read(m_velocity.bits));
+    }
+  }
+  body.hasRadius = reader.readBool();
+  if (body.hasRadius) {
+    body.radius = m_radius.dequantize(reader.read(m_radius.bits));
+  }
+}
+
+unsigned int StateCodec::getBodyBits(const CodecBodyState &body) const {
+  unsigned int bits = m_position[0].bits + m_position[1].bits +
+                      m_position[2].bits + 2;
+  const uint32_t zero = m_velocity.quantize(0.0f);
+  for (int axis = 0; axis < 3; axis++) {
+    if (m_velocity.quantize(body.velocity[axis]) != zero) {
+      bits += 3 * m_velocity.bits;
+      break;
+    }
+  }
+  if (body.hasRadius) {
+    bits += m_radius.bits;
+  }
+  return bits;
+}
+
+const StateCodecConfig &StateCodec::getConfig() const { return m_config; }
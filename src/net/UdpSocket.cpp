@@ -0,0 +1,123 @@
+#include "net/UdpSocket.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+sockaddr_in toSockaddr(const NetAddress &address) {
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(address.ip);
+  addr.sin_port = htons(address.port);
+  return addr;
+}
+} // namespace
+
+bool NetAddress::parse(const std::string &text, uint16_t defaultPort,
+                       NetAddress &out) {
+  std::string host = text;
+  out.port = defaultPort;
+  size_t colon = text.rfind(':');
+  if (colon != std::string::npos) {
+    host = text.substr(0, colon);
+    int port = std::atoi(text.c_str() + colon + 1);
+    if (port <= 0 || port > 65535) {
+      std::cout << "ERROR::NET::INVALID_PORT: " << text << std::endl;
+      return false;
+    }
+    out.port = port;
+  }
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo *result = nullptr;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+    std::cout << "ERROR::NET::UNKNOWN_HOST: " << host << std::endl;
+    return false;
+  }
+  out.ip = ntohl(((sockaddr_in *)result->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(result);
+  return true;
+}
+
+std::string NetAddress::toString() const {
+  return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xff) +
+         "." + std::to_string((ip >> 8) & 0xff) + "." +
+         std::to_string(ip & 0xff) + ":" + std::to_string(port);
+}
+
+UdpSocket::~UdpSocket() { close(); }
+
+bool UdpSocket::open(uint16_t port) {
+  close();
+  m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (m_socket < 0) {
+    std::cout << "ERROR::NET::SOCKET_CREATE_FAILED: " << std::strerror(errno)
+              << std::endl;
+    return false;
+  }
+
+  sockaddr_in addr = toSockaddr(NetAddress{INADDR_ANY, port});
+  if (bind(m_socket, (sockaddr *)&addr, sizeof(addr)) < 0) {
+    std::cout << "ERROR::NET::BIND_FAILED: port " << port << ": "
+              << std::strerror(errno) << std::endl;
+    close();
+    return false;
+  }
+  int flags = fcntl(m_socket, F_GETFL, 0);
+  if (flags < 0 || fcntl(m_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+    std::cout << "ERROR::NET::NONBLOCKING_FAILED" << std::endl;
+    close();
+    return false;
+  }
+
+  socklen_t length = sizeof(addr);
+  getsockname(m_socket, (sockaddr *)&addr, &length);
+  m_port = ntohs(addr.sin_port);
+  return true;
+}
+
+void UdpSocket::close() {
+  if (m_socket >= 0) {
+    ::close(m_socket);
+    m_socket = -1;
+  }
+  m_port = 0;
+}
+
+bool UdpSocket::isOpen() const { return m_socket >= 0; }
+
+uint16_t UdpSocket::getPort() const { return m_port; }
+
+bool UdpSocket::send(const NetAddress &to, const void *data, size_t size) {
+  sockaddr_in addr = toSockaddr(to);
+  ssize_t sent =
+      sendto(m_socket, data, size, 0, (sockaddr *)&addr, sizeof(addr));
+  // a full send buffer drops the datagram like the network would
+  return sent == (ssize_t)size;
+}
+
+size_t UdpSocket::receive(void *buffer, size_t capacity, NetAddress &from) {
+  sockaddr_in addr;
+  socklen_t length = sizeof(addr);
+  ssize_t received =
+      recvfrom(m_socket, buffer, capacity, 0, (sockaddr *)&addr, &length);
+  if (received <= 0) {
+    return 0;
+  }
+  from.ip = ntohl(addr.sin_addr.s_addr);
+  from.port = ntohs(addr.sin_port);
+  return received;
+}
@@ -0,0 +1,17 @@
+#include "physics/BodyFrame.hpp"
+
+void BodyFrame::capture(const PhysicsWorld &world, double time) {
+  const unsigned int bodyCount = world.getBodyCount();
+  this->tick = world.getTick();
+  this->time = time;
+  positions.resize(bodyCount);
+  velocities.resize(bodyCount);
+  radii.resize(bodyCount);
+  handles.resize(bodyCount);
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    positions[i] = world.getPosition(i);
+    velocities[i] = world.getVelocity(i);
+    radii[i] = world.getRadius(i);
+    handles[i] = world.getBodyHandle(i);
+  }
+}
@@ -0,0 +1,92 @@
+#include "physics/BodyInterpolator.hpp"
+
+#include <algorithm>
+
+#include "profiling/Profiler.hpp"
+
+BodyInterpolator::BodyInterpolator(unsigned int frameCount)
+    : m_frames(std::max(frameCount, 2u)) {}
+
+void BodyInterpolator::capture(const PhysicsWorld &world, double time) {
+  nextFrame().capture(world, time);
+}
+
+void BodyInterpolator::capture(const BodyFrame &frame) {
+  // assignment reuses the slot's storage
+  nextFrame() = frame;
+}
+
+void BodyInterpolator::sample(double time) {
+  PROFILE_SCOPE("interpolate");
+  if (m_captured == 0) {
+    m_positions.clear();
+    return;
+  }
+  const BodyFrame &newest = getFrame(0);
+  m_positions.resize(newest.positions.size());
+
+  if (time >= newest.time || m_captured == 1) {
+    float ahead = (float)std::clamp(time - newest.time, 0.0,
+                                    (double)m_maxExtrapolation);
+    for (size_t i = 0; i < m_positions.size(); i++) {
+      m_positions[i] = newest.positions[i] + newest.velocities[i] * ahead;
+    }
+    return;
+  }
+
+  // the newest pair of frames that starts at or before time, or the oldest
+  unsigned int age = 1;
+  while (age + 1 < m_captured && getFrame(age).time > time) {
+    age++;
+  }
+  const BodyFrame &from = getFrame(age);
+  const BodyFrame &to = getFrame(age - 1);
+  double span = to.time - from.time;
+  float alpha =
+      span > 0.0 ? (float)std::clamp((time - from.time) / span, 0.0, 1.0)
+                 : 1.0f;
+  // Bodies added since the older frame appear at their first position.
+  // Removals move other bodies to new indices, those show their newest
+  // position until both frames agree again.
+  const size_t blended = std::min(
+      {from.positions.size(), to.positions.size(), m_positions.size()});
+  for (size_t i = 0; i < blended; i++) {
+    const BodyHandle body = newest.handles[i];
+    if (from.handles[i] == body && to.handles[i] == body) {
+      m_positions[i] = glm::mix(from.positions[i], to.positions[i], alpha);
+    } else {
+      m_positions[i] = newest.positions[i];
+    }
+  }
+  for (size_t i = blended; i < m_positions.size(); i++) {
+    m_positions[i] = newest.positions[i];
+  }
+}
+
+void BodyInterpolator::setMaxExtrapolation(float seconds) {
+  m_maxExtrapolation = seconds;
+}
+
+void BodyInterpolator::clear() { m_captured = 0; }
+
+unsigned int BodyInterpolator::getBodyCount() const {
+  return m_positions.size();
+}
+
+glm::vec3 BodyInterpolator::getPosition(unsigned int body) const {
+  return m_positions[body];
+}
+
+float BodyInterpolator::getRadius(unsigned int body) const {
+  return getFrame(0).radii[body];
+}
+
+BodyFrame &BodyInterpolator::nextFrame() {
+  m_newest = (m_newest + 1) % m_frames.size();
+  m_captured = std::min(m_captured + 1, (unsigned int)m_frames.size());
+  return m_frames[m_newest];
+}
+
+const BodyFrame &BodyInterpolator::getFrame(unsigned int age) const {
+  return m_frames[(m_newest + m_frames.size() - age) % m_frames.size()];
+}
@@ -0,0 +1,534 @@
+#include "physics/PhysicsWorld.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "jobs/JobSystem.hpp"
+#include "physics/StateHash.hpp"
+#include "profiling/Profiler.hpp"
+
+PhysicsWorld::PhysicsWorld(const glm::vec3 borderMin, const glm::vec3 borderMax)
+    : m_borderMin(borderMin), m_borderMax(borderMax),
+      m_broadphase(borderMin, borderMax), m_pairs(&m_stepArena),
+      m_contacts(&m_stepArena) {
+  reserve(PHYSICS_DEFAULT_BODY_CAPACITY);
+}
+
+BodyHandle PhysicsWorld::addBody(const glm::vec3 position,
+                                 const glm::vec3 velocity, float radius) {
+  BodyHandle handle;
+  addBodies(&position, &velocity, &radius, 1, &handle);
+  return handle;
+}
+
+unsigned int PhysicsWorld::addBodies(const glm::vec3 *positions,
+                                     const glm::vec3 *velocities,
+                                     const float *radii, unsigned int count,
+                                     BodyHandle *handles) {
+  const unsigned int room = getCapacity() - getBodyCount();
+  if (count > room) {
+    std::cout << "ERROR::PHYSICS::BODY_POOL_FULL" << std::endl;
+    count = room;
+  }
+  for (unsigned int i = 0; i < count; i++) {
+    // reuse freed slots first, so slots stay dense
+    uint32_t slot = m_freeSlot;
+    if (slot != UINT32_MAX) {
+      m_freeSlot = m_slotBodies[slot];
+    } else {
+      slot = m_slotCount++;
+    }
+    m_slotBodies[slot] = m_positions.size();
+    m_bodySlots.push_back(slot);
+    m_positions.push_back(positions[i]);
+    m_velocities.push_back(velocities[i]);
+    m_radii.push_back(radii[i]);
+    m_bounds.emplace_back();
+    setBodyBounds(m_positions.size() - 1);
+    m_maxRadius = std::max(m_maxRadius, radii[i]);
+    if (handles) {
+      handles[i] = {slot, m_slotGenerations[slot]};
+    }
+  }
+  return count;
+}
+
+bool PhysicsWorld::removeBody(BodyHandle handle) {
+  if (!isAlive(handle)) {
+    return false;
+  }
+  // the last body fills the hole, so the arrays stay dense
+  const uint32_t body = m_slotBodies[handle.slot];
+  const uint32_t last = m_positions.size() - 1;
+  m_positions[body] = m_positions[last];
+  m_velocities[body] = m_velocities[last];
+  m_radii[body] = m_radii[last];
+  m_bounds[body] = m_bounds[last];
+  m_bodySlots[body] = m_bodySlots[last];
+  m_slotBodies[m_bodySlots[body]] = body;
+  m_positions.pop_back();
+  m_velocities.pop_back();
+  m_radii.pop_back();
+  m_bounds.pop_back();
+  m_bodySlots.pop_back();
+
+  m_slotGenerations[handle.slot]++;
+  m_slotBodies[handle.slot] = m_freeSlot;
+  m_freeSlot = handle.slot;
+  // both lists hold indices from before the move
+  m_pairs.clear();
+  m_contacts.clear();
+  return true;
+}
+
+bool PhysicsWorld::isAlive(BodyHandle handle) const {
+  // a freed slot's generation is already past every handle given out for it
+  return handle.slot < m_slotCount &&
+         m_slotGenerations[handle.slot] == handle.generation;
+}
+
+unsigned int PhysicsWorld::getBodyIndex(BodyHandle handle) const {
+  return m_slotBodies[handle.slot];
+}
+
+BodyHandle PhysicsWorld::getBodyHandle(unsigned int body) const {
+  const uint32_t slot = m_bodySlots[body];
+  return {slot, m_slotGenerations[slot]};
+}
+
+void PhysicsWorld::reserve(unsigned int bodyCount) {
+  if (bodyCount <= getCapacity()) {
+    return;
+  }
+  m_positions.reserve(bodyCount);
+  m_velocities.reserve(bodyCount);
+  m_radii.reserve(bodyCount);
+  m_bounds.reserve(bodyCount);
+  m_bodySlots.reserve(bodyCount);
+  m_slotBodies.resize(bodyCount);
+  m_slotGenerations.resize(bodyCount, 0);
+  m_broadphase.reserve(bodyCount);
+}
+
+unsigned int PhysicsWorld::getCapacity() const { return m_slotBodies.size(); }
+
+unsigned int PhysicsWorld::getBodyCount() const { return m_positions.size(); }
+
+unsigned int PhysicsWorld::getSlotCount() const { return m_slotCount; }
+
+glm::vec3 PhysicsWorld::getPosition(unsigned int body) const {
+  return m_positions[body];
+}
+
+void PhysicsWorld::setPosition(unsigned int body, const glm::vec3 position) {
+  m_positions[body] = position;
+  setBodyBounds(body);
+}
+
+glm::vec3 PhysicsWorld::getVelocity(unsigned int body) const {
+  return m_velocities[body];
+}
+
+void PhysicsWorld::setVelocity(unsigned int body, const glm::vec3 velocity) {
+  m_velocities[body] = velocity;
+}
+
+float PhysicsWorld::getRadius(unsigned int body) const { return m_radii[body]; }
+
+glm::vec3 PhysicsWorld::getBorderMin() const { return m_borderMin; }
+
+glm::vec3 PhysicsWorld::getBorderMax() const { return m_borderMax; }
+
+const std::vector<Aabb> &PhysicsWorld::getBodyBounds() const {
+  return m_bounds;
+}
+
+const Aabb &PhysicsWorld::getBounds() const { return m_worldBounds; }
+
+void PhysicsWorld::step(float deltaTime) {
+  PROFILE_SCOPE("physics.step");
+  if (m_deterministic) {
+    deltaTime = m_fixedTimestep;
+  }
+  beginStep();
+  integrate(deltaTime);
+  reflectWalls();
+  updateBounds();
+  updateBroadphase();
+  findPairs();
+  narrowphase();
+  resolveContacts();
+  m_tick++;
+  if (m_deterministic) {
+    PROFILE_SCOPE("physics.hash");
+    m_stateHash = computeStateHash();
+  }
+}
+
+unsigned int PhysicsWorld::advance(float frameTime) {
+  if (!m_deterministic) {
+    step(frameTime);
+    return 1;
+  }
+  // the accumulator only decides how many steps run, never their length
+  m_accumulator = std::min(m_accumulator + frameTime,
+                           (double)m_fixedTimestep * MAX_STEPS_PER_ADVANCE);
+  unsigned int steps = 0;
+  while (m_accumulator >= m_fixedTimestep) {
+    step(m_fixedTimestep);
+    m_accumulator -= m_fixedTimestep;
+    steps++;
+  }
+  return steps;
+}
+
+void PhysicsWorld::setDeterministic(bool deterministic) {
+  m_deterministic = deterministic;
+  m_accumulator = 0.0;
+}
+
+bool PhysicsWorld::isDeterministic() const { return m_deterministic; }
+
+void PhysicsWorld::setFixedTimestep(float timestep) {
+  m_fixedTimestep = timestep;
+}
+
+float PhysicsWorld::getFixedTimestep() const { return m_fixedTimestep; }
+
+float PhysicsWorld::getInterpolationAlpha() const {
+  return m_deterministic ? (float)(m_accumulator / m_fixedTimestep) : 1.0f;
+}
+
+uint64_t PhysicsWorld::getTick() const { return m_tick; }
+
+uint64_t PhysicsWorld::computeStateHash() const {
+  // columns are folded in a fixed order, each column in fixed size chunks
+  uint64_t h = stateHashMix(m_tick);
+  h = stateHashColumn(m_positions.data(),
+                      m_positions.size() * sizeof(glm::vec3), h);
+  h = stateHashColumn(m_velocities.data(),
+                      m_velocities.size() * sizeof(glm::vec3), h);
+  h = stateHashColumn(m_radii.data(), m_radii.size() * sizeof(float), h);
+  h = stateHashColumn(m_bodySlots.data(),
+                      m_bodySlots.size() * sizeof(uint32_t), h);
+  return h;
+}
+
+uint64_t PhysicsWorld::getStateHash() const { return m_stateHash; }
+
+namespace {
+template <typename Column>
+unsigned char *copyColumnOut(unsigned char *out, const Column &column) {
+  using T = typename Column::value_type;
+  // an empty pmr vector may have a null data()
+  if (!column.empty()) {
+    std::memcpy(out, column.data(), column.size() * sizeof(T));
+  }
+  return out + column.size() * sizeof(T);
+}
+
+uint32_t loadSlot(const unsigned char *table, uint32_t i) {
+  uint32_t value;
+  std::memcpy(&value, table + i * sizeof(uint32_t), sizeof(uint32_t));
+  return value;
+}
+
+// Every body's slot must point back at the body, and the free list must
+// visit each remaining slot once, so removeBody and addBodies stay in bounds.
+bool validSlotTables(const unsigned char *bodySlots,
+                     const unsigned char *slotBodies, uint32_t bodyCount,
+                     uint32_t slotCount, uint32_t freeSlot) {
+  for (uint32_t body = 0; body < bodyCount; body++) {
+    const uint32_t slot = loadSlot(bodySlots, body);
+    if (slot >= slotCount || loadSlot(slotBodies, slot) != body) {
+      return false;
+    }
+  }
+  // a cycle or a live slot on the list leaves it too long or too short
+  uint32_t slot = freeSlot;
+  for (uint32_t i = bodyCount; i < slotCount; i++) {
+    if (slot >= slotCount) {
+      return false;
+    }
+    const uint32_t next = loadSlot(slotBodies, slot);
+    if (next < bodyCount && loadSlot(bodySlots, next) == slot) {
+      return false;
+    }
+    slot = next;
+  }
+  return slot == UINT32_MAX;
+}
+
+bool validContacts(const unsigned char *contacts, uint32_t contactCount,
+                   uint32_t bodyCount) {
+  for (uint32_t i = 0; i < contactCount; i++) {
+    Contact contact;
+    std::memcpy(&contact, contacts + i * sizeof(Contact), sizeof(Contact));
+    if (contact.a >= bodyCount || contact.b >= bodyCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Column>
+const unsigned char *copyColumnIn(const unsigned char *in, Column &column,
+                                  size_t count) {
+  using T = typename Column::value_type;
+  column.resize(count);
+  if (count > 0) {
+    std::memcpy(column.data(), in, count * sizeof(T));
+  }
+  return in + count * sizeof(T);
+}
+} // namespace
+
+void PhysicsWorld::saveSnapshot(WorldSnapshot &snapshot) const {
+  PROFILE_SCOPE("physics.snapshot.save");
+  const size_t bodyCount = m_positions.size();
+  snapshot.data.resize(sizeof(WorldSnapshotHeader) +
+                       bodyCount * WORLD_SNAPSHOT_BODY_BYTES +
+                       m_slotCount * WORLD_SNAPSHOT_SLOT_BYTES +
+                       m_contacts.size() * sizeof(Contact));
+
+  WorldSnapshotHeader header;
+  header.magic = WORLD_SNAPSHOT_MAGIC;
+  header.version = WORLD_SNAPSHOT_VERSION;
+  header.tick = m_tick;
+  header.stateHash = m_stateHash;
+  header.bodyCount = bodyCount;
+  header.contactCount = m_contacts.size();
+  header.maxRadius = m_maxRadius;
+  header.slotCount = m_slotCount;
+  header.freeSlot = m_freeSlot;
+  header.reserved = 0;
+
+  unsigned char *out = snapshot.data.data();
+  std::memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  out = copyColumnOut(out, m_positions);
+  out = copyColumnOut(out, m_velocities);
+  out = copyColumnOut(out, m_radii);
+  out = copyColumnOut(out, m_bodySlots);
+  // only the slots handed out so far, the rest are all fresh
+  std::memcpy(out, m_slotBodies.data(), m_slotCount * sizeof(uint32_t));
+  out += m_slotCount * sizeof(uint32_t);
+  std::memcpy(out, m_slotGenerations.data(), m_slotCount * sizeof(uint32_t));
+  out += m_slotCount * sizeof(uint32_t);
+  copyColumnOut(out, m_contacts);
+}
+
+bool PhysicsWorld::restoreSnapshot(const WorldSnapshot &snapshot) {
+  PROFILE_SCOPE("physics.snapshot.restore");
+  if (!snapshot.isValid()) {
+    std::cout << "ERROR::SNAPSHOT::INVALID_HEADER" << std::endl;
+    return false;
+  }
+  const WorldSnapshotHeader &header = snapshot.getHeader();
+  const size_t expectedSize =
+      sizeof(WorldSnapshotHeader) +
+      (size_t)header.bodyCount * WORLD_SNAPSHOT_BODY_BYTES +
+      (size_t)header.slotCount * WORLD_SNAPSHOT_SLOT_BYTES +
+      (size_t)header.contactCount * sizeof(Contact);
+  if (snapshot.data.size() != expectedSize ||
+      header.slotCount < header.bodyCount) {
+    std::cout << "ERROR::SNAPSHOT::SIZE_MISMATCH" << std::endl;
+    return false;
+  }
+  const unsigned char *in = snapshot.data.data() + sizeof(WorldSnapshotHeader);
+  // the columns before the slot column are positions, velocities and radii
+  const unsigned char *bodySlots =
+      in + (size_t)header.bodyCount * (2 * sizeof(glm::vec3) + sizeof(float));
+  const unsigned char *slotBodies =
+      bodySlots + (size_t)header.bodyCount * sizeof(uint32_t);
+  const unsigned char *contacts =
+      slotBodies + (size_t)header.slotCount * WORLD_SNAPSHOT_SLOT_BYTES;
+  if (!validSlotTables(bodySlots, slotBodies, header.bodyCount,
+                       header.slotCount, header.freeSlot)) {
+    std::cout << "ERROR::SNAPSHOT::INVALID_SLOT_TABLES" << std::endl;
+    return false;
+  }
+  if (!validContacts(contacts, header.contactCount, header.bodyCount)) {
+    std::cout << "ERROR::SNAPSHOT::INVALID_CONTACTS" << std::endl;
+    return false;
+  }
+  reserve(header.slotCount);
+
+  in = copyColumnIn(in, m_positions, header.bodyCount);
+  in = copyColumnIn(in, m_velocities, header.bodyCount);
+  in = copyColumnIn(in, m_radii, header.bodyCount);
+  in = copyColumnIn(in, m_bodySlots, header.bodyCount);
+  // slots first used after the snapshot become fresh again, so handing them
+  // out a second time repeats the same generations
+  for (uint32_t slot = header.slotCount; slot < m_slotCount; slot++) {
+    m_slotGenerations[slot] = 0;
+  }
+  std::memcpy(m_slotBodies.data(), in, header.slotCount * sizeof(uint32_t));
+  in += header.slotCount * sizeof(uint32_t);
+  std::memcpy(m_slotGenerations.data(), in,
+              header.slotCount * sizeof(uint32_t));
+  in += header.slotCount * sizeof(uint32_t);
+  m_slotCount = header.slotCount;
+  m_freeSlot = header.freeSlot;
+  copyColumnIn(in, m_contacts, header.contactCount);
+  m_tick = header.tick;
+  m_stateHash = header.stateHash;
+  m_maxRadius = header.maxRadius;
+  m_pairs.clear();
+  updateBounds();
+  return true;
+}
+
+void PhysicsWorld::integrate(float deltaTime) {
+  PROFILE_SCOPE("physics.integrate");
+  JobSystem::getDefault().parallelFor(
+      m_positions.size(), PHYSICS_BODIES_PER_JOB,
+      [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+          m_positions[i] += deltaTime * m_velocities[i];
+        }
+      });
+}
+
+void PhysicsWorld::reflectWalls() {
+  PROFILE_SCOPE("physics.walls");
+  // the body center is kept inside the arena, velocity flips on the axis that
+  // crossed a wall
+  JobSystem::getDefault().parallelFor(
+      m_positions.size(), PHYSICS_BODIES_PER_JOB,
+      [this](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+          glm::vec3 &position = m_positions[i];
+          glm::vec3 &velocity = m_velocities[i];
+          for (int axis = 0; axis < 3; axis++) {
+            if (position[axis] <= m_borderMin[axis]) {
+              velocity[axis] = -velocity[axis];
+              position[axis] = m_borderMin[axis];
+            } else if (position[axis] >= m_borderMax[axis]) {
+              velocity[axis] = -velocity[axis];
+              position[axis] = m_borderMax[axis];
+            }
+          }
+        }
+      });
+}
+
+void PhysicsWorld::updateBounds() {
+  PROFILE_SCOPE("physics.bounds");
+  const unsigned int bodyCount = m_positions.size();
+  m_bounds.resize(bodyCount);
+  Aabb worldBounds;
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    const glm::vec3 extent(m_radii[i]);
+    m_bounds[i] = Aabb(m_positions[i] - extent, m_positions[i] + extent);
+    worldBounds.expand(m_bounds[i]);
+  }
+  m_worldBounds = worldBounds;
+}
+
+void PhysicsWorld::updateBroadphase() {
+  PROFILE_SCOPE("physics.broadphase");
+  m_broadphase.build(m_bounds, m_maxRadius);
+}
+
+void PhysicsWorld::findPairs() {
+  PROFILE_SCOPE("physics.pairs");
+  m_broadphase.findPairs(m_bounds, m_pairs);
+}
+
+void PhysicsWorld::narrowphase() {
+  PROFILE_SCOPE("physics.narrowphase");
+  m_contacts.clear();
+  const unsigned int pairCount = m_pairs.size();
+  const unsigned int blockCount =
+      (pairCount + PHYSICS_PAIRS_PER_JOB - 1) / PHYSICS_PAIRS_PER_JOB;
+  if (m_blockContacts.size() < blockCount) {
+    m_blockContacts.resize(blockCount);
+  }
+  JobSystem::getDefault().parallelFor(
+      blockCount, 1, [&](unsigned int beginBlock, unsigned int endBlock) {
+        for (unsigned int block = beginBlock; block < endBlock; block++) {
+          std::vector<Contact> &contacts = m_blockContacts[block];
+          contacts.clear();
+          const unsigned int end =
+              std::min(pairCount, (block + 1) * PHYSICS_PAIRS_PER_JOB);
+          for (unsigned int p = block * PHYSICS_PAIRS_PER_JOB; p < end; p++) {
+            const BodyPair &pair = m_pairs[p];
+            glm::vec3 d = m_positions[pair.b] - m_positions[pair.a];
+            float radiusSum = m_radii[pair.a] + m_radii[pair.b];
+            float distanceSquared = glm::dot(d, d);
+            if (distanceSquared >= radiusSum * radiusSum) {
+              continue;
+            }
+            float distance = std::sqrt(distanceSquared);
+            // coincident centers get an arbitrary but fixed normal
+            glm::vec3 normal =
+                distance > 1e-6f ? d / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+            contacts.push_back({pair.a, pair.b, normal, radiusSum - distance});
+          }
+        }
+      });
+  for (unsigned int block = 0; block < blockCount; block++) {
+    m_contacts.insert(m_contacts.end(), m_blockContacts[block].begin(),
+                      m_blockContacts[block].end());
+  }
+}
+
+void PhysicsWorld::resolveContacts() {
+  PROFILE_SCOPE("physics.resolve");
+  for (const Contact &contact : m_contacts) {
+    glm::vec3 &velocityA = m_velocities[contact.a];
+    glm::vec3 &velocityB = m_velocities[contact.b];
+    // equal masses, so an elastic collision swaps the normal components
+    float approach = glm::dot(velocityB - velocityA, contact.normal);
+    if (approach < 0.0f) {
+      velocityA += approach * contact.normal;
+      velocityB -= approach * contact.normal;
+    }
+    glm::vec3 correction = 0.5f * contact.penetration * contact.normal;
+    m_positions[contact.a] -= correction;
+    m_positions[contact.b] += correction;
+  }
+  // the boxes grow to cover the pushed bodies instead of being refitted, a
+  // body in several contacts only needs its final position covered
+  for (const Contact &contact : m_contacts) {
+    for (unsigned int body : {contact.a, contact.b}) {
+      const glm::vec3 extent(m_radii[body]);
+      m_bounds[body].expand(Aabb(m_positions[body] - extent,
+                                 m_positions[body] + extent));
+      m_worldBounds.expand(m_bounds[body]);
+    }
+  }
+}
+
+const UniformGrid &PhysicsWorld::getBroadphase() const { return m_broadphase; }
+
+const FrameVector<BodyPair> &PhysicsWorld::getPairs() const { return m_pairs; }
+
+const FrameVector<Contact> &PhysicsWorld::getContacts() const {
+  return m_contacts;
+}
+
+const FrameArena &PhysicsWorld::getStepArena() const { return m_stepArena; }
+
+void PhysicsWorld::setBodyBounds(unsigned int body) {
+  const glm::vec3 extent(m_radii[body]);
+  m_bounds[body] =
+      Aabb(m_positions[body] - extent, m_positions[body] + extent);
+  m_worldBounds.expand(m_bounds[body]);
+}
+
+void PhysicsWorld::beginStep() {
+  // last step's lists are dropped without a destructor pass, their storage
+  // goes away with the reset
+  const size_t pairCount = m_pairs.size();
+  const size_t contactCount = m_contacts.size();
+  m_stepArena.reset();
+  m_pairs = FrameVector<BodyPair>(&m_stepArena);
+  m_contacts = FrameVector<Contact>(&m_stepArena);
+  // sized from last step so a steady scene never reallocates within a step
+  m_pairs.reserve(pairCount + pairCount / 4);
+  m_contacts.reserve(contactCount + contactCount / 4);
+}
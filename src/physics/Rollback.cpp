@@ -0,0 +1,124 @@
+#include "physics/Rollback.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "profiling/Profiler.hpp"
+
+namespace {
+const uint64_t EMPTY_SLOT = UINT64_MAX;
+
+bool inputBefore(const WorldInput &input, uint64_t tick) {
+  return input.tick < tick;
+}
+
+bool tickBefore(uint64_t tick, const WorldInput &input) {
+  return tick < input.tick;
+}
+} // namespace
+
+Rollback::Rollback(PhysicsWorld &world, unsigned int historyTicks)
+    : m_world(world), m_history(std::max(historyTicks, 1u)),
+      m_historyTicks(std::max(historyTicks, 1u), EMPTY_SLOT) {}
+
+void Rollback::step() {
+  if (needsResimulation()) {
+    resimulate();
+  }
+  stepOnce();
+  pruneInputs();
+}
+
+bool Rollback::addInput(const WorldInput &input) {
+  if (input.tick < getOldestTick()) {
+    std::cout << "ERROR::ROLLBACK::INPUT_OUTSIDE_HISTORY" << std::endl;
+    return false;
+  }
+  auto position = std::upper_bound(m_inputs.begin(), m_inputs.end(),
+                                   input.tick, tickBefore);
+  m_inputs.insert(position, input);
+  if (input.tick < m_world.getTick()) {
+    m_dirtyTick = std::min(m_dirtyTick, input.tick);
+  }
+  return true;
+}
+
+unsigned int Rollback::resimulate() {
+  if (!needsResimulation()) {
+    return 0;
+  }
+  PROFILE_SCOPE("physics.rollback");
+  const uint64_t presentTick = m_world.getTick();
+  const uint64_t dirtyTick = m_dirtyTick;
+  m_dirtyTick = EMPTY_SLOT;
+  if (!rollbackTo(dirtyTick)) {
+    return 0;
+  }
+  resimulateTo(presentTick);
+  return presentTick - dirtyTick;
+}
+
+bool Rollback::needsResimulation() const { return m_dirtyTick != EMPTY_SLOT; }
+
+bool Rollback::rollbackTo(uint64_t tick) {
+  const size_t slot = tick % m_history.size();
+  if (m_historyTicks[slot] != tick) {
+    std::cout << "ERROR::ROLLBACK::TICK_NOT_IN_HISTORY" << std::endl;
+    return false;
+  }
+  return m_world.restoreSnapshot(m_history[slot]);
+}
+
+void Rollback::resimulateTo(uint64_t tick) {
+  while (m_world.getTick() < tick) {
+    stepOnce();
+  }
+}
+
+uint64_t Rollback::getOldestTick() const {
+  uint64_t oldest = m_world.getTick();
+  for (uint64_t tick : m_historyTicks) {
+    if (tick != EMPTY_SLOT) {
+      oldest = std::min(oldest, tick);
+    }
+  }
+  return oldest;
+}
+
+unsigned int Rollback::getHistoryTicks() const { return m_history.size(); }
+
+void Rollback::stepOnce() {
+  const uint64_t tick = m_world.getTick();
+  const size_t slot = tick % m_history.size();
+  m_world.saveSnapshot(m_history[slot]);
+  m_historyTicks[slot] = tick;
+  applyInputs(tick);
+  m_world.step(m_world.getFixedTimestep());
+}
+
+void Rollback::applyInputs(uint64_t tick) {
+  auto begin =
+      std::lower_bound(m_inputs.begin(), m_inputs.end(), tick, inputBefore);
+  for (auto it = begin; it != m_inputs.end() && it->tick == tick; ++it) {
+    switch (it->type) {
+    case WorldInputType::SetVelocity:
+      if (m_world.isAlive(it->body)) {
+        m_world.setVelocity(m_world.getBodyIndex(it->body), it->velocity);
+      }
+      break;
+    case WorldInputType::Spawn:
+      m_world.addBody(it->position, it->velocity, it->radius);
+      break;
+    case WorldInputType::Despawn:
+      m_world.removeBody(it->body);
+      break;
+    }
+  }
+}
+
+void Rollback::pruneInputs() {
+  // inputs before the oldest saved tick can never be replayed again
+  auto end = std::lower_bound(m_inputs.begin(), m_inputs.end(),
+                              getOldestTick(), inputBefore);
+  m_inputs.erase(m_inputs.begin(), end);
+}
@@ -0,0 +1,99 @@
+#include "physics/SimulationThread.hpp"
+
+#include "profiling/Profiler.hpp"
+
+SimulationThread::SimulationThread(PhysicsWorld &world) : m_world(world) {}
+
+SimulationThread::~SimulationThread() { stop(); }
+
+void SimulationThread::start() {
+  if (m_running) {
+    return;
+  }
+  m_startTime = m_world.getTick() * (double)m_world.getFixedTimestep();
+  m_startClock = std::chrono::steady_clock::now();
+  m_droppedNs = 0;
+  // the first frame is there before the thread takes a step
+  m_frames.getWriteBuffer().capture(m_world, m_startTime);
+  m_frames.publish();
+  m_running = true;
+  m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+  if (!m_running) {
+    return;
+  }
+  m_running = false;
+  m_thread.join();
+  applyCommands();
+}
+
+bool SimulationThread::isRunning() const { return m_running; }
+
+void SimulationThread::addBody(const glm::vec3 position,
+                               const glm::vec3 velocity, float radius) {
+  if (!m_running) {
+    m_world.addBody(position, velocity, radius);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_commandMutex);
+  m_commands.push_back({position, velocity, radius});
+}
+
+bool SimulationThread::acquireFrame() { return m_frames.acquire(); }
+
+const BodyFrame &SimulationThread::getFrame() const {
+  return m_frames.getReadBuffer();
+}
+
+double SimulationThread::getTime() const {
+  auto elapsed = std::chrono::steady_clock::now() - m_startClock -
+                 std::chrono::nanoseconds(m_droppedNs.load());
+  return m_startTime + std::chrono::duration<double>(elapsed).count();
+}
+
+void SimulationThread::run() {
+  Profiler::setThreadName("simulation");
+  using Clock = std::chrono::steady_clock;
+  const double timestep = m_world.getFixedTimestep();
+  const auto stepDuration = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(timestep));
+  auto nextStep = m_startClock + stepDuration;
+  uint64_t steps = 0;
+
+  while (m_running) {
+    std::this_thread::sleep_until(nextStep);
+    // catch up on missed steps, but drop time beyond the usual limit rather
+    // than spiral
+    unsigned int catchUp = 0;
+    while (Clock::now() >= nextStep && catchUp < MAX_STEPS_PER_ADVANCE) {
+      applyCommands();
+      m_world.step((float)timestep);
+      steps++;
+      BodyFrame &frame = m_frames.getWriteBuffer();
+      frame.capture(m_world, m_startTime + steps * timestep);
+      m_frames.publish();
+      nextStep += stepDuration;
+      catchUp++;
+    }
+    if (catchUp == MAX_STEPS_PER_ADVANCE && Clock::now() >= nextStep) {
+      // rebase the schedule, simulation time now lags the wall clock
+      auto behind = Clock::now() - nextStep;
+      nextStep += behind;
+      m_droppedNs +=
+          std::chrono::duration_cast<std::chrono::nanoseconds>(behind).count();
+    }
+  }
+}
+
+void SimulationThread::applyCommands() {
+  {
+    std::lock_guard<std::mutex> lock(m_commandMutex);
+    m_pendingCommands.swap(m_commands);
+  }
+  for (const SpawnCommand &command : m_pendingCommands) {
+    m_world.addBody(command.position, command.velocity, command.radius);
+  }
+  m_pendingCommands.clear();
+}
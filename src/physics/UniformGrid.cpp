@@ -0,0 +1,190 @@
+#include "physics/UniformGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "jobs/JobSystem.hpp"
+
+UniformGrid::UniformGrid()
+    : m_boundsMin(0.0f), m_boundsMax(0.0f), m_cellSize(1.0f),
+      m_inverseCellSize(1.0f), m_dims(1) {}
+
+UniformGrid::UniformGrid(const glm::vec3 boundsMin, const glm::vec3 boundsMax)
+    : m_boundsMin(boundsMin), m_boundsMax(boundsMax), m_cellSize(1.0f),
+      m_inverseCellSize(1.0f), m_dims(1) {}
+
+void UniformGrid::setBounds(const glm::vec3 boundsMin,
+                            const glm::vec3 boundsMax) {
+  m_boundsMin = boundsMin;
+  m_boundsMax = boundsMax;
+}
+
+void UniformGrid::build(const std::vector<Aabb> &bounds, float maxRadius) {
+  const unsigned int bodyCount = bounds.size();
+  m_cellSize = cellSizeFor(bodyCount, maxRadius);
+  m_inverseCellSize = 1.0f / m_cellSize;
+  m_dims = dimensionsFor(m_cellSize);
+
+  const unsigned int cellCount = m_dims.x * m_dims.y * m_dims.z;
+  m_cellStart.assign(cellCount + 1, 0);
+  m_cellBodies.resize(bodyCount);
+  m_bodyCell.resize(bodyCount);
+
+  JobSystem::getDefault().parallelFor(
+      bodyCount, UNIFORM_GRID_BODIES_PER_JOB,
+      [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+          m_bodyCell[i] = cellIndex(cellCoords(bounds[i].min));
+        }
+      });
+  // counting sort by cell, bodies stay in id order inside a cell
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    m_cellStart[m_bodyCell[i]]++;
+  }
+  // inclusive sums leave m_cellStart[c] at the end of c, filling backwards
+  // moves it down to the start
+  for (unsigned int c = 1; c < cellCount; c++) {
+    m_cellStart[c] += m_cellStart[c - 1];
+  }
+  m_cellStart[cellCount] = bodyCount;
+  for (unsigned int i = bodyCount; i > 0; i--) {
+    m_cellBodies[--m_cellStart[m_bodyCell[i - 1]]] = i - 1;
+  }
+}
+
+void UniformGrid::reserve(unsigned int bodyCount) {
+  // smaller bodies mean smaller cells, so no radius needs the most cells
+  const glm::ivec3 dims = dimensionsFor(cellSizeFor(bodyCount, 0.0f));
+  m_cellStart.reserve(dims.x * dims.y * dims.z + 1);
+  m_cellBodies.reserve(bodyCount);
+  m_bodyCell.reserve(bodyCount);
+  m_layerPairs.reserve(dims.z);
+}
+
+void UniformGrid::queryBox(const glm::vec3 boxMin, const glm::vec3 boxMax,
+                           std::vector<unsigned int> &out) const {
+  if (m_bodyCell.empty()) {
+    return;
+  }
+  // a box overlapping the query has its min corner at most a cell below it
+  glm::ivec3 lo = cellCoords(boxMin - m_cellSize);
+  glm::ivec3 hi = cellCoords(boxMax);
+  for (int z = lo.z; z <= hi.z; z++) {
+    for (int y = lo.y; y <= hi.y; y++) {
+      for (int x = lo.x; x <= hi.x; x++) {
+        unsigned int cell = cellIndex(glm::ivec3(x, y, z));
+        out.insert(out.end(), m_cellBodies.begin() + m_cellStart[cell],
+                   m_cellBodies.begin() + m_cellStart[cell + 1]);
+      }
+    }
+  }
+}
+
+void UniformGrid::findPairs(const std::vector<Aabb> &bounds,
+                            std::pmr::vector<BodyPair> &out) {
+  out.clear();
+  if (m_bodyCell.empty()) {
+    return;
+  }
+  if (m_layerPairs.size() < (size_t)m_dims.z) {
+    m_layerPairs.resize(m_dims.z);
+  }
+  JobSystem::getDefault().parallelFor(
+      m_dims.z, UNIFORM_GRID_LAYERS_PER_JOB,
+      [&](unsigned int begin, unsigned int end) {
+        for (unsigned int z = begin; z < end; z++) {
+          findLayerPairs(bounds, z, m_layerPairs[z]);
+        }
+      });
+  for (int z = 0; z < m_dims.z; z++) {
+    out.insert(out.end(), m_layerPairs[z].begin(), m_layerPairs[z].end());
+  }
+}
+
+void UniformGrid::findLayerPairs(const std::vector<Aabb> &bounds, int z,
+                                 std::vector<BodyPair> &out) const {
+  // Half of the 26 neighbours, so every pair of cells is visited once: the
+  // next cell in this row, then the x - 1 .. x + 1 spans of four rows. Cells
+  // of a row are adjacent in m_cellBodies, so each span is a single range.
+  static const int forwardRows[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+  auto testRange = [&](unsigned int a, unsigned int begin, unsigned int end) {
+    const Aabb box = bounds[a];
+    for (unsigned int j = begin; j < end; j++) {
+      const unsigned int b = m_cellBodies[j];
+      if (box.overlaps(bounds[b])) {
+        out.push_back({std::min(a, b), std::max(a, b)});
+      }
+    }
+  };
+
+  out.clear();
+  const int lastX = m_dims.x - 1;
+  for (int y = 0; y < m_dims.y; y++) {
+    const unsigned int row = cellIndex(glm::ivec3(0, y, z));
+    int rowCount = 0;
+    unsigned int rows[4];
+    for (const int *offset : forwardRows) {
+      int ny = y + offset[0];
+      int nz = z + offset[1];
+      if (ny >= 0 && ny < m_dims.y && nz < m_dims.z) {
+        rows[rowCount++] = cellIndex(glm::ivec3(0, ny, nz));
+      }
+    }
+
+    for (int x = 0; x < m_dims.x; x++) {
+      const unsigned int cell = row + x;
+      const unsigned int begin = m_cellStart[cell];
+      const unsigned int end = m_cellStart[cell + 1];
+      if (begin == end) {
+        continue;
+      }
+      const unsigned int nextEnd = x < lastX ? m_cellStart[cell + 2] : end;
+      const unsigned int spanLo = x > 0 ? x - 1 : 0;
+      const unsigned int spanHi = x < lastX ? x + 2 : x + 1;
+      for (unsigned int i = begin; i < end; i++) {
+        const unsigned int a = m_cellBodies[i];
+        // rest of this cell and the next one are contiguous
+        testRange(a, i + 1, nextEnd);
+        for (int r = 0; r < rowCount; r++) {
+          testRange(a, m_cellStart[rows[r] + spanLo],
+                    m_cellStart[rows[r] + spanHi]);
+        }
+      }
+    }
+  }
+}
+
+float UniformGrid::getCellSize() const { return m_cellSize; }
+
+glm::ivec3 UniformGrid::getDimensions() const { return m_dims; }
+
+float UniformGrid::cellSizeFor(unsigned int bodyCount,
+                               float maxRadius) const {
+  // One box size is the smallest cell that still finds every pair in the
+  // neighbouring cells and tests the fewest candidates. Tiny bodies would
+  // make the cell pass dominate, so cells only shrink to a fixed count per
+  // body.
+  glm::vec3 extent = glm::max(m_boundsMax - m_boundsMin, glm::vec3(1e-3f));
+  float volume = extent.x * extent.y * extent.z;
+  float cellCount =
+      std::max(bodyCount, 1u) * (float)UNIFORM_GRID_CELLS_PER_BODY;
+  float minCellSize = std::cbrt(volume / cellCount);
+  return std::max(2.0f * maxRadius, minCellSize);
+}
+
+glm::ivec3 UniformGrid::dimensionsFor(float cellSize) const {
+  glm::vec3 extent = glm::max(m_boundsMax - m_boundsMin, glm::vec3(1e-3f));
+  return glm::max(glm::ivec3(glm::ceil(extent / cellSize)), glm::ivec3(1));
+}
+
+glm::ivec3 UniformGrid::cellCoords(const glm::vec3 position) const {
+  // clamped before the conversion, which then truncates like a floor and
+  // never sees a value out of int range
+  glm::vec3 cell = (position - m_boundsMin) * m_inverseCellSize;
+  return glm::ivec3(glm::clamp(cell, glm::vec3(0.0f), glm::vec3(m_dims - 1)));
+}
+
+unsigned int UniformGrid::cellIndex(const glm::ivec3 coords) const {
+  return (coords.z * m_dims.y + coords.y) * m_dims.x + coords.x;
+}
@@ -0,0 +1,165 @@
+#include "physics/WorldSnapshot.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+void writeVarint(std::vector<unsigned char> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((unsigned char)value);
+}
+
+bool readVarint(const std::vector<unsigned char> &in, size_t &offset,
+                uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (offset >= in.size()) {
+      return false;
+    }
+    unsigned char byte = in[offset++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// word of the snapshot at byte offset, bytes past its end read as zero
+uint64_t loadWord(const std::vector<unsigned char> &data, size_t offset) {
+  uint64_t word = 0;
+  if (offset + 8 <= data.size()) {
+    std::memcpy(&word, data.data() + offset, 8);
+  } else if (offset < data.size()) {
+    std::memcpy(&word, data.data() + offset, data.size() - offset);
+  }
+  return word;
+}
+
+unsigned char loadByte(const std::vector<unsigned char> &data,
+                       size_t offset) {
+  return offset < data.size() ? data[offset] : 0;
+}
+} // namespace
+
+bool WorldSnapshot::isValid() const {
+  if (data.size() < sizeof(WorldSnapshotHeader)) {
+    return false;
+  }
+  const WorldSnapshotHeader &header = getHeader();
+  return header.magic == WORLD_SNAPSHOT_MAGIC &&
+         header.version == WORLD_SNAPSHOT_VERSION;
+}
+
+const WorldSnapshotHeader &WorldSnapshot::getHeader() const {
+  return *reinterpret_cast<const WorldSnapshotHeader *>(data.data());
+}
+
+// Delta layout: varint size of the current snapshot, then tokens of
+// (varint zero words, varint literal words, literal words XOR previous)
+// covering size / 8 words, then the size % 8 tail bytes XOR previous.
+void SnapshotDelta::encode(const WorldSnapshot &previous,
+                           const WorldSnapshot &current,
+                           std::vector<unsigned char> &delta) {
+  const std::vector<unsigned char> &prev = previous.data;
+  const std::vector<unsigned char> &cur = current.data;
+  const size_t size = cur.size();
+  const size_t words = size / 8;
+
+  delta.clear();
+  writeVarint(delta, size);
+  size_t w = 0;
+  while (w < words) {
+    size_t zeroStart = w;
+    while (w < words && loadWord(cur, w * 8) == loadWord(prev, w * 8)) {
+      w++;
+    }
+    size_t literalStart = w;
+    while (w < words && loadWord(cur, w * 8) != loadWord(prev, w * 8)) {
+      w++;
+    }
+    writeVarint(delta, literalStart - zeroStart);
+    writeVarint(delta, w - literalStart);
+    for (size_t i = literalStart; i < w; i++) {
+      uint64_t x = loadWord(cur, i * 8) ^ loadWord(prev, i * 8);
+      unsigned char bytes[8];
+      std::memcpy(bytes, &x, 8);
+      delta.insert(delta.end(), bytes, bytes + 8);
+    }
+  }
+  for (size_t i = words * 8; i < size; i++) {
+    delta.push_back(cur[i] ^ loadByte(prev, i));
+  }
+}
+
+bool SnapshotDelta::decode(const WorldSnapshot &previous,
+                           const std::vector<unsigned char> &delta,
+                           WorldSnapshot &current) {
+  const std::vector<unsigned char> &prev = previous.data;
+  size_t offset = 0;
+  uint64_t size;
+  if (!readVarint(delta, offset, size) || size > WORLD_SNAPSHOT_MAX_BYTES) {
+    return false;
+  }
+  const size_t words = size / 8;
+  std::vector<unsigned char> &cur = current.data;
+  cur.resize(size);
+
+  size_t w = 0;
+  while (w < words) {
+    uint64_t zeroWords, literalWords;
+    if (!readVarint(delta, offset, zeroWords) ||
+        !readVarint(delta, offset, literalWords) ||
+        zeroWords > words - w || literalWords > words - w - zeroWords ||
+        literalWords > (delta.size() - offset) / 8) {
+      return false;
+    }
+    for (size_t end = w + zeroWords; w < end; w++) {
+      uint64_t word = loadWord(prev, w * 8);
+      std::memcpy(cur.data() + w * 8, &word, 8);
+    }
+    for (size_t end = w + literalWords; w < end; w++) {
+      uint64_t x;
+      std::memcpy(&x, delta.data() + offset, 8);
+      offset += 8;
+      uint64_t word = x ^ loadWord(prev, w * 8);
+      std::memcpy(cur.data() + w * 8, &word, 8);
+    }
+  }
+  if (offset + (size - words * 8) != delta.size()) {
+    return false;
+  }
+  for (size_t i = words * 8; i < size; i++) {
+    cur[i] = delta[offset++] ^ loadByte(prev, i);
+  }
+  return current.isValid();
+}
+
+bool writeSnapshotFile(const std::string &path, const WorldSnapshot &snapshot) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    std::cout << "ERROR::SNAPSHOT::FILE_NOT_WRITABLE: " << path << std::endl;
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(snapshot.data.data()),
+             snapshot.data.size());
+  return (bool)file;
+}
+
+bool readSnapshotFile(const std::string &path, WorldSnapshot &snapshot) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    std::cout << "ERROR::SNAPSHOT::FILE_NOT_SUCCESSFULLY_READ: " << path
+              << std::endl;
+    return false;
+  }
+  std::streamsize size = file.tellg();
+  file.seekg(0);
+  snapshot.data.resize(size);
+  file.read(reinterpret_cast<char *>(snapshot.data.data()), size);
+  return (bool)file && snapshot.isValid();
+}
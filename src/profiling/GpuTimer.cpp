@@ -0,0 +1,70 @@
+#include "profiling/GpuTimer.hpp"
+
+#include <glad/glad.h>
+
+#include "profiling/Profiler.hpp"
+
+GpuTimer::GpuTimer() {}
+
+GpuTimer::~GpuTimer() {
+  for (Pass &pass : m_passes) {
+    for (Slot &slot : pass.slots) {
+      glDeleteQueries(1, &slot.query);
+    }
+  }
+}
+
+unsigned int GpuTimer::addPass(const char *name) {
+  Pass pass;
+  pass.name = name;
+  for (Slot &slot : pass.slots) {
+    glGenQueries(1, &slot.query);
+  }
+  m_passes.push_back(pass);
+  return m_passes.size() - 1;
+}
+
+void GpuTimer::beginFrame() {
+  m_slot = (m_slot + 1) % GPU_TIMER_LATENCY;
+  // the slot about to be reused was issued GPU_TIMER_LATENCY frames ago, by
+  // now its result is almost always available
+  for (Pass &pass : m_passes) {
+    Slot &slot = pass.slots[m_slot];
+    if (!slot.pending) {
+      continue;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      // drop the sample rather than stall, the slot is overwritten below
+      slot.pending = false;
+      continue;
+    }
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed);
+    slot.pending = false;
+    pass.lastNs = elapsed;
+    Profiler::recordGpu(pass.name, slot.cpuStartNs, elapsed, slot.frame);
+  }
+}
+
+void GpuTimer::begin(unsigned int pass) {
+  Slot &slot = m_passes[pass].slots[m_slot];
+  slot.cpuStartNs = Profiler::nowNs();
+  slot.frame = Profiler::getFrame();
+  glBeginQuery(GL_TIME_ELAPSED, slot.query);
+  m_active = pass;
+}
+
+void GpuTimer::end() {
+  if (m_active < 0) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  m_passes[m_active].slots[m_slot].pending = true;
+  m_active = -1;
+}
+
+uint64_t GpuTimer::getLastNs(unsigned int pass) const {
+  return m_passes[pass].lastNs;
+}
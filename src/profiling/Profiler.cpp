@@ -0,0 +1,198 @@
+#include "profiling/Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace {
+const std::chrono::steady_clock::time_point epoch =
+    std::chrono::steady_clock::now();
+std::atomic<uint32_t> currentFrame{0};
+
+// registration happens once per thread, recording never touches the lock
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<ProfileRingBuffer>> buffers;
+
+const uint32_t GPU_THREAD_ID = 0;
+
+ProfileRingBuffer *registerBuffer(const std::string &threadName) {
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  uint32_t threadId = (uint32_t)buffers.size() + 1;
+  buffers.push_back(
+      std::make_unique<ProfileRingBuffer>(threadId, threadName));
+  return buffers.back().get();
+}
+
+thread_local ProfileRingBuffer *localBuffer = nullptr;
+
+void writeJsonString(std::ofstream &out, const char *str) {
+  out << '"';
+  for (const char *c = str; *c; c++) {
+    if (*c == '"' || *c == '\\')
+      out << '\\';
+    out << *c;
+  }
+  out << '"';
+}
+} // namespace
+
+ProfileRingBuffer::ProfileRingBuffer(uint32_t threadId, std::string threadName)
+    : m_threadId(threadId), m_threadName(std::move(threadName)) {}
+
+void ProfileRingBuffer::push(const ProfileEvent &event) {
+  uint64_t index = m_written.load(std::memory_order_relaxed);
+  Slot &slot = m_events[index % PROFILER_EVENTS_PER_THREAD];
+  m_claimed.store(index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(event.name, std::memory_order_relaxed);
+  slot.startNs.store(event.startNs, std::memory_order_relaxed);
+  slot.durationNs.store(event.durationNs, std::memory_order_relaxed);
+  slot.frame.store(event.frame, std::memory_order_relaxed);
+  m_written.store(index + 1, std::memory_order_release);
+}
+
+std::vector<ProfileEvent> ProfileRingBuffer::snapshot() const {
+  uint64_t written = m_written.load(std::memory_order_acquire);
+  uint64_t count = std::min<uint64_t>(written, PROFILER_EVENTS_PER_THREAD);
+  std::vector<ProfileEvent> events;
+  events.reserve(count);
+  for (uint64_t i = written - count; i < written; i++) {
+    const Slot &slot = m_events[i % PROFILER_EVENTS_PER_THREAD];
+    events.push_back({slot.name.load(std::memory_order_relaxed),
+                      slot.startNs.load(std::memory_order_relaxed),
+                      slot.durationNs.load(std::memory_order_relaxed),
+                      slot.frame.load(std::memory_order_relaxed)});
+  }
+  // any slot the owner started to overwrite while we copied may be torn,
+  // those are the oldest ones, so drop a prefix
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t claimed = m_claimed.load(std::memory_order_relaxed);
+  uint64_t firstIntact = claimed > PROFILER_EVENTS_PER_THREAD
+                             ? claimed - PROFILER_EVENTS_PER_THREAD
+                             : 0;
+  uint64_t first = written - count;
+  if (firstIntact > first) {
+    events.erase(events.begin(),
+                 events.begin() + std::min(firstIntact - first, count));
+  }
+  return events;
+}
+
+uint32_t ProfileRingBuffer::getThreadId() const { return m_threadId; }
+
+const std::string &ProfileRingBuffer::getThreadName() const {
+  return m_threadName;
+}
+
+uint64_t Profiler::nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+void Profiler::beginFrame() {
+  currentFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t Profiler::getFrame() {
+  return currentFrame.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string &name) {
+  if (localBuffer == nullptr) {
+    localBuffer = registerBuffer(name);
+  }
+}
+
+void Profiler::record(const char *name, uint64_t startNs,
+                      uint64_t durationNs) {
+  threadBuffer().push({name, startNs, durationNs, getFrame()});
+}
+
+void Profiler::recordGpu(const char *name, uint64_t startNs,
+                         uint64_t durationNs, uint32_t frame) {
+  gpuBuffer().push({name, startNs, durationNs, frame});
+}
+
+ProfileRingBuffer &Profiler::threadBuffer() {
+  if (localBuffer == nullptr) {
+    localBuffer = registerBuffer("thread");
+  }
+  return *localBuffer;
+}
+
+ProfileRingBuffer &Profiler::gpuBuffer() {
+  static ProfileRingBuffer *gpu = [] {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffers.push_back(
+        std::make_unique<ProfileRingBuffer>(GPU_THREAD_ID, "GPU"));
+    return buffers.back().get();
+  }();
+  return *gpu;
+}
+
+std::vector<std::pair<std::string, uint64_t>> Profiler::lastFrameBreakdown() {
+  uint32_t frame = getFrame() - 1;
+  std::map<std::string, uint64_t> totals;
+  // per GPU pass, the newest frame collected and its total
+  std::map<std::string, std::pair<uint32_t, uint64_t>> gpuTotals;
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  for (const auto &buffer : buffers) {
+    const bool gpu = buffer->getThreadId() == GPU_THREAD_ID;
+    for (const ProfileEvent &event : buffer->snapshot()) {
+      if (!gpu) {
+        if (event.frame == frame) {
+          totals[event.name] += event.durationNs;
+        }
+        continue;
+      }
+      auto &[newest, total] = gpuTotals[event.name];
+      if (event.frame != newest) {
+        // events are oldest first, a newer frame restarts the total
+        newest = event.frame;
+        total = 0;
+      }
+      total += event.durationNs;
+    }
+  }
+  for (const auto &[name, newest] : gpuTotals) {
+    totals["gpu." + name] = newest.second;
+  }
+  return std::vector<std::pair<std::string, uint64_t>>(totals.begin(),
+                                                       totals.end());
+}
+
+bool Profiler::writeChromeTrace(const std::string &path) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  for (const auto &buffer : buffers) {
+    out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\","
+        << "\"pid\":1,\"tid\":" << buffer->getThreadId()
+        << ",\"args\":{\"name\":";
+    writeJsonString(out, buffer->getThreadName().c_str());
+    out << "}}";
+    first = false;
+    for (const ProfileEvent &event : buffer->snapshot()) {
+      // trace timestamps are microseconds, keep the nanosecond fraction
+      out << ",\n{\"name\":";
+      writeJsonString(out, event.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->getThreadId()
+          << ",\"ts\":" << event.startNs / 1000 << '.'
+          << event.startNs % 1000 / 100 << event.startNs % 100 / 10
+          << event.startNs % 10 << ",\"dur\":" << event.durationNs / 1000
+          << '.' << event.durationNs % 1000 / 100
+          << event.durationNs % 100 / 10 << event.durationNs % 10
+          << ",\"args\":{\"frame\":" << event.frame << "}}";
+    }
+  }
+  out << "\n]}\n";
+  return (bool)out;
+}
@@ -0,0 +1,31 @@
+#include "render/BonePalettes.hpp"
+
+glm::mat4 *BonePalettes::allocate(StreamBuffer &stream,
+                                  unsigned int characterCount,
+                                  unsigned int boneCount) {
+  m_stream = &stream;
+  glm::mat4 *palettes = stream.allocate<glm::mat4>(
+      (size_t)characterCount * boneCount, m_offset);
+  m_characterCount = palettes ? characterCount : 0;
+  m_boneCount = boneCount;
+  return palettes;
+}
+
+void BonePalettes::bind(const Shader &shader) const {
+  if (m_characterCount > 0 && m_boneCount > 0) {
+    m_stream->bindRange(GL_SHADER_STORAGE_BUFFER, BONE_PALETTE_BINDING,
+                        m_offset,
+                        (size_t)m_characterCount * m_boneCount *
+                            sizeof(glm::mat4));
+  }
+  shader.setBool("skinned", true);
+  shader.setInt("boneCount", m_boneCount);
+}
+
+void BonePalettes::unbind(const Shader &shader) const {
+  shader.setBool("skinned", false);
+}
+
+unsigned int BonePalettes::getCharacterCount() const {
+  return m_characterCount;
+}
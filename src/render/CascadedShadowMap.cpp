@@ -0,0 +1,177 @@
+#include "render/CascadedShadowMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+CascadedShadowMap::CascadedShadowMap(unsigned int resolution,
+                                     unsigned int cascadeCount,
+                                     float shadowDistance)
+    : m_resolution(resolution),
+      m_cascadeCount(
+          std::clamp(cascadeCount, 2u, (unsigned int)MAX_SHADOW_CASCADES)),
+      m_shadowDistance(shadowDistance) {
+  for (unsigned int i = 0; i < MAX_SHADOW_CASCADES; i++) {
+    m_cascadeFarPlanes[i] = 0.0f;
+    m_cascadeDepthBias[i] = 0.0f;
+    m_lightSpaceMatrices[i] = glm::mat4(1.0f);
+  }
+
+  glGenFramebuffers(1, &m_FBO);
+  glGenTextures(1, &m_depthMaps);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthMaps);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, m_resolution,
+               m_resolution, m_cascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+               NULL);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+  glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+  // attach the whole array so the geometry shader can route to gl_Layer
+  glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthMaps, 0);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "ERROR::FRAMEBUFFER::CASCADED_SHADOW_MAP_INCOMPLETE"
+              << std::endl;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void CascadedShadowMap::update(const Camera &camera,
+                               const glm::vec3 lightDirection,
+                               const Aabb &sceneBounds) {
+  const float nearPlane = camera.getNearPlane();
+  const float farPlane = std::min(camera.getFarPlane(), m_shadowDistance);
+
+  // practical split scheme, log splits near the camera and uniform far away
+  for (unsigned int i = 0; i < m_cascadeCount; i++) {
+    float p = (float)(i + 1) / (float)m_cascadeCount;
+    float logSplit = nearPlane * std::pow(farPlane / nearPlane, p);
+    float uniformSplit = nearPlane + (farPlane - nearPlane) * p;
+    m_cascadeFarPlanes[i] =
+        m_splitLambda * logSplit + (1.0f - m_splitLambda) * uniformSplit;
+  }
+
+  // rotation only, so snapping below happens in a frame that does not move
+  // with the camera
+  glm::vec3 up = std::abs(glm::normalize(lightDirection).y) > 0.99f
+                     ? glm::vec3(0.0f, 0.0f, 1.0f)
+                     : glm::vec3(0.0f, 1.0f, 0.0f);
+  glm::mat4 lightRotation =
+      glm::lookAt(glm::vec3(0.0f), glm::normalize(lightDirection), up);
+
+  for (unsigned int i = 0; i < m_cascadeCount; i++) {
+    float splitNear = i == 0 ? nearPlane : m_cascadeFarPlanes[i - 1];
+    fitCascade(i, camera, splitNear, m_cascadeFarPlanes[i], lightRotation,
+               sceneBounds);
+  }
+}
+
+void CascadedShadowMap::fitCascade(unsigned int cascade, const Camera &camera,
+                                   float nearPlane, float farPlane,
+                                   const glm::mat4 &lightRotation,
+                                   const Aabb &sceneBounds) {
+  glm::mat4 sliceProjection =
+      glm::perspective(glm::radians(camera.getFov()), camera.getAspectRatio(),
+                       nearPlane, farPlane);
+  glm::mat4 inverseViewProjection =
+      glm::inverse(sliceProjection * camera.getViewMatrix());
+
+  glm::vec3 sliceCorners[8];
+  glm::vec3 center(0.0f);
+  unsigned int c = 0;
+  for (int x = 0; x < 2; x++) {
+    for (int y = 0; y < 2; y++) {
+      for (int z = 0; z < 2; z++) {
+        glm::vec4 corner = inverseViewProjection *
+                           glm::vec4(2.0f * x - 1.0f, 2.0f * y - 1.0f,
+                                     2.0f * z - 1.0f, 1.0f);
+        sliceCorners[c] = glm::vec3(corner) / corner.w;
+        center += sliceCorners[c];
+        c++;
+      }
+    }
+  }
+  center /= 8.0f;
+
+  // a bounding sphere keeps the cascade size constant while the camera
+  // rotates, rounding it up keeps it constant against float noise
+  float radius = 0.0f;
+  for (const glm::vec3 &corner : sliceCorners) {
+    radius = std::max(radius, glm::length(corner - center));
+  }
+  radius = std::ceil(radius * 16.0f) / 16.0f;
+
+  // snap the cascade center to whole shadow map texels so that translating the
+  // camera does not make shadow edges shimmer
+  float texelSize = (2.0f * radius) / (float)m_resolution;
+  glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+  lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+  lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+  // depth range covers the slice and every caster in the scene, light space
+  // looks down -z
+  float minZ = std::numeric_limits<float>::max();
+  float maxZ = std::numeric_limits<float>::lowest();
+  for (const glm::vec3 &corner : sliceCorners) {
+    float z = (lightRotation * glm::vec4(corner, 1.0f)).z;
+    minZ = std::min(minZ, z);
+    maxZ = std::max(maxZ, z);
+  }
+  for (unsigned int i = 0; i < 8 && !sceneBounds.isEmpty(); i++) {
+    glm::vec3 corner = sceneBounds.getCorner(i);
+    float z = (lightRotation * glm::vec4(corner, 1.0f)).z;
+    minZ = std::min(minZ, z);
+    maxZ = std::max(maxZ, z);
+  }
+
+  glm::mat4 lightProjection =
+      glm::ortho(lightCenter.x - radius, lightCenter.x + radius,
+                 lightCenter.y - radius, lightCenter.y + radius, -maxZ, -minZ);
+  m_lightSpaceMatrices[cascade] = lightProjection * lightRotation;
+  // one texel of world space expressed in [0,1] depth units
+  m_cascadeDepthBias[cascade] = texelSize / std::max(maxZ - minZ, 0.001f);
+}
+
+void CascadedShadowMap::bindForWriting() const {
+  glViewport(0, 0, m_resolution, m_resolution);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+}
+
+void CascadedShadowMap::bindTexture(unsigned int unit) const {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthMaps);
+}
+
+void CascadedShadowMap::setDepthUniforms(const Shader &shader) const {
+  shader.setInt("cascadeCount", m_cascadeCount);
+  shader.setMat4Array("lightSpaceMatrices", m_lightSpaceMatrices,
+                      m_cascadeCount);
+}
+
+void CascadedShadowMap::setLightingUniforms(const Shader &shader) const {
+  shader.setInt("cascadeCount", m_cascadeCount);
+  shader.setMat4Array("lightSpaceMatrices", m_lightSpaceMatrices,
+                      m_cascadeCount);
+  shader.setFloatArray("cascadeFarPlanes", m_cascadeFarPlanes, m_cascadeCount);
+  shader.setFloatArray("cascadeDepthBias", m_cascadeDepthBias, m_cascadeCount);
+}
+
+unsigned int CascadedShadowMap::getResolution() const { return m_resolution; }
+
+unsigned int CascadedShadowMap::getCascadeCount() const {
+  return m_cascadeCount;
+}
+
+glm::mat4 CascadedShadowMap::getLightSpaceMatrix(unsigned int cascade) const {
+  return m_lightSpaceMatrices[cascade];
+}
@@ -0,0 +1,266 @@
+#include "render/ClusteredLights.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "jobs/JobSystem.hpp"
+#include "memory/FrameArena.hpp"
+#include "profiling/Profiler.hpp"
+
+namespace {
+const unsigned int CLUSTER_COUNT =
+    LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z;
+// lights per job when bounding them
+const unsigned int LIGHTS_PER_JOB = 64;
+
+static_assert(sizeof(PointLight) == 2 * sizeof(glm::vec4),
+              "PointLight must match the shader's two vec4s");
+
+int toTile(float ndc, int tiles) {
+  return std::clamp((int)std::floor((ndc * 0.5f + 0.5f) * tiles), 0,
+                    tiles - 1);
+}
+} // namespace
+
+ClusteredLights::ClusteredLights()
+    : m_clusters(CLUSTER_COUNT), m_sliceIndices(LIGHT_CLUSTERS_Z) {}
+
+void ClusteredLights::update(const glm::mat4 &view,
+                             const glm::mat4 &projection, float nearPlane,
+                             float farPlane, const PointLight *lights,
+                             unsigned int lightCount, StreamBuffer &stream) {
+  assign(view, projection, nearPlane, farPlane, lights, lightCount);
+  PROFILE_SCOPE("lights.upload");
+  // copied rather than built in place, the lists are read back on the CPU
+  // and the mapping must never be read
+  m_stream = nullptr;
+  // at least one element each, bound ranges must not be empty
+  PointLight *lightData =
+      stream.allocate<PointLight>(std::max(lightCount, 1u), m_lightOffset);
+  glm::uvec2 *clusterData =
+      stream.allocate<glm::uvec2>(m_clusters.size(), m_clusterOffset);
+  uint32_t *indexData = stream.allocate<uint32_t>(
+      std::max<size_t>(m_indices.size(), 1), m_indexOffset);
+  if (!lightData || !clusterData || !indexData) {
+    return;
+  }
+  if (lightCount > 0) {
+    std::memcpy(lightData, lights, lightCount * sizeof(PointLight));
+  }
+  std::memcpy(clusterData, m_clusters.data(),
+              m_clusters.size() * sizeof(glm::uvec2));
+  if (!m_indices.empty()) {
+    std::memcpy(indexData, m_indices.data(),
+                m_indices.size() * sizeof(uint32_t));
+  }
+  m_stream = &stream;
+}
+
+void ClusteredLights::assign(const glm::mat4 &view,
+                             const glm::mat4 &projection, float nearPlane,
+                             float farPlane, const PointLight *lights,
+                             unsigned int lightCount) {
+  PROFILE_SCOPE("lights.assign");
+  m_lightCount = lightCount;
+  if (projection[0][0] != m_projectionX ||
+      projection[1][1] != m_projectionY || nearPlane != m_nearPlane ||
+      farPlane != m_farPlane) {
+    buildClusterBounds(projection, nearPlane, farPlane);
+  }
+  JobSystem &jobs = JobSystem::getDefault();
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  FrameVector<LightRange> ranges(lightCount, &arena);
+  jobs.parallelFor(lightCount, LIGHTS_PER_JOB,
+                   [&](unsigned int begin, unsigned int end) {
+                     for (unsigned int i = begin; i < end; i++) {
+                       ranges[i] = findRange(view, lights[i]);
+                     }
+                   });
+  jobs.parallelFor(LIGHT_CLUSTERS_Z, 1,
+                   [&](unsigned int begin, unsigned int end) {
+                     for (unsigned int slice = begin; slice < end; slice++) {
+                       assignSlice(slice, ranges.data(), lightCount);
+                     }
+                   });
+
+  // the slices' froxel offsets are local to their lists until joined
+  m_indices.clear();
+  const unsigned int sliceClusters = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+  for (unsigned int slice = 0; slice < LIGHT_CLUSTERS_Z; slice++) {
+    const uint32_t base = m_indices.size();
+    for (unsigned int i = 0; i < sliceClusters; i++) {
+      m_clusters[slice * sliceClusters + i].x += base;
+    }
+    m_indices.insert(m_indices.end(), m_sliceIndices[slice].begin(),
+                     m_sliceIndices[slice].end());
+  }
+}
+
+void ClusteredLights::bind(const Shader &shader) const {
+  // an empty grid tells the shader there is nothing to read
+  if (!m_stream) {
+    glUniform3i(glGetUniformLocation(shader.ID, "clusterGrid"), 0, 0, 0);
+    return;
+  }
+  m_stream->bindRange(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_BINDING,
+                      m_lightOffset,
+                      std::max(m_lightCount, 1u) * sizeof(PointLight));
+  m_stream->bindRange(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BINDING,
+                      m_clusterOffset,
+                      m_clusters.size() * sizeof(glm::uvec2));
+  m_stream->bindRange(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BINDING,
+                      m_indexOffset,
+                      std::max<size_t>(m_indices.size(), 1) *
+                          sizeof(uint32_t));
+  glUniform3i(glGetUniformLocation(shader.ID, "clusterGrid"),
+              LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z);
+  shader.setFloat("clusterScale", m_sliceScale);
+  shader.setFloat("clusterBias", m_sliceBias);
+}
+
+unsigned int ClusteredLights::getLightCount() const { return m_lightCount; }
+
+unsigned int ClusteredLights::getAssignmentCount() const {
+  return m_indices.size();
+}
+
+const uint32_t *ClusteredLights::getClusterLights(unsigned int cluster,
+                                                  unsigned int &count) const {
+  count = m_clusters[cluster].y;
+  return m_indices.data() + m_clusters[cluster].x;
+}
+
+unsigned int ClusteredLights::getSlice(float viewDistance) const {
+  const float slice =
+      std::log(std::max(viewDistance, m_nearPlane)) * m_sliceScale +
+      m_sliceBias;
+  return std::clamp((int)std::floor(slice), 0, LIGHT_CLUSTERS_Z - 1);
+}
+
+void ClusteredLights::buildClusterBounds(const glm::mat4 &projection,
+                                         float nearPlane, float farPlane) {
+  m_projectionX = projection[0][0];
+  m_projectionY = projection[1][1];
+  m_nearPlane = nearPlane;
+  m_farPlane = farPlane;
+  const float logRatio = std::log(farPlane / nearPlane);
+  m_sliceScale = LIGHT_CLUSTERS_Z / logRatio;
+  m_sliceBias = -LIGHT_CLUSTERS_Z * std::log(nearPlane) / logRatio;
+
+  m_clusterBounds.resize(CLUSTER_COUNT);
+  for (unsigned int z = 0; z < LIGHT_CLUSTERS_Z; z++) {
+    const float near =
+        nearPlane * std::pow(farPlane / nearPlane, (float)z / LIGHT_CLUSTERS_Z);
+    const float far = nearPlane * std::pow(farPlane / nearPlane,
+                                           (float)(z + 1) / LIGHT_CLUSTERS_Z);
+    for (unsigned int y = 0; y < LIGHT_CLUSTERS_Y; y++) {
+      const float y0 = -1.0f + 2.0f * y / LIGHT_CLUSTERS_Y;
+      const float y1 = -1.0f + 2.0f * (y + 1) / LIGHT_CLUSTERS_Y;
+      for (unsigned int x = 0; x < LIGHT_CLUSTERS_X; x++) {
+        const float x0 = -1.0f + 2.0f * x / LIGHT_CLUSTERS_X;
+        const float x1 = -1.0f + 2.0f * (x + 1) / LIGHT_CLUSTERS_X;
+        // the tile's side planes pass through the eye, so its widest
+        // extent on each side is at one of the slice's two depths
+        Aabb &box = m_clusterBounds[(z * LIGHT_CLUSTERS_Y + y) *
+                                        LIGHT_CLUSTERS_X +
+                                    x];
+        box = Aabb();
+        for (float depth : {near, far}) {
+          box.expand(glm::vec3(x0 * depth / m_projectionX,
+                               y0 * depth / m_projectionY, -depth));
+          box.expand(glm::vec3(x1 * depth / m_projectionX,
+                               y1 * depth / m_projectionY, -depth));
+        }
+      }
+    }
+  }
+}
+
+ClusteredLights::LightRange
+ClusteredLights::findRange(const glm::mat4 &view,
+                           const PointLight &light) const {
+  LightRange range;
+  range.viewCenter = glm::vec3(view * glm::vec4(light.position, 1.0f));
+  range.radius = light.radius;
+  range.x0 = range.y0 = range.z0 = 1;
+  range.x1 = range.y1 = range.z1 = 0;
+  const float nearest = -range.viewCenter.z - light.radius;
+  const float farthest = -range.viewCenter.z + light.radius;
+  if (farthest < m_nearPlane || nearest > m_farPlane) {
+    return range;
+  }
+  const float depths[2] = {std::max(nearest, m_nearPlane),
+                           std::min(farthest, m_farPlane)};
+  // x / depth is monotonic in both, so the sphere's box projects inside the
+  // corners at its nearest and farthest depth
+  glm::vec2 low(FLT_MAX);
+  glm::vec2 high(-FLT_MAX);
+  const glm::vec2 scale(m_projectionX, m_projectionY);
+  const glm::vec2 center(range.viewCenter);
+  for (float depth : depths) {
+    for (float side : {-light.radius, light.radius}) {
+      const glm::vec2 ndc = (center + side) * scale / depth;
+      low = glm::min(low, ndc);
+      high = glm::max(high, ndc);
+    }
+  }
+  if (high.x < -1.0f || low.x > 1.0f || high.y < -1.0f || low.y > 1.0f) {
+    return range;
+  }
+  range.x0 = toTile(low.x, LIGHT_CLUSTERS_X);
+  range.x1 = toTile(high.x, LIGHT_CLUSTERS_X);
+  range.y0 = toTile(low.y, LIGHT_CLUSTERS_Y);
+  range.y1 = toTile(high.y, LIGHT_CLUSTERS_Y);
+  range.z0 = getSlice(depths[0]);
+  range.z1 = getSlice(depths[1]);
+  return range;
+}
+
+void ClusteredLights::assignSlice(unsigned int slice,
+                                  const LightRange *ranges,
+                                  unsigned int lightCount) {
+  std::vector<uint32_t> &indices = m_sliceIndices[slice];
+  indices.clear();
+  FrameArena &arena = FrameArena::forThread();
+  FrameArenaScope scratch(arena);
+  // lights in the slice, then in each row of it, so a froxel only walks
+  // the few that may reach it
+  FrameVector<uint32_t> candidates(&arena);
+  FrameVector<uint32_t> row(&arena);
+  for (unsigned int i = 0; i < lightCount; i++) {
+    const LightRange &range = ranges[i];
+    if (range.x0 <= range.x1 && range.z0 <= (int)slice &&
+        (int)slice <= range.z1) {
+      candidates.push_back(i);
+    }
+  }
+  for (int y = 0; y < LIGHT_CLUSTERS_Y; y++) {
+    row.clear();
+    for (uint32_t light : candidates) {
+      if (ranges[light].y0 <= y && y <= ranges[light].y1) {
+        row.push_back(light);
+      }
+    }
+    for (int x = 0; x < LIGHT_CLUSTERS_X; x++) {
+      const unsigned int cluster =
+          (slice * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x;
+      const Aabb &box = m_clusterBounds[cluster];
+      const uint32_t first = indices.size();
+      for (uint32_t light : row) {
+        const LightRange &range = ranges[light];
+        if (x < range.x0 || x > range.x1) {
+          continue;
+        }
+        const glm::vec3 closest =
+            glm::clamp(range.viewCenter, box.min, box.max);
+        const glm::vec3 offset = closest - range.viewCenter;
+        if (glm::dot(offset, offset) <= range.radius * range.radius) {
+          indices.push_back(light);
+        }
+      }
+      m_clusters[cluster] = glm::uvec2(first, indices.size() - first);
+    }
+  }
+}
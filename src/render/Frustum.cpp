@@ -0,0 +1,50 @@
+#include "render/Frustum.hpp"
+
+Frustum::Frustum() {
+  // accepts everything until set from a matrix
+  for (glm::vec4 &plane : m_planes) {
+    plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+}
+
+Frustum::Frustum(const glm::mat4 &viewProjection) {
+  // Gribb and Hartmann: each plane is the last row of the matrix plus or
+  // minus another row, clip space z runs from -w to w
+  const glm::mat4 rows = glm::transpose(viewProjection);
+  for (int axis = 0; axis < 3; axis++) {
+    m_planes[2 * axis] = rows[3] + rows[axis];
+    m_planes[2 * axis + 1] = rows[3] - rows[axis];
+  }
+  for (glm::vec4 &plane : m_planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+}
+
+bool Frustum::intersects(const glm::vec3 &center, float radius) const {
+  for (const glm::vec4 &plane : m_planes) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Frustum::intersects(const BoundingSphere &sphere) const {
+  return !sphere.isEmpty() && intersects(sphere.center, sphere.radius);
+}
+
+bool Frustum::intersects(const Aabb &box) const {
+  if (box.isEmpty()) {
+    return false;
+  }
+  const glm::vec3 center = box.getCenter();
+  const glm::vec3 extent = box.getExtent();
+  for (const glm::vec4 &plane : m_planes) {
+    // the box's extent along the plane normal
+    const float reach = glm::dot(glm::abs(glm::vec3(plane)), extent);
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -reach) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,44 @@
+#include "render/LodSelector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+LodSelector::LodSelector(float pixelError, float hysteresis)
+    : m_pixelError(pixelError), m_hysteresis(hysteresis) {}
+
+void LodSelector::setView(const Camera &camera) {
+  m_eye = camera.getPosition();
+  const float halfFov = glm::radians(camera.getFov()) * 0.5f;
+  m_pixelsPerUnit = camera.getScreenHeight() * 0.5f / std::tan(halfFov);
+}
+
+unsigned int LodSelector::select(unsigned int object, const glm::vec3 &center,
+                                 float scale,
+                                 const std::vector<float> &levelErrors) {
+  if (levelErrors.empty()) {
+    return 0;
+  }
+  if (object >= m_levels.size()) {
+    m_levels.resize(object + 1, 0);
+  }
+  // an object around the camera gets an infinite projection and level 0
+  const float distance = std::max(glm::length(center - m_eye), 1e-4f);
+  const float pixelsPerError = scale * m_pixelsPerUnit / distance;
+  const unsigned int lastLevel = levelErrors.size() - 1;
+
+  unsigned int level = std::min<unsigned int>(m_levels[object], lastLevel);
+  while (level > 0 && levelErrors[level] * pixelsPerError > m_pixelError) {
+    level--;
+  }
+  const float coarserLimit = m_pixelError * (1.0f - m_hysteresis);
+  while (level < lastLevel &&
+         levelErrors[level + 1] * pixelsPerError <= coarserLimit) {
+    level++;
+  }
+  m_levels[object] = level;
+  return level;
+}
+
+void LodSelector::resize(unsigned int objectCount) {
+  m_levels.resize(objectCount, 0);
+}
@@ -0,0 +1,135 @@
+#include "render/ProgramCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "ProjectRoot.hpp"
+#include "profiling/Profiler.hpp"
+#include "texture/MappedFile.hpp"
+
+namespace {
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+// the length goes in first, so moving text between stages changes the key
+uint64_t hashString(uint64_t hash, const std::string &text) {
+  const uint64_t size = text.size();
+  hash = hashBytes(hash, &size, sizeof(size));
+  return hashBytes(hash, text.data(), text.size());
+}
+
+std::string getGlString(GLenum name) {
+  const char *value = (const char *)glGetString(name);
+  return value ? value : "";
+}
+} // namespace
+
+ProgramCache::ProgramCache(const std::string &directory)
+    : m_directory(directory) {}
+
+uint64_t ProgramCache::makeKey(const std::string &vertexCode,
+                               const std::string &fragmentCode,
+                               const std::string &geometryCode) {
+  static const std::string driver =
+      getGlString(GL_VENDOR) + "\n" + getGlString(GL_RENDERER) + "\n" +
+      getGlString(GL_VERSION) + "\n" +
+      getGlString(GL_SHADING_LANGUAGE_VERSION);
+  uint64_t hash = FNV_OFFSET;
+  hash = hashString(hash, vertexCode);
+  hash = hashString(hash, fragmentCode);
+  hash = hashString(hash, geometryCode);
+  return hashString(hash, driver);
+}
+
+unsigned int ProgramCache::load(uint64_t key) const {
+  if (!isSupported()) {
+    return 0;
+  }
+  PROFILE_SCOPE("shader.binary_load");
+  MappedFile file;
+  if (!file.open(getPath(key)) ||
+      file.getSize() < sizeof(ProgramBinaryHeader)) {
+    return 0;
+  }
+  ProgramBinaryHeader header;
+  std::memcpy(&header, file.getData(), sizeof(header));
+  if (header.magic != PROGRAM_CACHE_MAGIC ||
+      header.version != PROGRAM_CACHE_VERSION || header.key != key ||
+      header.size != file.getSize() - sizeof(header)) {
+    return 0;
+  }
+  unsigned int program = glCreateProgram();
+  glProgramBinary(program, header.format, file.getData() + sizeof(header),
+                  header.size);
+  int success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    std::cout << "ERROR::PROGRAM_CACHE::BINARY_REJECTED " << getPath(key)
+              << std::endl;
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+
+bool ProgramCache::store(uint64_t key, unsigned int program) const {
+  if (!isSupported()) {
+    return false;
+  }
+  int length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return false;
+  }
+  std::vector<unsigned char> data(sizeof(ProgramBinaryHeader) + length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format,
+                     data.data() + sizeof(ProgramBinaryHeader));
+  ProgramBinaryHeader header = {};
+  header.magic = PROGRAM_CACHE_MAGIC;
+  header.version = PROGRAM_CACHE_VERSION;
+  header.format = format;
+  header.key = key;
+  header.size = length;
+  std::memcpy(data.data(), &header, sizeof(header));
+  data.resize(sizeof(header) + length);
+
+  const std::string path = getPath(key);
+  if (!writeFileAtomically(path, data.data(), data.size())) {
+    std::cout << "ERROR::PROGRAM_CACHE::WRITE_FAILED " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::string ProgramCache::getPath(uint64_t key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.pbin", (unsigned long long)key);
+  return m_directory + "/" + name;
+}
+
+bool ProgramCache::isSupported() {
+  static const bool supported = [] {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    return count > 0;
+  }();
+  return supported;
+}
+
+ProgramCache &ProgramCache::getDefault() {
+  static ProgramCache cache(ProjectRoot::getPath(PROGRAM_CACHE_DIRECTORY));
+  return cache;
+}
@@ -0,0 +1,39 @@
+#include "render/ShaderVariants.hpp"
+
+ShaderVariants::ShaderVariants(const std::string &vertexPath,
+                               const std::string &fragmentPath,
+                               const std::string &geometryPath,
+                               const ShaderDefines &base)
+    : m_vertexPath(vertexPath), m_fragmentPath(fragmentPath),
+      m_geometryPath(geometryPath), m_base(base) {}
+
+Shader &ShaderVariants::get(const ShaderDefines &defines) {
+  ShaderDefines merged = defines;
+  // insert keeps the variant's own value where both set a name
+  merged.insert(m_base.begin(), m_base.end());
+  const std::string key = makeKey(merged);
+  auto found = m_variants.find(key);
+  if (found != m_variants.end()) {
+    return found->second;
+  }
+  // the program may come from the binary cache, Shader only compiles on a
+  // miss
+  std::cout << "loading shader variant " << m_fragmentPath << " [" << key
+            << "]" << std::endl;
+  return m_variants
+      .emplace(key,
+               Shader(m_vertexPath, m_fragmentPath, m_geometryPath, merged))
+      .first->second;
+}
+
+unsigned int ShaderVariants::getVariantCount() const {
+  return m_variants.size();
+}
+
+std::string ShaderVariants::makeKey(const ShaderDefines &defines) {
+  std::string key;
+  for (const auto &[name, value] : defines) {
+    key += name + "=" + value + ";";
+  }
+  return key;
+}
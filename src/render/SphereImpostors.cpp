@@ -0,0 +1,17 @@
+#include "render/SphereImpostors.hpp"
+
+SphereImpostors::SphereImpostors()
+    : m_vertexArray(GlVertexArray::create()) {}
+
+void SphereImpostors::draw(const Shader &shader, unsigned int sphereBuffer,
+                           size_t offset, unsigned int sphereCount) const {
+  if (sphereCount == 0) {
+    return;
+  }
+  glUseProgram(shader.ID);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SPHERE_IMPOSTOR_BINDING,
+                    sphereBuffer, offset, sphereCount * sizeof(glm::vec4));
+  glBindVertexArray(m_vertexArray.get());
+  glDrawArrays(GL_TRIANGLES, 0, sphereCount * 6);
+  glBindVertexArray(0);
+}
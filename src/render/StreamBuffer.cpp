@@ -0,0 +1,109 @@
+#include "render/StreamBuffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "profiling/Profiler.hpp"
+
+namespace {
+// client waits are retried in slices so a lost context cannot hang forever
+const GLuint64 FENCE_WAIT_NS = 100000000;
+const unsigned int FENCE_WAIT_TRIES = 20;
+} // namespace
+
+StreamBuffer::StreamBuffer(size_t regionBytes)
+    : m_buffer(GlBuffer::create()) {
+  GLint storageAlignment = 0;
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+  GLint uniformAlignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+  m_alignment = std::max<size_t>(
+      {m_alignment, (size_t)storageAlignment, (size_t)uniformAlignment});
+  // regions start aligned, so offsets aligned within one stay aligned
+  m_regionBytes = (regionBytes + m_alignment - 1) / m_alignment * m_alignment;
+
+  const GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer.get());
+  glBufferStorage(GL_ARRAY_BUFFER, m_regionBytes * STREAM_BUFFER_REGIONS,
+                  nullptr, flags);
+  m_mapped = static_cast<unsigned char *>(glMapBufferRange(
+      GL_ARRAY_BUFFER, 0, m_regionBytes * STREAM_BUFFER_REGIONS, flags));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (!m_mapped) {
+    std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << std::endl;
+  }
+  // the first beginFrame moves to region 0
+  m_region = STREAM_BUFFER_REGIONS - 1;
+}
+
+StreamBuffer::~StreamBuffer() {
+  for (GLsync &fence : m_fences) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+  if (m_mapped) {
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer.get());
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
+
+void StreamBuffer::beginFrame() {
+  m_region = (m_region + 1) % STREAM_BUFFER_REGIONS;
+  m_used = 0;
+  GLsync &fence = m_fences[m_region];
+  if (!fence) {
+    return;
+  }
+  PROFILE_SCOPE("stream.wait");
+  // the first wait flushes, so the fence is sure to be submitted
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  for (unsigned int i = 0; i < FENCE_WAIT_TRIES; i++) {
+    const GLenum status = glClientWaitSync(fence, flags, FENCE_WAIT_NS);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED ||
+        status == GL_WAIT_FAILED) {
+      break;
+    }
+    flags = 0;
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+  GLsync &fence = m_fences[m_region];
+  if (fence) {
+    glDeleteSync(fence);
+  }
+  fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+size_t StreamBuffer::allocate(size_t bytes) {
+  const size_t aligned = (bytes + m_alignment - 1) / m_alignment * m_alignment;
+  const size_t offset = m_used.fetch_add(aligned);
+  if (!m_mapped || offset + aligned > m_regionBytes) {
+    if (!m_overflowReported.exchange(true)) {
+      std::cout << "ERROR::STREAM_BUFFER::REGION_FULL " << offset + aligned
+                << " of " << m_regionBytes << " bytes" << std::endl;
+    }
+    return STREAM_BUFFER_FULL;
+  }
+  return m_region * m_regionBytes + offset;
+}
+
+void *StreamBuffer::getPointer(size_t offset) const {
+  return m_mapped + offset;
+}
+
+void StreamBuffer::bindRange(GLenum target, unsigned int index, size_t offset,
+                             size_t bytes) const {
+  glBindBufferRange(target, index, m_buffer.get(), offset, bytes);
+}
+
+unsigned int StreamBuffer::getBuffer() const { return m_buffer.get(); }
+
+size_t StreamBuffer::getRegionBytes() const { return m_regionBytes; }
+
+size_t StreamBuffer::getUsedBytes() const { return m_used; }
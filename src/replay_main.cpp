@@ -0,0 +1,43 @@
+#include <chrono>
+#include <iostream>
+
+#include "input/Replay.hpp"
+
+// Headless playback of a recording made with ENGINE_RECORD=<path>. Runs the
+// simulation as fast as the CPU allows and checks every frame's state hash
+// against the recording.
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cout << "usage: " << argv[0] << " <recording>" << std::endl;
+    return 2;
+  }
+
+  ReplayPlayer player;
+  if (!player.open(argv[1])) {
+    return 2;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  bool played = player.run();
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  double recordedSeconds = player.getRecordedTimeUs() / 1e6;
+
+  std::cout << "frames: " << player.getFrameCount() << std::endl;
+  std::cout << "ticks: " << player.getWorld().getTick() << std::endl;
+  std::cout << "bodies: " << player.getWorld().getBodyCount() << std::endl;
+  std::cout << "recorded: " << recordedSeconds << " s" << std::endl;
+  std::cout << "played: " << seconds << " s ("
+            << (seconds > 0.0 ? recordedSeconds / seconds : 0.0)
+            << "x real time)" << std::endl;
+  std::cout << "state hash: " << std::hex
+            << player.getWorld().computeStateHash() << std::dec << std::endl;
+  if (player.hasDesynced()) {
+    std::cout << "DESYNC at tick " << player.getDesyncTick() << std::endl;
+  }
+  if (!played) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "net/ReplicationServer.hpp"
+#include "physics/DefaultArena.hpp"
+#include "physics/PhysicsWorld.hpp"
+
+// Headless authoritative simulation serving viewers over UDP. Start a viewer
+// with ENGINE_CONNECT=<host>[:port] ./engine.
+//   engine_server [port] [bodies]
+namespace {
+const float TIMESTEP = 1.0f / 60.0f;
+const float STATS_INTERVAL = 5.0f;
+// share of the arena volume filled by spheres
+const float VOLUME_FRACTION = 0.05f;
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint16_t port = argc > 1 ? std::atoi(argv[1]) : NET_DEFAULT_PORT;
+  const unsigned int bodyCount = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  PhysicsWorld world(DEFAULT_ARENA_MIN, DEFAULT_ARENA_MAX);
+  world.setDeterministic(true);
+  world.setFixedTimestep(TIMESTEP);
+  glm::vec3 extent = DEFAULT_ARENA_MAX - DEFAULT_ARENA_MIN;
+  float radius = std::cbrt(VOLUME_FRACTION * extent.x * extent.y * extent.z /
+                           (bodyCount * 4.0f / 3.0f * 3.14159265f));
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::uniform_real_distribution<float> speed(-10.0f, 10.0f);
+  world.reserve(bodyCount);
+  for (unsigned int i = 0; i < bodyCount; i++) {
+    world.addBody(DEFAULT_ARENA_MIN +
+                      extent * glm::vec3(unit(rng), unit(rng), unit(rng)),
+                  glm::vec3(speed(rng), speed(rng), speed(rng)), radius);
+  }
+
+  ReplicationServer server(world);
+  if (!server.open(port)) {
+    return 1;
+  }
+  std::cout << "serving " << bodyCount << " bodies on port "
+            << server.getPort() << std::endl;
+
+  using Clock = std::chrono::steady_clock;
+  auto nextTick = Clock::now();
+  float statsTimer = 0.0f;
+  uint64_t lastBytes = 0;
+  uint64_t lastBodies = 0;
+  while (true) {
+    world.step(TIMESTEP);
+    server.update(TIMESTEP);
+
+    statsTimer += TIMESTEP;
+    if (statsTimer >= STATS_INTERVAL) {
+      std::cout << "tick " << world.getTick() << ", "
+                << server.getClientCount() << " clients, "
+                << (server.getBytesSent() - lastBytes) / statsTimer / 1024.0f
+                << " KiB/s, "
+                << (server.getBytesSent() - lastBytes) /
+                       (double)std::max<uint64_t>(
+                           server.getBodiesSent() - lastBodies, 1)
+                << " bytes per body update" << std::endl;
+      lastBytes = server.getBytesSent();
+      lastBodies = server.getBodiesSent();
+      statsTimer = 0.0f;
+    }
+
+    nextTick += std::chrono::microseconds((int64_t)(TIMESTEP * 1e6f));
+    std::this_thread::sleep_until(nextTick);
+  }
+}
@@ -0,0 +1,265 @@
+#include "texture/BlockCompression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+namespace {
+uint16_t packColor565(const glm::vec3 color) {
+  glm::vec3 c = glm::clamp(color, glm::vec3(0.0f), glm::vec3(255.0f));
+  unsigned int r = (unsigned int)(c.r * 31.0f / 255.0f + 0.5f);
+  unsigned int g = (unsigned int)(c.g * 63.0f / 255.0f + 0.5f);
+  unsigned int b = (unsigned int)(c.b * 31.0f / 255.0f + 0.5f);
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+glm::vec3 unpackColor565(uint16_t color) {
+  unsigned int r = (color >> 11) & 31;
+  unsigned int g = (color >> 5) & 63;
+  unsigned int b = color & 31;
+  return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4),
+                   (b << 3) | (b >> 2));
+}
+
+// the four colors of an opaque block, c0 > c1
+void colorPalette(uint16_t c0, uint16_t c1, glm::vec3 palette[4]) {
+  palette[0] = unpackColor565(c0);
+  palette[1] = unpackColor565(c1);
+  palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+  palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+}
+
+// picks the nearest palette entry per pixel, returns the squared error
+float fitIndices(const glm::vec3 pixels[16], const glm::vec3 palette[4],
+                 unsigned int indices[16]) {
+  float error = 0.0f;
+  for (int i = 0; i < 16; i++) {
+    float best = 1e30f;
+    for (unsigned int p = 0; p < 4; p++) {
+      glm::vec3 d = pixels[i] - palette[p];
+      float distance = glm::dot(d, d);
+      if (distance < best) {
+        best = distance;
+        indices[i] = p;
+      }
+    }
+    error += best;
+  }
+  return error;
+}
+
+// endpoints minimising the squared error for fixed indices
+bool solveEndpoints(const glm::vec3 pixels[16], const unsigned int indices[16],
+                    glm::vec3 &end0, glm::vec3 &end1) {
+  static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  glm::vec3 ax(0.0f), bx(0.0f);
+  for (int i = 0; i < 16; i++) {
+    float a = weights[indices[i]];
+    float b = 1.0f - a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    ax += a * pixels[i];
+    bx += b * pixels[i];
+  }
+  float det = aa * bb - ab * ab;
+  if (std::abs(det) < 1e-6f) {
+    return false;
+  }
+  end0 = (ax * bb - bx * ab) / det;
+  end1 = (bx * aa - ax * ab) / det;
+  return true;
+}
+
+void writeColorBlock(uint16_t c0, uint16_t c1, const unsigned int indices[16],
+                     unsigned char *block) {
+  uint32_t bits = 0;
+  for (int i = 0; i < 16; i++) {
+    bits |= indices[i] << (2 * i);
+  }
+  block[0] = c0 & 0xff;
+  block[1] = c0 >> 8;
+  block[2] = c1 & 0xff;
+  block[3] = c1 >> 8;
+  std::memcpy(block + 4, &bits, 4);
+}
+
+void encodeColorBlock(const unsigned char *rgba, unsigned char *block) {
+  glm::vec3 pixels[16];
+  glm::vec3 mean(0.0f);
+  for (int i = 0; i < 16; i++) {
+    pixels[i] = glm::vec3(rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2]);
+    mean += pixels[i];
+  }
+  mean /= 16.0f;
+
+  // endpoints at the extremes along the principal axis of the colors
+  float cov[6] = {0.0f};
+  for (int i = 0; i < 16; i++) {
+    glm::vec3 d = pixels[i] - mean;
+    cov[0] += d.r * d.r;
+    cov[1] += d.r * d.g;
+    cov[2] += d.r * d.b;
+    cov[3] += d.g * d.g;
+    cov[4] += d.g * d.b;
+    cov[5] += d.b * d.b;
+  }
+  glm::vec3 axis(1.0f);
+  for (int iteration = 0; iteration < 8; iteration++) {
+    glm::vec3 next(cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                   cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                   cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b);
+    float length = glm::length(next);
+    if (length < 1e-6f) {
+      break;
+    }
+    axis = next / length;
+  }
+  float lo = 1e30f, hi = -1e30f;
+  for (int i = 0; i < 16; i++) {
+    float t = glm::dot(pixels[i] - mean, axis);
+    lo = std::min(lo, t);
+    hi = std::max(hi, t);
+  }
+
+  uint16_t c0 = packColor565(mean + axis * hi);
+  uint16_t c1 = packColor565(mean + axis * lo);
+  unsigned int indices[16];
+  glm::vec3 palette[4];
+  float error = 1e30f;
+  if (c0 != c1) {
+    if (c0 < c1) {
+      std::swap(c0, c1);
+    }
+    colorPalette(c0, c1, palette);
+    error = fitIndices(pixels, palette, indices);
+
+    // one least squares pass over the endpoints, kept if it helps
+    glm::vec3 end0, end1;
+    if (solveEndpoints(pixels, indices, end0, end1)) {
+      uint16_t r0 = packColor565(end0);
+      uint16_t r1 = packColor565(end1);
+      if (r0 < r1) {
+        std::swap(r0, r1);
+      }
+      if (r0 != r1) {
+        unsigned int refined[16];
+        glm::vec3 refinedPalette[4];
+        colorPalette(r0, r1, refinedPalette);
+        float refinedError = fitIndices(pixels, refinedPalette, refined);
+        if (refinedError < error) {
+          c0 = r0;
+          c1 = r1;
+          std::copy(refined, refined + 16, indices);
+          error = refinedError;
+        }
+      }
+    }
+  }
+  if (c0 == c1) {
+    // a single color, c0 > c1 keeps the opaque mode
+    std::fill(indices, indices + 16, 0u);
+    if (c1 > 0) {
+      c1--;
+    } else {
+      c0++;
+      std::fill(indices, indices + 16, 1u);
+    }
+  }
+  writeColorBlock(c0, c1, indices, block);
+}
+
+void decodeColorBlock(const unsigned char *block, unsigned char *rgba) {
+  uint16_t c0 = block[0] | (block[1] << 8);
+  uint16_t c1 = block[2] | (block[3] << 8);
+  uint32_t bits;
+  std::memcpy(&bits, block + 4, 4);
+  glm::vec3 palette[4];
+  colorPalette(c0, c1, palette);
+  if (c0 <= c1) {
+    // three color mode, only produced by other encoders
+    palette[2] = (palette[0] + palette[1]) / 2.0f;
+    palette[3] = glm::vec3(0.0f);
+  }
+  for (int i = 0; i < 16; i++) {
+    glm::vec3 color = palette[(bits >> (2 * i)) & 3];
+    rgba[4 * i] = (unsigned char)(color.r + 0.5f);
+    rgba[4 * i + 1] = (unsigned char)(color.g + 0.5f);
+    rgba[4 * i + 2] = (unsigned char)(color.b + 0.5f);
+    rgba[4 * i + 3] = 255;
+  }
+}
+
+// the eight alphas of a block, a0 > a1
+void alphaPalette(unsigned int a0, unsigned int a1, unsigned int palette[8]) {
+  palette[0] = a0;
+  palette[1] = a1;
+  if (a0 > a1) {
+    for (unsigned int i = 1; i < 7; i++) {
+      palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+    }
+  } else {
+    for (unsigned int i = 1; i < 5; i++) {
+      palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+} // namespace
+
+void encodeBC1Block(const unsigned char *rgba, unsigned char *block) {
+  encodeColorBlock(rgba, block);
+}
+
+void encodeBC3Block(const unsigned char *rgba, unsigned char *block) {
+  unsigned int a0 = 0, a1 = 255;
+  for (int i = 0; i < 16; i++) {
+    a0 = std::max(a0, (unsigned int)rgba[4 * i + 3]);
+    a1 = std::min(a1, (unsigned int)rgba[4 * i + 3]);
+  }
+  uint64_t bits = 0;
+  if (a0 > a1) {
+    unsigned int palette[8];
+    alphaPalette(a0, a1, palette);
+    for (int i = 0; i < 16; i++) {
+      int alpha = rgba[4 * i + 3];
+      unsigned int best = 0;
+      int bestDistance = 256;
+      for (unsigned int p = 0; p < 8; p++) {
+        int distance = std::abs(alpha - (int)palette[p]);
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          best = p;
+        }
+      }
+      bits |= (uint64_t)best << (3 * i);
+    }
+  }
+  block[0] = (unsigned char)a0;
+  block[1] = (unsigned char)a1;
+  for (int i = 0; i < 6; i++) {
+    block[2 + i] = (unsigned char)(bits >> (8 * i));
+  }
+  encodeColorBlock(rgba, block + 8);
+}
+
+void decodeBC1Block(const unsigned char *block, unsigned char *rgba) {
+  decodeColorBlock(block, rgba);
+}
+
+void decodeBC3Block(const unsigned char *block, unsigned char *rgba) {
+  decodeColorBlock(block + 8, rgba);
+  unsigned int palette[8];
+  alphaPalette(block[0], block[1], palette);
+  uint64_t bits = 0;
+  for (int i = 0; i < 6; i++) {
+    bits |= (uint64_t)block[2 + i] << (8 * i);
+  }
+  for (int i = 0; i < 16; i++) {
+    rgba[4 * i + 3] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+  }
+}
@@ -0,0 +1,221 @@
+#include "texture/CookedTexture.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "stb_image.h"
+#include "texture/BlockCompression.hpp"
+#include "texture/MappedFile.hpp"
+
+namespace {
+size_t alignOffset(size_t offset) {
+  return (offset + COOKED_TEXTURE_ALIGNMENT - 1) &
+         ~(size_t)(COOKED_TEXTURE_ALIGNMENT - 1);
+}
+
+// 2x2 box filter, odd edges repeat their last row or column
+void downsample(const std::vector<unsigned char> &source, uint32_t width,
+                uint32_t height, std::vector<unsigned char> &out) {
+  const uint32_t outWidth = std::max(width / 2, 1u);
+  const uint32_t outHeight = std::max(height / 2, 1u);
+  out.resize((size_t)outWidth * outHeight * 4);
+  for (uint32_t y = 0; y < outHeight; y++) {
+    const uint32_t y0 = std::min(2 * y, height - 1);
+    const uint32_t y1 = std::min(2 * y + 1, height - 1);
+    for (uint32_t x = 0; x < outWidth; x++) {
+      const uint32_t x0 = std::min(2 * x, width - 1);
+      const uint32_t x1 = std::min(2 * x + 1, width - 1);
+      for (uint32_t c = 0; c < 4; c++) {
+        unsigned int sum = source[((size_t)y0 * width + x0) * 4 + c] +
+                           source[((size_t)y0 * width + x1) * 4 + c] +
+                           source[((size_t)y1 * width + x0) * 4 + c] +
+                           source[((size_t)y1 * width + x1) * 4 + c];
+        out[((size_t)y * outWidth + x) * 4 + c] =
+            (unsigned char)((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+void compressLevel(const std::vector<unsigned char> &pixels, uint32_t width,
+                   uint32_t height, TextureFormat format, unsigned char *out) {
+  if (format == TextureFormat::RGBA8) {
+    std::memcpy(out, pixels.data(), (size_t)width * height * 4);
+    return;
+  }
+  const size_t blockBytes =
+      format == TextureFormat::BC1 ? BC1_BLOCK_BYTES : BC3_BLOCK_BYTES;
+  unsigned char block[64];
+  for (uint32_t by = 0; by < height; by += 4) {
+    for (uint32_t bx = 0; bx < width; bx += 4) {
+      // blocks hanging over the edge repeat the edge pixels
+      for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+          const uint32_t sx = std::min(bx + x, width - 1);
+          const uint32_t sy = std::min(by + y, height - 1);
+          std::memcpy(block + (y * 4 + x) * 4,
+                      pixels.data() + ((size_t)sy * width + sx) * 4, 4);
+        }
+      }
+      if (format == TextureFormat::BC1) {
+        encodeBC1Block(block, out);
+      } else {
+        encodeBC3Block(block, out);
+      }
+      out += blockBytes;
+    }
+  }
+}
+} // namespace
+
+size_t textureLevelBytes(TextureFormat format, uint32_t width,
+                         uint32_t height) {
+  const size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+  switch (format) {
+  case TextureFormat::BC1:
+    return blocks * BC1_BLOCK_BYTES;
+  case TextureFormat::BC3:
+    return blocks * BC3_BLOCK_BYTES;
+  case TextureFormat::RGBA8:
+    break;
+  }
+  return (size_t)width * height * 4;
+}
+
+bool cookTexture(const std::string &sourcePath,
+                 const TextureCookOptions &options,
+                 std::vector<unsigned char> &out) {
+  std::error_code error;
+  const uint64_t sourceSize = std::filesystem::file_size(sourcePath, error);
+  const auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+  if (error) {
+    std::cout << "ERROR::TEXTURE::SOURCE_NOT_FOUND " << sourcePath
+              << std::endl;
+    return false;
+  }
+
+  stbi_set_flip_vertically_on_load_thread(options.flipVertically);
+  int width, height, components;
+  unsigned char *decoded =
+      stbi_load(sourcePath.c_str(), &width, &height, &components, 4);
+  if (!decoded) {
+    std::cout << "ERROR::TEXTURE::DECODE_FAILED " << sourcePath << std::endl;
+    return false;
+  }
+  std::vector<unsigned char> level(decoded,
+                                   decoded + (size_t)width * height * 4);
+  stbi_image_free(decoded);
+
+  bool hasAlpha = false;
+  for (size_t i = 0; i < level.size(); i += 4) {
+    if (components == 1) {
+      // single channel images sampled as (r, 0, 0, 1), like a GL_RED upload
+      level[i + 1] = 0;
+      level[i + 2] = 0;
+    }
+    hasAlpha |= level[i + 3] != 255;
+  }
+
+  CookedTextureHeader header;
+  header.magic = COOKED_TEXTURE_MAGIC;
+  header.version = COOKED_TEXTURE_VERSION;
+  header.format = !options.compress ? TextureFormat::RGBA8
+                  : hasAlpha        ? TextureFormat::BC3
+                                    : TextureFormat::BC1;
+  header.width = width;
+  header.height = height;
+  header.mipCount = 1;
+  while (header.mipCount < COOKED_TEXTURE_MAX_MIPS &&
+         ((uint32_t)width >> header.mipCount ||
+          (uint32_t)height >> header.mipCount)) {
+    header.mipCount++;
+  }
+  header.flipped = options.flipVertically;
+  header.reserved = 0;
+  header.sourceSize = sourceSize;
+  header.sourceTime = sourceTime.time_since_epoch().count();
+
+  CookedMip mips[COOKED_TEXTURE_MAX_MIPS];
+  size_t offset = sizeof(header) + header.mipCount * sizeof(CookedMip);
+  for (uint32_t i = 0; i < header.mipCount; i++) {
+    mips[i].width = std::max((uint32_t)width >> i, 1u);
+    mips[i].height = std::max((uint32_t)height >> i, 1u);
+    mips[i].offset = alignOffset(offset);
+    mips[i].size =
+        textureLevelBytes(header.format, mips[i].width, mips[i].height);
+    offset = mips[i].offset + mips[i].size;
+  }
+  out.assign(offset, 0);
+  std::memcpy(out.data(), &header, sizeof(header));
+  std::memcpy(out.data() + sizeof(header), mips,
+              header.mipCount * sizeof(CookedMip));
+
+  std::vector<unsigned char> next;
+  for (uint32_t i = 0; i < header.mipCount; i++) {
+    if (i > 0) {
+      downsample(level, mips[i - 1].width, mips[i - 1].height, next);
+      level.swap(next);
+    }
+    compressLevel(level, mips[i].width, mips[i].height, header.format,
+                  out.data() + mips[i].offset);
+  }
+  return true;
+}
+
+bool cookTextureFile(const std::string &sourcePath,
+                     const std::string &cookedPath,
+                     const TextureCookOptions &options) {
+  std::vector<unsigned char> cooked;
+  if (!cookTexture(sourcePath, options, cooked)) {
+    return false;
+  }
+  if (!writeFileAtomically(cookedPath, cooked.data(), cooked.size())) {
+    std::cout << "ERROR::TEXTURE::WRITE_FAILED " << cookedPath << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool CookedTextureView::parse(const unsigned char *data, size_t size) {
+  m_data = nullptr;
+  if (size < sizeof(CookedTextureHeader)) {
+    return false;
+  }
+  const CookedTextureHeader *header =
+      reinterpret_cast<const CookedTextureHeader *>(data);
+  if (header->magic != COOKED_TEXTURE_MAGIC ||
+      header->version != COOKED_TEXTURE_VERSION || header->mipCount == 0 ||
+      header->mipCount > COOKED_TEXTURE_MAX_MIPS ||
+      header->format > TextureFormat::BC3 ||
+      size < sizeof(CookedTextureHeader) +
+                 header->mipCount * sizeof(CookedMip)) {
+    return false;
+  }
+  const CookedMip *mips =
+      reinterpret_cast<const CookedMip *>(data + sizeof(CookedTextureHeader));
+  for (uint32_t i = 0; i < header->mipCount; i++) {
+    if (mips[i].offset > size || mips[i].size > size - mips[i].offset ||
+        mips[i].size !=
+            textureLevelBytes(header->format, mips[i].width, mips[i].height)) {
+      return false;
+    }
+  }
+  m_data = data;
+  m_header = header;
+  m_mips = mips;
+  return true;
+}
+
+const CookedTextureHeader &CookedTextureView::getHeader() const {
+  return *m_header;
+}
+
+const CookedMip &CookedTextureView::getMip(unsigned int level) const {
+  return m_mips[level];
+}
+
+const unsigned char *CookedTextureView::getMipData(unsigned int level) const {
+  return m_data + m_mips[level].offset;
+}
@@ -0,0 +1,66 @@
+#include "texture/MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file alive on its own
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  m_data = data;
+  m_size = info.st_size;
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) {
+    munmap(m_data, m_size);
+    m_data = nullptr;
+    m_size = 0;
+  }
+}
+
+const unsigned char *MappedFile::getData() const {
+  return static_cast<const unsigned char *>(m_data);
+}
+
+size_t MappedFile::getSize() const { return m_size; }
+
+bool writeFileAtomically(const std::string &path, const void *data,
+                         size_t size) {
+  std::error_code error;
+  const std::filesystem::path target(path);
+  if (target.has_parent_path()) {
+    std::filesystem::create_directories(target.parent_path(), error);
+  }
+  const std::string temporaryPath = path + ".tmp";
+  {
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    file.write(static_cast<const char *>(data), size);
+    if (!file) {
+      return false;
+    }
+  }
+  std::filesystem::rename(temporaryPath, path, error);
+  return !error;
+}
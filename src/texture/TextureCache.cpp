@@ -0,0 +1,196 @@
+#include "texture/TextureCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "ProjectRoot.hpp"
+#include "profiling/Profiler.hpp"
+#include "texture/BlockCompression.hpp"
+#include "texture/MappedFile.hpp"
+
+// EXT_texture_compression_s3tc, not in the core profile headers
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+bool supportsS3tc() {
+  static const bool supported = [] {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+      const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+      if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+        return true;
+      }
+    }
+    return false;
+  }();
+  return supported;
+}
+
+// expands a compressed level to RGBA8 for drivers without S3TC
+void decodeLevel(TextureFormat format, const CookedMip &mip,
+                 const unsigned char *data, std::vector<unsigned char> &out) {
+  out.resize((size_t)mip.width * mip.height * 4);
+  const size_t blockBytes =
+      format == TextureFormat::BC1 ? BC1_BLOCK_BYTES : BC3_BLOCK_BYTES;
+  unsigned char block[64];
+  for (uint32_t by = 0; by < mip.height; by += 4) {
+    for (uint32_t bx = 0; bx < mip.width; bx += 4) {
+      if (format == TextureFormat::BC1) {
+        decodeBC1Block(data, block);
+      } else {
+        decodeBC3Block(data, block);
+      }
+      data += blockBytes;
+      for (uint32_t y = 0; y < 4 && by + y < mip.height; y++) {
+        for (uint32_t x = 0; x < 4 && bx + x < mip.width; x++) {
+          std::memcpy(&out[((size_t)(by + y) * mip.width + bx + x) * 4],
+                      block + (y * 4 + x) * 4, 4);
+        }
+      }
+    }
+  }
+}
+
+unsigned int upload(const CookedTextureView &texture,
+                    const TextureLoadOptions &options) {
+  const CookedTextureHeader &header = texture.getHeader();
+  const bool compressed = header.format != TextureFormat::RGBA8;
+  const bool direct = !compressed || supportsS3tc();
+  const GLenum compressedFormat = header.format == TextureFormat::BC1
+                                      ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                                      : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+  unsigned int textureID;
+  glGenTextures(1, &textureID);
+  glBindTexture(GL_TEXTURE_2D, textureID);
+  std::vector<unsigned char> decoded;
+  for (uint32_t level = 0; level < header.mipCount; level++) {
+    const CookedMip &mip = texture.getMip(level);
+    const unsigned char *data = texture.getMipData(level);
+    if (compressed && direct) {
+      glCompressedTexImage2D(GL_TEXTURE_2D, level, compressedFormat, mip.width,
+                             mip.height, 0, mip.size, data);
+      continue;
+    }
+    if (compressed) {
+      decodeLevel(header.format, mip, data, decoded);
+      data = decoded.data();
+    }
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, mip.width, mip.height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, data);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.mipCount - 1);
+
+  const bool clamp =
+      options.clampWithAlpha && header.format == TextureFormat::BC3;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+                  clamp ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+                  clamp ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  return textureID;
+}
+} // namespace
+
+TextureCache::TextureCache(const std::string &directory)
+    : m_directory(directory) {}
+
+unsigned int TextureCache::load(const std::string &sourcePath,
+                                const TextureLoadOptions &options) {
+  PROFILE_SCOPE("texture.load");
+  const std::string cookedPath = getCookedPath(sourcePath);
+  MappedFile file;
+  CookedTextureView texture;
+  if (!file.open(cookedPath) ||
+      !texture.parse(file.getData(), file.getSize()) ||
+      !matchesSource(texture.getHeader(), sourcePath, options.cook)) {
+    file.close();
+    PROFILE_SCOPE("texture.cook");
+    if (!cookTextureFile(sourcePath, cookedPath, options.cook)) {
+      return 0;
+    }
+    if (!file.open(cookedPath) ||
+        !texture.parse(file.getData(), file.getSize())) {
+      std::cout << "ERROR::TEXTURE::COOKED_FILE_INVALID " << cookedPath
+                << std::endl;
+      return 0;
+    }
+  }
+  return upload(texture, options);
+}
+
+bool TextureCache::cook(const std::string &sourcePath,
+                        const TextureCookOptions &options) {
+  if (isFresh(sourcePath, options)) {
+    return true;
+  }
+  return cookTextureFile(sourcePath, getCookedPath(sourcePath), options);
+}
+
+std::string TextureCache::getCookedPath(const std::string &sourcePath) const {
+  // The path below the project root, flattened into one file name. Both are
+  // canonical first, so relative and absolute spellings of a source share a
+  // cooked file.
+  std::error_code error;
+  std::string name =
+      std::filesystem::weakly_canonical(sourcePath, error).string();
+  if (error) {
+    name = sourcePath;
+  }
+  std::string root =
+      std::filesystem::weakly_canonical(ProjectRoot::getPath(), error)
+          .string();
+  if (error) {
+    root = ProjectRoot::getPath();
+  }
+  if (name.compare(0, root.size(), root) == 0) {
+    name = name.substr(root.size());
+  }
+  for (char &c : name) {
+    if (c == '/' || c == '\\' || c == ':') {
+      c = '_';
+    }
+  }
+  return m_directory + "/" + name + ".ptex";
+}
+
+bool TextureCache::isFresh(const std::string &sourcePath,
+                           const TextureCookOptions &options) const {
+  MappedFile file;
+  CookedTextureView texture;
+  return file.open(getCookedPath(sourcePath)) &&
+         texture.parse(file.getData(), file.getSize()) &&
+         matchesSource(texture.getHeader(), sourcePath, options);
+}
+
+bool TextureCache::matchesSource(const CookedTextureHeader &header,
+                                 const std::string &sourcePath,
+                                 const TextureCookOptions &options) const {
+  std::error_code error;
+  const uint64_t sourceSize = std::filesystem::file_size(sourcePath, error);
+  const auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+  if (error) {
+    return false;
+  }
+  return header.sourceSize == sourceSize &&
+         header.sourceTime == sourceTime.time_since_epoch().count() &&
+         (bool)header.flipped == options.flipVertically &&
+         (header.format != TextureFormat::RGBA8) == options.compress;
+}
+
+TextureCache &TextureCache::getDefault() {
+  static TextureCache cache(ProjectRoot::getPath(TEXTURE_CACHE_DIRECTORY));
+  return cache;
+}